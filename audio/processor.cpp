@@ -3,11 +3,93 @@
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
+#include <tensorflow/core/framework/allocation_description.pb.h>
 #include <tensorflow/core/framework/tensor.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
 namespace glooms {
 namespace vision {
 
+namespace {
+    // Tensor storage borrowed from a cv::Mat. The buffer holds a reference
+    // to the Mat, so the pixels outlive whichever of the two goes first.
+    class MatTensorBuffer : public tensorflow::TensorBuffer {
+    public:
+        explicit MatTensorBuffer(const cv::Mat& mat)
+            : tensorflow::TensorBuffer(mat.data)
+            , mat_(mat) {}
+
+        size_t size() const override { return mat_.total() * mat_.elemSize(); }
+        TensorBuffer* root_buffer() override { return this; }
+        void FillAllocationDescription(tensorflow::AllocationDescription* proto) const override {
+            proto->set_requested_bytes(static_cast<int64_t>(size()));
+            proto->set_allocator_name("cv::Mat");
+        }
+        bool OwnsMemory() const override { return false; }
+
+    private:
+        cv::Mat mat_;
+    };
+
+    // Eigen kernels assume tensor data is aligned; cv::Mat allocations are,
+    // but ROIs and external buffers may not be
+    bool isTensorAligned(const void* data) {
+        return reinterpret_cast<uintptr_t>(data) % std::max(1, EIGEN_MAX_ALIGN_BYTES) == 0;
+    }
+
+    // A [1, rows, cols, channels] float tensor over a continuous CV_32F Mat
+    tensorflow::Tensor wrapMat(const cv::Mat& mat) {
+        tensorflow::TensorShape shape({1, mat.rows, mat.cols, mat.channels()});
+        auto* buffer = new MatTensorBuffer(mat);
+        tensorflow::Tensor tensor(tensorflow::DT_FLOAT, shape, buffer);
+        buffer->Unref();    // The tensor holds its own reference
+        return tensor;
+    }
+
+    // Input tensors recycled across frames. Tensor copies share their
+    // buffer, so a pooled tensor is free again once every copy handed out
+    // (e.g. in a ProcessingResult) has been dropped.
+    class TensorPool {
+    public:
+        static constexpr size_t MAX_TENSORS = 4;
+
+        tensorflow::Tensor acquire(const tensorflow::TensorShape& shape) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& tensor : tensors_) {
+                if (tensor.shape().IsSameSize(shape) && tensor.RefCountIsOne()) {
+                    return tensor;
+                }
+            }
+
+            // Make room by dropping a free tensor of another shape; with
+            // every slot in use the caller gets an unpooled tensor
+            if (tensors_.size() >= MAX_TENSORS) {
+                auto free = std::find_if(tensors_.begin(), tensors_.end(),
+                    [](const tensorflow::Tensor& tensor) { return tensor.RefCountIsOne(); });
+                if (free == tensors_.end()) {
+                    return tensorflow::Tensor(tensorflow::DT_FLOAT, shape);
+                }
+                tensors_.erase(free);
+            }
+            tensors_.emplace_back(tensorflow::DT_FLOAT, shape);
+            return tensors_.back();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<tensorflow::Tensor> tensors_;
+    };
+
+    TensorPool& inputTensorPool() {
+        static TensorPool pool;
+        return pool;
+    }
+}
+
 Processor::Processor(const ProcessorConfig& config)
     : config_(config)
     , logger_("VisionProcessor")
@@ -183,30 +265,22 @@ void Processor::enhanceContrast(cv::Mat& frame) {
 
 bool Processor::prepareInputTensor(const cv::Mat& frame, tensorflow::Tensor& tensor) {
     try {
-        // Create tensor of shape {1, height, width, channels}
-        tensorflow::TensorShape shape({1, 
-            config_.target_height, 
-            config_.target_width, 
-            frame.channels()
-        });
-        
-        tensor = tensorflow::Tensor(tensorflow::DT_FLOAT, shape);
-        
-        // Copy data from cv::Mat to tensor
-        auto tensor_mapped = tensor.tensor<float, 4>();
-        const float* frame_data = (float*)frame.data;
-        
-        for (int y = 0; y < frame.rows; ++y) {
-            for (int x = 0; x < frame.cols; ++x) {
-                for (int c = 0; c < frame.channels(); ++c) {
-                    tensor_mapped(0, y, x, c) = frame_data[
-                        y * frame.cols * frame.channels() + 
-                        x * frame.channels() + c
-                    ];
-                }
-            }
+        CV_Assert(frame.depth() == CV_32F);
+
+        // NHWC matches the Mat's own layout: hand the tensor the frame's
+        // buffer instead of copying it
+        if (frame.isContinuous() && isTensorAligned(frame.data)) {
+            tensor = wrapMat(frame);
+            return true;
         }
-        
+
+        tensor = inputTensorPool().acquire(
+            tensorflow::TensorShape({1, frame.rows, frame.cols, frame.channels()}));
+
+        // Write into the tensor's buffer through a Mat header
+        cv::Mat view(frame.rows, frame.cols, frame.type(), tensor.flat<float>().data());
+        frame.copyTo(view);
+
         return true;
 
     } catch (const std::exception& e) {
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Writes tiny_detector.onnx, the model bundled with the vision benchmark.
+
+The network is a two-layer convolutional detector with YOLO-style output
+rows [cx, cy, w, h, objectness, class scores...] flattened to a 2D tensor,
+which is the layout Detector::processDetections decodes. Weights come from
+a fixed LCG, so the file is reproducible. Only the standard library is
+used: the protobuf wire format is encoded by hand.
+
+Usage: python3 make_tiny_detector.py [output.onnx]
+"""
+
+import struct
+import sys
+
+NUM_CLASSES = 3
+CHANNELS = 8
+OUTPUTS = 5 + NUM_CLASSES
+
+
+# Protobuf wire format
+def varint(value):
+    if value < 0:
+        value += 1 << 64
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def key(field, wire_type):
+    return varint((field << 3) | wire_type)
+
+
+def int_field(field, value):
+    return key(field, 0) + varint(value)
+
+
+def bytes_field(field, payload):
+    if isinstance(payload, str):
+        payload = payload.encode()
+    return key(field, 2) + varint(len(payload)) + payload
+
+
+# ONNX messages
+FLOAT = 1
+INT64 = 7
+ATTR_INT = 2
+ATTR_INTS = 7
+
+
+def tensor(name, dims, values, data_type=FLOAT):
+    out = b"".join(int_field(1, d) for d in dims)
+    out += int_field(2, data_type)
+    out += bytes_field(8, name)
+    fmt = "<%d%s" % (len(values), "f" if data_type == FLOAT else "q")
+    out += bytes_field(9, struct.pack(fmt, *values))
+    return out
+
+
+def attribute_ints(name, values):
+    return (bytes_field(1, name) + b"".join(int_field(8, v) for v in values)
+            + int_field(20, ATTR_INTS))
+
+
+def node(op_type, inputs, outputs, name, attributes=()):
+    out = b"".join(bytes_field(1, i) for i in inputs)
+    out += b"".join(bytes_field(2, o) for o in outputs)
+    out += bytes_field(3, name) + bytes_field(4, op_type)
+    out += b"".join(bytes_field(5, a) for a in attributes)
+    return out
+
+
+def value_info(name, dims):
+    shape = b""
+    for dim in dims:
+        if isinstance(dim, str):
+            shape += bytes_field(1, bytes_field(2, dim))
+        else:
+            shape += bytes_field(1, int_field(1, dim))
+    tensor_type = int_field(1, FLOAT) + bytes_field(2, shape)
+    return bytes_field(1, name) + bytes_field(2, bytes_field(1, tensor_type))
+
+
+# Deterministic weights
+class Lcg:
+    def __init__(self, seed):
+        self.state = seed
+
+    def uniform(self, scale):
+        self.state = (self.state * 6364136223846793005 + 1442695040888963407) % (1 << 64)
+        return ((self.state >> 40) / float(1 << 24) * 2.0 - 1.0) * scale
+
+
+def build():
+    rng = Lcg(2024)
+
+    # conv1: 3x3 stride 2. Channel 0 is a brightness detector that fires
+    # on the bright synthetic shapes and stays off on the darker noise.
+    w1, b1 = [], []
+    for out_channel in range(CHANNELS):
+        for _ in range(3 * 3 * 3):
+            w1.append(1.0 / 27.0 if out_channel == 0 else rng.uniform(0.1))
+        b1.append(-0.6 if out_channel == 0 else rng.uniform(0.05))
+
+    # conv2: 3x3 stride 2. Objectness and class 0 both follow the
+    # brightness channel, so class scores never exceed objectness (the
+    # Darknet convention); other scores stay low, so detections cluster
+    # on the shapes.
+    w2, b2 = [], []
+    for out_channel in range(OUTPUTS):
+        for in_channel in range(CHANNELS):
+            for _ in range(3 * 3):
+                if out_channel in (4, 5):
+                    w2.append(10.0 / 9.0 if in_channel == 0 else 0.0)
+                else:
+                    w2.append(rng.uniform(0.05))
+        b2.append(-2.0 if out_channel >= 4 else 0.0)
+
+    initializers = [
+        tensor("conv1.weight", [CHANNELS, 3, 3, 3], w1),
+        tensor("conv1.bias", [CHANNELS], b1),
+        tensor("conv2.weight", [OUTPUTS, CHANNELS, 3, 3], w2),
+        tensor("conv2.bias", [OUTPUTS], b2),
+        tensor("rows.shape", [2], [-1, OUTPUTS], INT64),
+    ]
+
+    conv_attributes = [
+        attribute_ints("kernel_shape", [3, 3]),
+        attribute_ints("strides", [2, 2]),
+        attribute_ints("pads", [1, 1, 1, 1]),
+    ]
+    nodes = [
+        node("Conv", ["images", "conv1.weight", "conv1.bias"], ["conv1"], "conv1", conv_attributes),
+        node("Relu", ["conv1"], ["relu1"], "relu1"),
+        node("Conv", ["relu1", "conv2.weight", "conv2.bias"], ["conv2"], "conv2", conv_attributes),
+        node("Sigmoid", ["conv2"], ["scores"], "scores"),
+        node("Transpose", ["scores"], ["cells"], "cells", [attribute_ints("perm", [0, 2, 3, 1])]),
+        node("Reshape", ["cells", "rows.shape"], ["detections"], "detections"),
+    ]
+
+    graph = b"".join(bytes_field(1, n) for n in nodes)
+    graph += bytes_field(2, "tiny_detector")
+    graph += b"".join(bytes_field(5, t) for t in initializers)
+    graph += bytes_field(11, value_info("images", ["batch", 3, "height", "width"]))
+    graph += bytes_field(12, value_info("detections", ["rows", OUTPUTS]))
+
+    model = int_field(1, 7)                                  # IR version
+    model += bytes_field(2, "gloom-benchmark")
+    model += bytes_field(7, graph)
+    model += bytes_field(8, bytes_field(1, "") + int_field(2, 11))  # opset 11
+    return model
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "tiny_detector.onnx"
+    with open(path, "wb") as out:
+        out.write(build())
+
+
+if __name__ == "__main__":
+    main()
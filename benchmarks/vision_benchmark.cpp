@@ -0,0 +1,428 @@
+#include "vision/detector.hpp"
+#include "vision/detector_pool.hpp"
+#include "vision/processor.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput benchmark for the vision pipeline. Runs VisionProcessor and
+// Detector over deterministic synthetic frames with one stage enabled at
+// a time and writes the results as JSON:
+//   gloom_vision_benchmark [--output results.json] [--frames N] [--model tiny_detector.onnx]
+
+#ifndef GLOOM_BENCHMARK_MODEL_DIR
+#define GLOOM_BENCHMARK_MODEL_DIR "benchmarks/models"
+#endif
+
+// Heap allocation counter, covering everything operator new serves
+static std::atomic<uint64_t> g_heap_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+using namespace glooms::vision;
+using Clock = std::chrono::steady_clock;
+
+// Counts cv::Mat buffer allocations (which bypass operator new)
+class CountingAllocator : public cv::MatAllocator {
+public:
+    CountingAllocator() : delegate_(cv::Mat::getStdAllocator()) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                           size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage) const override {
+        if (!data) {
+            count_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return delegate_->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags,
+                  cv::UMatUsageFlags usage) const override {
+        return delegate_->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        delegate_->deallocate(data);
+    }
+
+    uint64_t count() const { return count_.load(); }
+
+private:
+    cv::MatAllocator* delegate_;
+    mutable std::atomic<uint64_t> count_{0};
+};
+
+struct Options {
+    std::string output = "vision_benchmark.json";
+    std::string model = std::string(GLOOM_BENCHMARK_MODEL_DIR) + "/tiny_detector.onnx";
+    int frames = 100;
+    int warmup = 10;
+};
+
+struct Result {
+    std::string scenario;
+    cv::Size resolution;
+    int frames = 0;
+    double fps = 0.0;
+    double frame_us = 0.0;
+    double preprocess_us = 0.0;
+    double vision_pipeline_us = 0.0;
+    double inference_us = 0.0;
+    double heap_allocations_per_frame = 0.0;
+    double mat_allocations_per_frame = 0.0;
+    bool success = true;
+};
+
+// Deterministic synthetic video: a fixed noise background with bright
+// shapes moving across it. Frame i is the same on every run and build.
+class SyntheticSource {
+public:
+    explicit SyntheticSource(cv::Size size)
+        : size_(size)
+        , background_(size, CV_8UC3) {
+        cv::RNG rng(0x5eed);
+        rng.fill(background_, cv::RNG::NORMAL, cv::Scalar::all(70), cv::Scalar::all(20));
+        cv::GaussianBlur(background_, background_, cv::Size(5, 5), 0);
+    }
+
+    void render(int index, cv::Mat& frame) const {
+        background_.copyTo(frame);
+
+        const int w = size_.width;
+        const int h = size_.height;
+        const int unit = std::max(8, std::min(w, h) / 12);
+
+        // Circle sweeping horizontally, rectangle bouncing diagonally,
+        // triangle orbiting the centre
+        int cx = (index * w / 60) % (w + 2 * unit) - unit;
+        cv::circle(frame, cv::Point(cx, h / 3), unit, cv::Scalar(40, 200, 240), cv::FILLED);
+
+        int period_x = 2 * (w - 2 * unit);
+        int period_y = 2 * (h - 2 * unit);
+        int px = (index * 7) % period_x;
+        int py = (index * 5) % period_y;
+        px = px < period_x / 2 ? px : period_x - px;
+        py = py < period_y / 2 ? py : period_y - py;
+        cv::rectangle(frame, cv::Rect(px, py, 2 * unit, unit), cv::Scalar(230, 230, 230), cv::FILLED);
+
+        double angle = index * 0.05;
+        cv::Point centre(w / 2 + static_cast<int>(std::cos(angle) * w / 4),
+                         h / 2 + static_cast<int>(std::sin(angle) * h / 4));
+        std::vector<cv::Point> triangle = {
+            centre + cv::Point(0, -unit),
+            centre + cv::Point(-unit, unit),
+            centre + cv::Point(unit, unit)
+        };
+        cv::fillConvexPoly(frame, triangle, cv::Scalar(60, 240, 60));
+    }
+
+    cv::Size size() const { return size_; }
+
+private:
+    cv::Size size_;
+    cv::Mat background_;
+};
+
+// Renders every frame up front so generation stays out of the timings
+std::vector<cv::Mat> renderFrames(const SyntheticSource& source, int count) {
+    std::vector<cv::Mat> frames(count);
+    for (int i = 0; i < count; ++i) {
+        source.render(i, frames[i]);
+    }
+    return frames;
+}
+
+// Times `step` over every frame after a warmup, counting allocations
+Result measure(const std::string& scenario, const std::vector<cv::Mat>& frames,
+               int warmup, CountingAllocator& mat_allocator,
+               const std::function<bool(const cv::Mat&)>& step) {
+    Result result;
+    result.scenario = scenario;
+    result.resolution = frames.front().size();
+
+    for (int i = 0; i < warmup; ++i) {
+        result.success &= step(frames[i % frames.size()]);
+    }
+
+    uint64_t heap_before = g_heap_allocations.load();
+    uint64_t mat_before = mat_allocator.count();
+    auto start = Clock::now();
+    for (const auto& frame : frames) {
+        result.success &= step(frame);
+    }
+    double elapsed_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    result.frames = static_cast<int>(frames.size());
+    result.frame_us = elapsed_us / result.frames;
+    result.fps = elapsed_us > 0.0 ? result.frames * 1e6 / elapsed_us : 0.0;
+    result.heap_allocations_per_frame =
+        static_cast<double>(g_heap_allocations.load() - heap_before) / result.frames;
+    result.mat_allocations_per_frame =
+        static_cast<double>(mat_allocator.count() - mat_before) / result.frames;
+    return result;
+}
+
+ProcessorConfig baseProcessorConfig(cv::Size size) {
+    ProcessorConfig config;
+    config.frame_width = size.width;
+    config.frame_height = size.height;
+    config.use_gpu = false;
+    config.processing_mode = ProcessingMode::QUALITY;  // No adaptive degradation
+    config.enable_threading = false;
+    config.color_lower_bound = cv::Scalar(20, 100, 100);
+    config.color_upper_bound = cv::Scalar(40, 255, 255);
+    return config;
+}
+
+Result runProcessor(const std::string& scenario, const ProcessorConfig& config,
+                    const std::vector<cv::Mat>& frames, int warmup,
+                    CountingAllocator& mat_allocator) {
+    VisionProcessor processor(config);
+    if (!processor.isInitialized()) {
+        Result result;
+        result.scenario = scenario;
+        result.resolution = frames.front().size();
+        result.success = false;
+        return result;
+    }
+
+    Result result = measure(scenario, frames, warmup, mat_allocator, [&](const cv::Mat& frame) {
+        return processor.processFrame(frame).success;
+    });
+
+    // Stage averages include the warmup frames, which is negligible at
+    // the default frame counts
+    auto metrics = processor.getMetrics();
+    result.preprocess_us = metrics.preprocess.average_us;
+    result.vision_pipeline_us = metrics.vision_pipeline.average_us;
+    result.inference_us = metrics.inference.average_us;
+    return result;
+}
+
+Result runDetector(const std::string& scenario, const DetectorConfig& config,
+                   const std::vector<cv::Mat>& frames, int warmup,
+                   CountingAllocator& mat_allocator) {
+    Detector detector(config);
+    if (!detector.isInitialized()) {
+        Result result;
+        result.scenario = scenario;
+        result.resolution = frames.front().size();
+        result.success = false;
+        return result;
+    }
+
+    Result result = measure(scenario, frames, warmup, mat_allocator, [&](const cv::Mat& frame) {
+        return detector.detect(frame).success;
+    });
+    result.inference_us = result.frame_us;
+    return result;
+}
+
+// Same frames through a DetectorPool from one caller thread per instance
+Result runDetectorPool(const std::string& scenario, const DetectorConfig& config,
+                       const std::vector<cv::Mat>& frames, int warmup,
+                       CountingAllocator& mat_allocator) {
+    DetectorPoolConfig pool_config;
+    pool_config.detector = config;
+    DetectorPool pool(pool_config);
+
+    Result result;
+    result.scenario = scenario;
+    result.resolution = frames.front().size();
+    if (!pool.isInitialized()) {
+        result.success = false;
+        return result;
+    }
+
+    for (int i = 0; i < warmup; ++i) {
+        result.success &= pool.detect(frames[i % frames.size()]).success;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> success{true};
+    uint64_t heap_before = g_heap_allocations.load();
+    uint64_t mat_before = mat_allocator.count();
+    auto start = Clock::now();
+
+    std::vector<std::thread> callers;
+    for (size_t t = 0; t < pool.size(); ++t) {
+        callers.emplace_back([&] {
+            for (size_t i = next++; i < frames.size(); i = next++) {
+                if (!pool.detect(frames[i]).success) {
+                    success = false;
+                }
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    double elapsed_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    result.success &= success.load();
+    result.frames = static_cast<int>(frames.size());
+    result.frame_us = elapsed_us / result.frames;
+    result.fps = elapsed_us > 0.0 ? result.frames * 1e6 / elapsed_us : 0.0;
+    result.inference_us = result.frame_us;
+    result.heap_allocations_per_frame =
+        static_cast<double>(g_heap_allocations.load() - heap_before) / result.frames;
+    result.mat_allocations_per_frame =
+        static_cast<double>(mat_allocator.count() - mat_before) / result.frames;
+    return result;
+}
+
+std::vector<Result> runResolution(cv::Size size, const Options& options,
+                                  CountingAllocator& mat_allocator) {
+    SyntheticSource source(size);
+    auto frames = renderFrames(source, options.frames);
+    std::vector<Result> results;
+
+    auto run = [&](const std::string& scenario, const std::function<void(ProcessorConfig&)>& enable) {
+        ProcessorConfig config = baseProcessorConfig(size);
+        enable(config);
+        results.push_back(runProcessor(scenario, config, frames, options.warmup, mat_allocator));
+    };
+
+    run("preprocess", [](ProcessorConfig&) {});
+    run("edges", [](ProcessorConfig& c) { c.enable_edge_detection = true; });
+    run("contours", [](ProcessorConfig& c) { c.enable_contour_detection = true; });
+    run("segmentation", [](ProcessorConfig& c) { c.enable_color_segmentation = true; });
+    run("motion", [](ProcessorConfig& c) { c.enable_motion_detection = true; });
+    run("inference", [&](ProcessorConfig& c) { c.model_path = options.model; });
+    run("all", [&](ProcessorConfig& c) {
+        c.enable_edge_detection = true;
+        c.enable_contour_detection = true;
+        c.enable_color_segmentation = true;
+        c.enable_motion_detection = true;
+        c.model_path = options.model;
+    });
+
+    DetectorConfig detector_config;
+    detector_config.model_weights = options.model;
+    detector_config.classes_file = std::string(GLOOM_BENCHMARK_MODEL_DIR) + "/tiny_detector.names";
+    detector_config.use_gpu = false;
+    detector_config.confidence_threshold = 0.3f;
+    results.push_back(runDetector("detector", detector_config, frames, options.warmup, mat_allocator));
+    results.push_back(runDetectorPool("detector_pool", detector_config, frames, options.warmup, mat_allocator));
+
+    detector_config.enable_tiling = true;
+    results.push_back(runDetector("detector_tiled", detector_config, frames, options.warmup, mat_allocator));
+
+    return results;
+}
+
+void writeJson(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+    char buffer[512];
+    out << "{\n";
+    out << "  \"opencv_version\": \"" << CV_VERSION << "\",\n";
+    out << "  \"threads\": " << cv::getNumThreads() << ",\n";
+    out << "  \"frames\": " << options.frames << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::snprintf(buffer, sizeof(buffer),
+            "    {\"scenario\": \"%s\", \"width\": %d, \"height\": %d, \"success\": %s, "
+            "\"fps\": %.2f, \"frame_us\": %.1f, \"preprocess_us\": %.1f, "
+            "\"vision_pipeline_us\": %.1f, \"inference_us\": %.1f, "
+            "\"heap_allocations_per_frame\": %.2f, \"mat_allocations_per_frame\": %.2f}%s\n",
+            r.scenario.c_str(), r.resolution.width, r.resolution.height,
+            r.success ? "true" : "false", r.fps, r.frame_us, r.preprocess_us,
+            r.vision_pipeline_us, r.inference_us, r.heap_allocations_per_frame,
+            r.mat_allocations_per_frame, i + 1 < results.size() ? "," : "");
+        out << buffer;
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        if (arg == "--output") {
+            options.output = argv[++i];
+        } else if (arg == "--frames") {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--model") {
+            options.model = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    options.warmup = std::min(options.warmup, options.frames);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--output results.json] [--frames N] [--model model.onnx]\n";
+        return 2;
+    }
+
+    CountingAllocator mat_allocator;
+    cv::Mat::setDefaultAllocator(&mat_allocator);
+
+    const std::vector<cv::Size> resolutions = {
+        cv::Size(640, 360),
+        cv::Size(1280, 720),
+        cv::Size(1920, 1080)
+    };
+
+    std::vector<Result> results;
+    for (const auto& size : resolutions) {
+        auto batch = runResolution(size, options, mat_allocator);
+        for (const auto& r : batch) {
+            std::cout << r.resolution.width << "x" << r.resolution.height << " "
+                      << r.scenario << ": " << r.fps << " fps"
+                      << (r.success ? "" : " (failed)") << "\n";
+        }
+        results.insert(results.end(), batch.begin(), batch.end());
+    }
+
+    cv::Mat::setDefaultAllocator(nullptr);
+
+    std::ofstream out(options.output);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open output file: " << options.output << "\n";
+        return 1;
+    }
+    writeJson(out, options, results);
+    std::cout << "Wrote " << options.output << "\n";
+    return 0;
+}
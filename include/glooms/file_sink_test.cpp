@@ -0,0 +1,213 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/file_sink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace glooms::utils;
+
+namespace {
+    // Fresh directory per test, removed afterwards
+    class TempDirectory {
+    public:
+        explicit TempDirectory(const std::string& name)
+            : path_(std::filesystem::temp_directory_path() / name) {
+            std::filesystem::remove_all(path_);
+            std::filesystem::create_directories(path_);
+        }
+
+        ~TempDirectory() {
+            std::filesystem::remove_all(path_);
+        }
+
+        std::string path() const { return path_.string(); }
+
+        std::vector<std::filesystem::path> segments() const {
+            std::vector<std::filesystem::path> files;
+            for (const auto& entry : std::filesystem::directory_iterator(path_)) {
+                files.push_back(entry.path());
+            }
+            return files;
+        }
+
+        // Every segment's contents, NUL padding stripped
+        std::string contents() const {
+            std::string all;
+            for (const auto& file : segments()) {
+                std::ifstream input(file, std::ios::binary);
+                std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+                all += data.substr(0, data.find('\0'));
+            }
+            return all;
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    std::string line(int i) {
+        std::ostringstream text;
+        text << "line " << i << " " << std::string(90, 'x') << "\n";
+        return text.str();
+    }
+}
+
+TEST_CASE("File sink rotation", "[logger][file_sink]") {
+    for (auto mode : {FileSinkMode::MAPPED, FileSinkMode::BATCHED}) {
+        DYNAMIC_SECTION("Size rotation, mode " << static_cast<int>(mode)) {
+            TempDirectory directory("gloom_file_sink_size");
+            FileSinkConfig config;
+            config.directory = directory.path();
+            config.segment_size = 4096;
+            config.max_segments = 0;
+            config.mode = mode;
+            config.batch_size = 4096;
+
+            {
+                FileSinkStream sink(config);
+                REQUIRE(sink.good());
+                for (int i = 0; i < 200; ++i) {
+                    sink << line(i) << std::flush;
+                }
+                // 200 lines of 100 bytes need at least five 4 KiB segments
+                REQUIRE(sink.buffer().rotationCount() >= 4);
+            }
+
+            auto segments = directory.segments();
+            REQUIRE(segments.size() >= 5);
+            for (const auto& segment : segments) {
+                REQUIRE(std::filesystem::file_size(segment) <= 4096);
+            }
+
+            // Every line survives, none split across segments
+            std::string contents = directory.contents();
+            for (int i = 0; i < 200; ++i) {
+                REQUIRE(contents.find(line(i)) != std::string::npos);
+            }
+        }
+    }
+
+    SECTION("Age rotation") {
+        TempDirectory directory("gloom_file_sink_age");
+        FileSinkConfig config;
+        config.directory = directory.path();
+        config.max_segment_age = std::chrono::seconds(1);
+
+        FileSinkStream sink(config);
+        sink << line(0) << std::flush;
+        REQUIRE(sink.buffer().rotationCount() == 0);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        sink << line(1) << std::flush;
+        REQUIRE(sink.buffer().rotationCount() == 1);
+        REQUIRE(directory.segments().size() == 2);
+    }
+
+    SECTION("Old segments are pruned") {
+        TempDirectory directory("gloom_file_sink_prune");
+        FileSinkConfig config;
+        config.directory = directory.path();
+        config.segment_size = 4096;
+        config.max_segments = 3;
+
+        {
+            FileSinkStream sink(config);
+            for (int i = 0; i < 300; ++i) {
+                sink << line(i) << std::flush;
+            }
+            REQUIRE(sink.buffer().rotationCount() > 3);
+        }
+
+        REQUIRE(directory.segments().size() == 3);
+        // The newest lines are the ones kept
+        std::string contents = directory.contents();
+        REQUIRE(contents.find(line(299)) != std::string::npos);
+        REQUIRE(contents.find(line(0)) == std::string::npos);
+    }
+}
+
+TEST_CASE("File sink durability", "[logger][file_sink]") {
+    SECTION("Batched lines are written after flush_interval") {
+        TempDirectory directory("gloom_file_sink_flush");
+        FileSinkConfig config;
+        config.directory = directory.path();
+        config.mode = FileSinkMode::BATCHED;
+        config.flush_interval = std::chrono::milliseconds(50);
+
+        FileSinkStream sink(config);
+        sink << line(0) << std::flush;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        // Still open, so this is what tail -f would see
+        REQUIRE(directory.contents().find(line(0)) != std::string::npos);
+    }
+
+    SECTION("Character writes race-free against the flush thread") {
+        TempDirectory directory("gloom_file_sink_sputc");
+        FileSinkConfig config;
+        config.directory = directory.path();
+        config.mode = FileSinkMode::BATCHED;
+        config.flush_interval = std::chrono::milliseconds(1);
+
+        {
+            // Number formatting, ostreambuf_iterator and std::endl all
+            // write through sputc()
+            FileSinkStream sink(config);
+            const std::string suffix = " x";
+            for (int i = 0; i < 20000; ++i) {
+                sink << i;
+                std::copy(suffix.begin(), suffix.end(), std::ostreambuf_iterator<char>(sink));
+                sink << std::endl;
+            }
+        }
+
+        std::istringstream contents(directory.contents());
+        std::string expected_line;
+        std::string actual_line;
+        for (int i = 0; i < 20000; ++i) {
+            REQUIRE(std::getline(contents, actual_line));
+            expected_line = std::to_string(i) + " x";
+            REQUIRE(actual_line == expected_line);
+        }
+        REQUIRE_FALSE(std::getline(contents, actual_line));
+    }
+
+    SECTION("Mapped segments survive a killed process") {
+        TempDirectory directory("gloom_file_sink_crash");
+        FileSinkConfig config;
+        config.directory = directory.path();
+        config.mode = FileSinkMode::MAPPED;
+
+        pid_t child = ::fork();
+        REQUIRE(child >= 0);
+        if (child == 0) {
+            FileSinkStream sink(config);
+            for (int i = 0; i < 50; ++i) {
+                sink << line(i) << std::flush;
+            }
+            // No destructors, no msync: only the kernel's dirty pages remain
+            ::raise(SIGKILL);
+            ::_exit(1);
+        }
+
+        int status = 0;
+        REQUIRE(::waitpid(child, &status, 0) == child);
+        REQUIRE(WIFSIGNALED(status));
+        REQUIRE(WTERMSIG(status) == SIGKILL);
+
+        std::string contents = directory.contents();
+        for (int i = 0; i < 50; ++i) {
+            REQUIRE(contents.find(line(i)) != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/flight_recorder.hpp>
+#include <utils/logger.hpp>
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace glooms::utils;
+
+namespace {
+    std::string recorderPath(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    std::string dumpFile(const std::string& path) {
+        std::ostringstream out;
+        REQUIRE(FlightRecorder::dump(path, out));
+        return out.str();
+    }
+
+    bool contains(const std::string& text, const std::string& part) {
+        return text.find(part) != std::string::npos;
+    }
+
+    // Maps a recorder file the way another process would, to tamper with
+    // slots. Mirrors FlightRecorder's layout: header, then the format table,
+    // then the records, each section 64-byte aligned.
+    class MappedRecorder {
+    public:
+        explicit MappedRecorder(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDWR);
+            REQUIRE(fd >= 0);
+            size_ = static_cast<size_t>(::lseek(fd, 0, SEEK_END));
+            base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            REQUIRE(base_ != MAP_FAILED);
+        }
+
+        ~MappedRecorder() {
+            ::munmap(base_, size_);
+        }
+
+        FlightHeader& header() {
+            return *static_cast<FlightHeader*>(base_);
+        }
+
+        FlightRecord& slot(uint64_t index) {
+            auto* header = static_cast<FlightHeader*>(base_);
+            size_t formats_offset = alignUp(sizeof(FlightHeader));
+            size_t records_offset = alignUp(
+                formats_offset + static_cast<size_t>(header->format_capacity) * header->format_length);
+            auto* records = reinterpret_cast<FlightRecord*>(static_cast<char*>(base_) + records_offset);
+            return records[index & (header->capacity - 1)];
+        }
+
+    private:
+        static size_t alignUp(size_t value) { return (value + 63) / 64 * 64; }
+
+        void* base_;
+        size_t size_;
+    };
+}
+
+TEST_CASE("Flight recorder ring", "[logger][flight_recorder]") {
+    std::string path = recorderPath("gloom_flight_test");
+    auto& recorder = FlightRecorder::instance();
+    FlightRecorderConfig config;
+    config.path = path;
+    config.capacity = 8;
+    REQUIRE(recorder.open(config));
+
+    for (int i = 0; i < 20; ++i) {
+        FLIGHT_RECORD(LogLevel::DEBUG, "value {}", i);
+    }
+
+    SECTION("Wraparound keeps the newest records") {
+        std::string dump = dumpFile(path);
+        REQUIRE(contains(dump, "20 records written"));
+        for (int i = 0; i < 12; ++i) {
+            REQUIRE_FALSE(contains(dump, "value " + std::to_string(i) + "\n"));
+        }
+        for (int i = 12; i < 20; ++i) {
+            REQUIRE(contains(dump, "#" + std::to_string(i) + " "));
+            REQUIRE(contains(dump, "value " + std::to_string(i) + "\n"));
+        }
+    }
+
+    SECTION("Torn slots are skipped") {
+        {
+            MappedRecorder mapped(path);
+            // Mid-rewrite, as beginRecord leaves a slot
+            mapped.slot(15).sequence.store(0);
+            // Left over from the previous lap of the ring
+            mapped.slot(17).sequence.store(17 + 1 - 8);
+        }
+
+        std::string dump = dumpFile(path);
+        REQUIRE_FALSE(contains(dump, "value 15\n"));
+        REQUIRE_FALSE(contains(dump, "value 17\n"));
+        REQUIRE(contains(dump, "value 16\n"));
+        REQUIRE(contains(dump, "value 19\n"));
+    }
+
+    recorder.close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Flight recorder dump from another process", "[logger][flight_recorder]") {
+    std::string path = recorderPath("gloom_flight_child_test");
+
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        FlightRecorderConfig config;
+        config.path = path;
+        FlightRecorder::instance().open(config);
+
+        // Below the logger's level: not printed, but still recorded
+        Logger logger("FlightChild");
+        logger.setLevel(LogLevel::ERROR);
+        logger.trace("trace before the crash");
+        for (int i = 0; i < 4; ++i) {
+            LOG_EVERY_N(logger, LogLevel::DEBUG, 2, "sampled " + std::to_string(i));
+        }
+        {
+            SCOPED_LOG(logger, "crashing scope");
+            FLIGHT_RECORD(LogLevel::INFO, "child state {} {}", 42, 1.5);
+            ::raise(SIGKILL);
+        }
+        ::_exit(1);
+    }
+
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFSIGNALED(status));
+
+    std::string dump = dumpFile(path);
+    REQUIRE(contains(dump, "pid " + std::to_string(child)));
+    REQUIRE(contains(dump, "[FlightChild] trace before the crash"));
+    REQUIRE(contains(dump, "sampled 0"));
+    REQUIRE(contains(dump, "sampled 2"));
+    REQUIRE_FALSE(contains(dump, "sampled 1"));
+    REQUIRE(contains(dump, "Entering crashing scope"));
+    REQUIRE(contains(dump, "child state 42 1.500000"));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Flight recorder file cleanup", "[logger][flight_recorder]") {
+    auto& recorder = FlightRecorder::instance();
+
+    SECTION("A clean close removes the default file") {
+        REQUIRE(recorder.open());
+        std::string path = recorder.path();
+        REQUIRE(path == "/dev/shm/gloom-flight-" + std::to_string(::getpid()));
+        REQUIRE(std::filesystem::exists(path));
+
+        recorder.close(true);
+        REQUIRE_FALSE(std::filesystem::exists(path));
+    }
+
+    SECTION("Without remove the file is kept") {
+        FlightRecorderConfig config;
+        config.path = recorderPath("gloom_flight_keep_test");
+        REQUIRE(recorder.open(config));
+
+        recorder.close();
+        REQUIRE(std::filesystem::exists(config.path));
+        std::filesystem::remove(config.path);
+    }
+
+    SECTION("A crashed ring is kept even when asked to remove it") {
+        FlightRecorderConfig config;
+        config.path = recorderPath("gloom_flight_crashed_test");
+        REQUIRE(recorder.open(config));
+        {
+            // As the crash handler marks it before dumping
+            MappedRecorder mapped(config.path);
+            mapped.header().crash_signal.store(SIGSEGV);
+        }
+
+        recorder.close(true);
+        REQUIRE(std::filesystem::exists(config.path));
+        REQUIRE(contains(dumpFile(config.path), "crashed with signal " + std::to_string(SIGSEGV)));
+        std::filesystem::remove(config.path);
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace glooms {
+namespace vision {
+
+// What the frame decoder does when its ring is full because processing is behind
+enum class FrameDropPolicy {
+    NONE,               // Block the decoder; every frame is processed
+    KEEP_LATEST,        // Replace the oldest queued frame with the newest
+    KEEP_EVERY_NTH      // Keep every Nth source frame while behind
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <utils/logger.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace glooms::utils;
+
+namespace {
+    // Routes Logger output into a string for the duration of a test
+    class CapturedOutput {
+    public:
+        CapturedOutput()
+            : stream_(std::make_shared<std::ostringstream>()) {
+            Logger::setUseColors(false);
+            Logger::setOutputStream(stream_);
+        }
+
+        ~CapturedOutput() {
+            Logger::setOutputStream(std::make_shared<std::ostream>(std::cout.rdbuf()));
+            Logger::setUseColors(true);
+        }
+
+        std::vector<std::string> lines() const {
+            std::vector<std::string> result;
+            std::istringstream input(stream_->str());
+            std::string line;
+            while (std::getline(input, line)) {
+                result.push_back(line);
+            }
+            return result;
+        }
+
+    private:
+        std::shared_ptr<std::ostringstream> stream_;
+    };
+
+    size_t countContaining(const std::vector<std::string>& lines, const std::string& text) {
+        size_t count = 0;
+        for (const auto& line : lines) {
+            count += line.find(text) != std::string::npos;
+        }
+        return count;
+    }
+}
+
+TEST_CASE("Log sampling", "[logger][sampling]") {
+    SECTION("1 in N calls are emitted") {
+        LogSampler sampler(4);
+        std::vector<uint64_t> suppressed_counts;
+        for (int i = 0; i < 10; ++i) {
+            uint64_t suppressed = 0;
+            if (sampler.shouldLog(suppressed)) {
+                suppressed_counts.push_back(suppressed);
+            }
+        }
+        // Calls 0, 4 and 8 go through, each after the 3 dropped before it
+        REQUIRE(suppressed_counts == std::vector<uint64_t>{0, 3, 3});
+    }
+
+    SECTION("N of 0 emits everything") {
+        LogSampler sampler(0);
+        uint64_t suppressed = 0;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(sampler.shouldLog(suppressed));
+            REQUIRE(suppressed == 0);
+        }
+    }
+
+    SECTION("Suppressed count is carried into the emitted line") {
+        CapturedOutput output;
+        Logger logger("SamplingTest");
+        for (int i = 0; i < 7; ++i) {
+            LOG_EVERY_N(logger, LogLevel::INFO, 3, "tick " + std::to_string(i));
+        }
+
+        auto lines = output.lines();
+        REQUIRE(lines.size() == 3);
+        REQUIRE(countContaining(lines, "tick 0") == 1);
+        REQUIRE(countContaining(lines, "tick 3") == 1);
+        REQUIRE(countContaining(lines, "tick 6") == 1);
+        REQUIRE(countContaining(lines, "suppressed: 2") == 2);
+    }
+}
+
+TEST_CASE("Log rate limiting", "[logger][sampling]") {
+    SECTION("Burst then refill") {
+        LogRateLimiter limiter(50.0, 2.0);
+        uint64_t suppressed = 0;
+
+        REQUIRE(limiter.shouldLog(suppressed));
+        REQUIRE(limiter.shouldLog(suppressed));
+        REQUIRE_FALSE(limiter.shouldLog(suppressed));
+        REQUIRE_FALSE(limiter.shouldLog(suppressed));
+
+        // 50 per second refills a token every 20 ms
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        REQUIRE(limiter.shouldLog(suppressed));
+        REQUIRE(suppressed == 2);
+    }
+
+    SECTION("Suppressed count is carried into the emitted line") {
+        CapturedOutput output;
+        Logger logger("RateLimitTest");
+        auto emit = [&logger] {
+            for (int i = 0; i < 5; ++i) {
+                LOG_RATE_LIMITED(logger, LogLevel::WARN, 20.0, 1.0, "burst");
+            }
+        };
+
+        emit();
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        emit();
+
+        auto lines = output.lines();
+        REQUIRE(lines.size() == 2);
+        REQUIRE(countContaining(lines, "suppressed") == 1);
+        REQUIRE(countContaining(lines, "suppressed: 4") == 1);
+    }
+}
@@ -0,0 +1,413 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <utils/tracer.hpp>
+#include <cctype>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace glooms::utils;
+
+namespace {
+    // Just enough JSON to read an exported trace back; throws on anything
+    // malformed, so a successful parse also checks the escaping
+    struct JsonValue {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        const JsonValue& operator[](const std::string& key) const {
+            for (const auto& member : object) {
+                if (member.first == key) {
+                    return member.second;
+                }
+            }
+            throw std::runtime_error("Missing key: " + key);
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& text)
+            : text_(text)
+            , pos_(0) {}
+
+        JsonValue parse() {
+            JsonValue value = parseValue();
+            skipSpace();
+            if (pos_ != text_.size()) {
+                fail("Trailing characters");
+            }
+            return value;
+        }
+
+    private:
+        const std::string& text_;
+        size_t pos_;
+
+        [[noreturn]] void fail(const std::string& what) const {
+            throw std::runtime_error(what + " at offset " + std::to_string(pos_));
+        }
+
+        void skipSpace() {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+        }
+
+        char peek() {
+            skipSpace();
+            if (pos_ >= text_.size()) {
+                fail("Unexpected end of input");
+            }
+            return text_[pos_];
+        }
+
+        bool consume(char c) {
+            if (peek() != c) {
+                return false;
+            }
+            ++pos_;
+            return true;
+        }
+
+        void expect(char c) {
+            if (!consume(c)) {
+                fail(std::string("Expected '") + c + "'");
+            }
+        }
+
+        JsonValue parseValue() {
+            JsonValue value;
+            char c = peek();
+            if (consume('{')) {
+                value.type = JsonValue::Type::Object;
+                if (consume('}')) {
+                    return value;
+                }
+                do {
+                    std::string key = parseString();
+                    expect(':');
+                    value.object.emplace_back(std::move(key), parseValue());
+                } while (consume(','));
+                expect('}');
+            } else if (consume('[')) {
+                value.type = JsonValue::Type::Array;
+                if (consume(']')) {
+                    return value;
+                }
+                do {
+                    value.array.push_back(parseValue());
+                } while (consume(','));
+                expect(']');
+            } else if (c == '"') {
+                value.type = JsonValue::Type::String;
+                value.string = parseString();
+            } else if (text_.compare(pos_, 4, "true") == 0 || text_.compare(pos_, 5, "false") == 0) {
+                value.type = JsonValue::Type::Bool;
+                value.boolean = c == 't';
+                pos_ += value.boolean ? 4 : 5;
+            } else if (text_.compare(pos_, 4, "null") == 0) {
+                pos_ += 4;
+            } else if (c == '-' || std::isdigit(static_cast<unsigned char>(c))) {
+                size_t end = pos_ + 1;
+                while (end < text_.size() &&
+                       (std::isdigit(static_cast<unsigned char>(text_[end])) ||
+                        text_[end] == '.' || text_[end] == 'e' || text_[end] == 'E' ||
+                        text_[end] == '+' || text_[end] == '-')) {
+                    ++end;
+                }
+                value.type = JsonValue::Type::Number;
+                value.number = std::stod(text_.substr(pos_, end - pos_));
+                pos_ = end;
+            } else {
+                fail("Unexpected character");
+            }
+            return value;
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string result;
+            while (true) {
+                if (pos_ >= text_.size()) {
+                    fail("Unterminated string");
+                }
+                char c = text_[pos_++];
+                if (c == '"') {
+                    return result;
+                }
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    fail("Unescaped control character");
+                }
+                if (c != '\\') {
+                    result += c;
+                    continue;
+                }
+
+                if (pos_ >= text_.size()) {
+                    fail("Unterminated escape");
+                }
+                char escape = text_[pos_++];
+                switch (escape) {
+                    case '"':
+                    case '\\':
+                    case '/': result += escape; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u': {
+                        if (pos_ + 4 > text_.size()) {
+                            fail("Short \\u escape");
+                        }
+                        for (size_t i = pos_; i < pos_ + 4; ++i) {
+                            if (!std::isxdigit(static_cast<unsigned char>(text_[i]))) {
+                                fail("Bad \\u escape");
+                            }
+                        }
+                        unsigned long code = std::stoul(text_.substr(pos_, 4), nullptr, 16);
+                        if (code >= 0x80) {
+                            fail("Only ASCII \\u escapes are supported");
+                        }
+                        result += static_cast<char>(code);
+                        pos_ += 4;
+                        break;
+                    }
+                    default:
+                        fail("Unknown escape");
+                }
+            }
+        }
+    };
+
+    JsonValue exportTrace() {
+        std::ostringstream out;
+        Tracer::instance().writeChromeTrace(out);
+        return JsonParser(out.str()).parse();
+    }
+
+    // Complete ("X") events, in export order
+    std::vector<JsonValue> spans(const JsonValue& trace) {
+        std::vector<JsonValue> result;
+        for (const auto& event : trace["traceEvents"].array) {
+            if (event["ph"].string == "X") {
+                result.push_back(event);
+            }
+        }
+        return result;
+    }
+
+    JsonValue spanNamed(const std::vector<JsonValue>& events, const std::string& name) {
+        for (const auto& event : events) {
+            if (event["name"].string == name) {
+                return event;
+            }
+        }
+        throw std::runtime_error("No span named " + name);
+    }
+
+    // Starts each test from an empty, enabled tracer and disables it after
+    class EnabledTracer {
+    public:
+        explicit EnabledTracer(size_t max_events_per_thread = 1 << 20) {
+            Tracer::instance().enable(max_events_per_thread);
+            Tracer::instance().clear();
+        }
+
+        ~EnabledTracer() {
+            Tracer::instance().disable();
+            Tracer::instance().clear();
+        }
+    };
+}
+
+TEST_CASE("Trace spans", "[tracer]") {
+    auto& tracer = Tracer::instance();
+
+    SECTION("Disabled tracing records nothing") {
+        tracer.disable();
+        tracer.clear();
+        { TRACE_SPAN("ignored"); }
+        REQUIRE(tracer.eventCount() == 0);
+    }
+
+    SECTION("Nested spans record their parent") {
+        EnabledTracer enabled;
+        {
+            TraceSpan outer("outer");
+            {
+                TraceSpan inner("inner", "test");
+            }
+            TraceSpan sibling("sibling");
+        }
+        { TraceSpan root("root"); }
+
+        auto events = spans(exportTrace());
+        REQUIRE(events.size() == 4);
+        const auto& outer = spanNamed(events, "outer");
+        const auto& inner = spanNamed(events, "inner");
+        const auto& sibling = spanNamed(events, "sibling");
+        const auto& root = spanNamed(events, "root");
+
+        REQUIRE(outer["args"]["parent_id"].number == 0);
+        REQUIRE(inner["args"]["parent_id"].number == outer["args"]["span_id"].number);
+        REQUIRE(sibling["args"]["parent_id"].number == outer["args"]["span_id"].number);
+        REQUIRE(root["args"]["parent_id"].number == 0);
+        REQUIRE(inner["args"]["span_id"].number != sibling["args"]["span_id"].number);
+
+        REQUIRE(inner["cat"].string == "test");
+        REQUIRE(outer["cat"].string == "gloom");
+        REQUIRE(inner["tid"].number == outer["tid"].number);
+
+        // The child lies within its parent
+        REQUIRE(inner["ts"].number >= outer["ts"].number);
+        REQUIRE(inner["ts"].number + inner["dur"].number <=
+                outer["ts"].number + outer["dur"].number + 0.001);
+    }
+
+    SECTION("Each thread records into its own buffer") {
+        EnabledTracer enabled;
+        constexpr int kThreads = 4;
+        constexpr int kSpans = 10;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([t] {
+                Tracer::instance().setThreadName("trace-worker-" + std::to_string(t));
+                for (int i = 0; i < kSpans; ++i) {
+                    TraceSpan parent("work");
+                    TraceSpan child("step");
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(tracer.eventCount() == kThreads * kSpans * 2);
+
+        auto trace = exportTrace();
+        std::map<double, std::string> names;
+        for (const auto& event : trace["traceEvents"].array) {
+            if (event["ph"].string == "M" && event["args"]["name"].string.rfind("trace-worker-", 0) == 0) {
+                names[event["tid"].number] = event["args"]["name"].string;
+            }
+        }
+        REQUIRE(names.size() == kThreads);
+
+        // Every child's parent was recorded on the child's own thread
+        std::map<double, double> span_threads;
+        std::map<double, int> per_thread;
+        auto events = spans(trace);
+        for (const auto& event : events) {
+            span_threads[event["args"]["span_id"].number] = event["tid"].number;
+            per_thread[event["tid"].number]++;
+        }
+        for (const auto& event : events) {
+            REQUIRE(names.count(event["tid"].number) == 1);
+            if (event["name"].string == "step") {
+                double parent = event["args"]["parent_id"].number;
+                REQUIRE(span_threads.count(parent) == 1);
+                REQUIRE(span_threads[parent] == event["tid"].number);
+            } else {
+                REQUIRE(event["args"]["parent_id"].number == 0);
+            }
+        }
+        for (const auto& [tid, count] : per_thread) {
+            REQUIRE(count == kSpans * 2);
+        }
+    }
+
+    SECTION("Events past max_events_per_thread are dropped and counted") {
+        EnabledTracer enabled(5);
+        for (int i = 0; i < 8; ++i) {
+            TRACE_SPAN("bounded");
+        }
+        REQUIRE(tracer.eventCount() == 5);
+        REQUIRE(tracer.droppedCount() == 3);
+
+        // The limit is per thread
+        std::thread([] {
+            for (int i = 0; i < 6; ++i) {
+                TRACE_SPAN("bounded");
+            }
+        }).join();
+        REQUIRE(tracer.eventCount() == 10);
+        REQUIRE(tracer.droppedCount() == 4);
+
+        tracer.clear();
+        REQUIRE(tracer.eventCount() == 0);
+        REQUIRE(tracer.droppedCount() == 0);
+    }
+}
+
+TEST_CASE("Chrome trace export", "[tracer]") {
+    auto& tracer = Tracer::instance();
+    EnabledTracer enabled;
+
+    SECTION("Names are escaped into valid JSON") {
+        const std::string name = "quote\" backslash\\ newline\n tab\t bell\x07 slash/";
+        const std::string category = "cat\"egory";
+        const std::string thread_name = "thread \"main\"\x1f";
+
+        tracer.setThreadName(thread_name);
+        { TraceSpan span(tracer.intern(name), tracer.intern(category)); }
+
+        std::ostringstream out;
+        tracer.writeChromeTrace(out);
+        REQUIRE(out.str().find("\\u0007") != std::string::npos);
+
+        JsonValue trace;
+        REQUIRE_NOTHROW(trace = JsonParser(out.str()).parse());
+        REQUIRE(trace["displayTimeUnit"].string == "ms");
+
+        const auto& event = spanNamed(spans(trace), name);
+        REQUIRE(event["cat"].string == category);
+
+        bool named = false;
+        for (const auto& metadata : trace["traceEvents"].array) {
+            if (metadata["ph"].string == "M" && metadata["tid"].number == event["tid"].number) {
+                REQUIRE(metadata["name"].string == "thread_name");
+                REQUIRE(metadata["args"]["name"].string == thread_name);
+                named = true;
+            }
+        }
+        REQUIRE(named);
+        tracer.setThreadName("");
+    }
+
+    SECTION("Timestamps are microseconds with nanosecond digits") {
+        auto& buffer = tracer.threadBuffer();
+        tracer.record(buffer, TraceEvent{"fixed", "test", 1234567, 5, 1000001, 0, buffer.thread_id});
+
+        std::ostringstream out;
+        tracer.writeChromeTrace(out);
+        REQUIRE(out.str().find("\"ts\":1234.567,\"dur\":0.005") != std::string::npos);
+
+        auto events = spans(JsonParser(out.str()).parse());
+        const auto& event = spanNamed(events, "fixed");
+        REQUIRE(event["ts"].number == Catch::Approx(1234.567));
+        REQUIRE(event["dur"].number == Catch::Approx(0.005));
+
+        // Formatting leaves the caller's stream state alone
+        out << std::setw(3) << 7;
+        REQUIRE(out.str().substr(out.str().size() - 3) == "  7");
+    }
+
+    SECTION("An empty trace is still valid") {
+        auto trace = exportTrace();
+        REQUIRE(trace["traceEvents"].type == JsonValue::Type::Array);
+        REQUIRE(spans(trace).empty());
+    }
+}
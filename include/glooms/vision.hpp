@@ -1,11 +1,16 @@
 #pragma once
 
 #include <opencv2/core.hpp>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <functional>
 
+#include "frame_drop_policy.hpp"
+
 namespace glooms {
 namespace vision {
 
@@ -13,6 +18,9 @@ namespace vision {
 class Processor;
 class Detector;
 class Analyzer;
+class FrameDecoder;
+struct FrameDecoderConfig;
+struct FrameDecoderStats;
 
 // Common types and enums
 enum class ProcessingMode {
@@ -44,6 +52,14 @@ struct VisionConfig {
     bool enable_preprocessing = true;
     bool enable_detection = true;
     bool enable_analysis = true;
+
+    // Stream settings (processVideo/processCamera). Frames are decoded
+    // ahead on their own thread; when processing falls behind target_fps
+    // the drop policy decides which frames are skipped. NONE replays files
+    // losslessly as fast as processing allows.
+    int decode_queue_depth = 4;
+    FrameDropPolicy frame_drop_policy = FrameDropPolicy::KEEP_LATEST;
+    int keep_every_nth = 2;
     
     // Model paths
     std::string detector_model;
@@ -114,10 +130,16 @@ public:
     static std::vector<cv::Size> getSupportedResolutions();
     static std::string getVersionInfo();
 
+    // Decoder statistics for the last processVideo/processCamera run;
+    // false before the first one
+    bool getDecoderStats(FrameDecoderStats& stats) const;
+
 protected:
     // Pipeline methods
     bool initializePipeline();
     void processPipeline(const cv::Mat& frame);
+    VisionResult processStream(FrameDecoder& decoder);
+    FrameDecoderConfig makeDecoderConfig() const;
     void cleanupPipeline();
 
     // Helper methods
@@ -144,6 +166,7 @@ private:
     uint64_t frame_count_;
     double total_processing_time_;
     std::vector<double> processing_times_;
+    std::unique_ptr<FrameDecoderStats> decoder_stats_;
 
     // Thread management
     std::vector<std::thread> worker_threads_;
@@ -0,0 +1,1575 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <vision/batch_inference.hpp>
+#include <vision/color_range_lut.hpp>
+#include <vision/detection_decoder.hpp>
+#include <vision/detection_log.hpp>
+#include <vision/detector.hpp>
+#include <vision/detector_pool.hpp>
+#include <vision/frame_decoder.hpp>
+#include <vision/frame_history.hpp>
+#include <vision/frame_pool.hpp>
+#include <vision/int8_quantization.hpp>
+#include <vision/letterbox.hpp>
+#include <vision/motion_gate.hpp>
+#include <vision/nms.hpp>
+#include <vision/preprocess_kernels.hpp>
+#include <vision/processor.hpp>
+#include <vision/quality_controller.hpp>
+#include <vision/rle_mask.hpp>
+#include <vision/tracker.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <sys/resource.h>
+
+using namespace glooms::vision;
+
+namespace {
+
+// Counts allocations of at least `min_bytes` made through cv::Mat
+class CountingAllocator : public cv::MatAllocator {
+public:
+    explicit CountingAllocator(size_t min_bytes)
+        : min_bytes_(min_bytes)
+        , delegate_(cv::Mat::getStdAllocator()) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                           size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage) const override {
+        size_t bytes = CV_ELEM_SIZE(type);
+        for (int i = 0; i < dims; ++i) {
+            bytes *= static_cast<size_t>(sizes[i]);
+        }
+        if (!data && bytes >= min_bytes_) {
+            count_++;
+        }
+        return delegate_->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag flags,
+                  cv::UMatUsageFlags usage) const override {
+        return delegate_->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* data) const override {
+        delegate_->deallocate(data);
+    }
+
+    size_t count() const { return count_; }
+    void reset() { count_ = 0; }
+
+private:
+    size_t min_bytes_;
+    cv::MatAllocator* delegate_;
+    mutable std::atomic<size_t> count_{0};
+};
+
+// Installs an allocator as the cv::Mat default for the current scope
+class ScopedAllocator {
+public:
+    explicit ScopedAllocator(cv::MatAllocator* allocator)
+        : previous_(cv::Mat::getDefaultAllocator()) {
+        cv::Mat::setDefaultAllocator(allocator);
+    }
+    ~ScopedAllocator() { cv::Mat::setDefaultAllocator(previous_); }
+
+private:
+    cv::MatAllocator* previous_;
+};
+
+ProcessorConfig makeConfig() {
+    ProcessorConfig config;
+    config.frame_width = 320;
+    config.frame_height = 240;
+    config.use_gpu = false;
+    config.processing_mode = ProcessingMode::QUALITY;  // No adaptive frame skipping
+    config.enable_color_segmentation = true;
+    config.enable_motion_detection = true;
+    config.color_lower_bound = cv::Scalar(0, 0, 0);
+    config.color_upper_bound = cv::Scalar(90, 255, 255);
+    return config;
+}
+
+// Writes a Darknet model for 32x32 RGB input with `layers` after the
+// [net] section and `values` as its parameters, and returns a CPU-only
+// detector config pointing at it
+DetectorConfig writeDarknetModel(const std::filesystem::path& directory,
+                                 const std::string& layers, const std::vector<float>& values) {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::ofstream cfg(directory / "model.cfg");
+    cfg << "[net]\nwidth=32\nheight=32\nchannels=3\n\n" << layers;
+
+    // Version 0.2.0 and images seen precede the layer parameters
+    std::ofstream weights(directory / "model.weights", std::ios::binary);
+    const int32_t version[3] = {0, 2, 0};
+    const uint64_t seen = 0;
+    weights.write(reinterpret_cast<const char*>(version), sizeof(version));
+    weights.write(reinterpret_cast<const char*>(&seen), sizeof(seen));
+    weights.write(reinterpret_cast<const char*>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(float)));
+
+    std::ofstream classes(directory / "classes.txt");
+    classes << "object\n";
+
+    DetectorConfig config;
+    config.model_weights = (directory / "model.weights").string();
+    config.model_config = (directory / "model.cfg").string();
+    config.classes_file = (directory / "classes.txt").string();
+    config.input_width = 32;
+    config.input_height = 32;
+    config.use_gpu = false;
+    config.enable_int8 = false;
+    return config;
+}
+
+} // namespace
+
+TEST_CASE("FramePool recycling", "[vision][frame_pool]") {
+    const cv::Size size(320, 240);
+
+    SECTION("Released buffers are reused") {
+        FramePool pool(4);
+        cv::Mat first = pool.acquire(size, CV_8UC3);
+        const uchar* data = first.data;
+        first.release();
+
+        cv::Mat second = pool.acquire(size, CV_8UC3);
+        REQUIRE(second.data == data);
+        REQUIRE(pool.getStats().allocations == 1);
+        REQUIRE(pool.getStats().in_use == 1);
+    }
+
+    SECTION("Held buffers are never handed out twice") {
+        FramePool pool(4);
+        cv::Mat first = pool.acquire(size, CV_8UC3);
+        cv::Mat alias = first;
+        first.release();
+
+        cv::Mat second = pool.acquire(size, CV_8UC3);
+        REQUIRE(second.data != alias.data);
+        REQUIRE(pool.getStats().allocations == 2);
+    }
+
+    SECTION("Exhausted pool falls back to unpooled buffers") {
+        FramePool pool(1);
+        cv::Mat first = pool.acquire(size, CV_8UC3);
+        cv::Mat second = pool.acquire(size, CV_8UC3);
+
+        REQUIRE_FALSE(second.empty());
+        REQUIRE(pool.getStats().misses == 1);
+        REQUIRE(pool.getStats().pooled == 1);
+    }
+}
+
+TEST_CASE("FrameHistory ring", "[vision][frame_history]") {
+    const cv::Size size(64, 48);
+
+    SECTION("Indexed by age, oldest evicted") {
+        FrameHistory history(3);
+        for (int i = 0; i < 5; ++i) {
+            cv::Mat frame(size, CV_8UC1, cv::Scalar(i));
+            history.push(frame);
+        }
+
+        REQUIRE(history.size() == 3);
+        REQUIRE(history.isFull());
+        REQUIRE(history.at(0).at<uchar>(0, 0) == 4);
+        REQUIRE(history.at(2).at<uchar>(0, 0) == 2);
+        REQUIRE_THROWS_AS(history.at(3), std::out_of_range);
+    }
+
+    SECTION("Push swaps buffers instead of copying") {
+        FrameHistory history(2);
+        cv::Mat a(size, CV_8UC1), b(size, CV_8UC1), c(size, CV_8UC1);
+        const uchar* a_data = a.data;
+        const uchar* b_data = b.data;
+
+        history.push(a);
+        REQUIRE(a.empty());
+        REQUIRE(history.at(0).data == a_data);
+
+        history.push(b);
+        history.push(c);
+        REQUIRE(c.data == a_data);          // Evicted buffer handed back
+        REQUIRE(history.at(1).data == b_data);
+    }
+
+    SECTION("Downscaled copies") {
+        FrameHistory history(2, 4);
+        cv::Mat frame(size, CV_8UC3, cv::Scalar(10, 20, 30));
+        history.pushCopy(frame);
+
+        REQUIRE(history.downscaledAt(0).size() == cv::Size(16, 12));
+        REQUIRE(history.downscaledAt(0).at<cv::Vec3b>(0, 0) == cv::Vec3b(10, 20, 30));
+    }
+}
+
+TEST_CASE("VisionProcessor steady state allocations", "[vision][processor]") {
+    auto config = makeConfig();
+    const size_t frame_bytes = static_cast<size_t>(config.frame_width) * config.frame_height;
+
+    CountingAllocator allocator(frame_bytes);
+    ScopedAllocator scoped(&allocator);
+
+    cv::Mat input(config.frame_height, config.frame_width, CV_8UC3);
+    cv::randu(input, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    SECTION("processFrame") {
+        VisionProcessor processor(config);
+        REQUIRE(processor.isInitialized());
+
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(processor.processFrame(input).success);
+        }
+
+        allocator.reset();
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(processor.processFrame(input).success);
+        }
+        REQUIRE(allocator.count() == 0);
+        REQUIRE(processor.getMetrics().frame_pool.misses == 0);
+    }
+
+    SECTION("submitFrame pipeline") {
+        VisionProcessor processor(config);
+        REQUIRE(processor.isInitialized());
+
+        ProcessingResult result;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(processor.submitFrame(input));
+            REQUIRE(processor.getResult(result));
+        }
+
+        allocator.reset();
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(processor.submitFrame(input));
+            REQUIRE(processor.getResult(result));
+            REQUIRE(result.success);
+        }
+        REQUIRE(allocator.count() == 0);
+    }
+}
+
+TEST_CASE("VisionProcessor pipeline ordering", "[vision][processor]") {
+    auto config = makeConfig();
+    // A budget no frame can meet, so the controller walks down to frame skipping
+    config.processing_mode = ProcessingMode::REALTIME;
+    config.target_fps = 100000;
+    config.thread_count = 2;
+
+    cv::Mat input(config.frame_height, config.frame_width, CV_8UC3);
+    cv::randu(input, cv::Scalar::all(0), cv::Scalar::all(255));
+
+    const int previous_threads = cv::getNumThreads();
+
+    for (bool threading : {true, false}) {
+        DYNAMIC_SECTION("Threading " << threading) {
+            config.enable_threading = threading;
+            {
+                VisionProcessor processor(config);
+                REQUIRE(processor.isInitialized());
+
+                // Keep the queues full so frames overlap in the stages
+                const size_t depth = static_cast<size_t>(config.pipeline_queue_depth);
+                uint64_t expected = 1;
+                size_t skipped = 0;
+                size_t processed = 0;
+                ProcessingResult result;
+                for (int batch = 0; batch < 60; ++batch) {
+                    for (size_t i = 0; i < depth; ++i) {
+                        REQUIRE(processor.submitFrame(input));
+                    }
+                    for (size_t i = 0; i < depth; ++i) {
+                        REQUIRE(processor.getResult(result));
+                        REQUIRE(result.success);
+                        REQUIRE(result.frame_number == expected++);
+                        if (result.frame_skipped) {
+                            skipped++;
+                        } else {
+                            processed++;
+                        }
+                    }
+                }
+
+                REQUIRE(skipped > 0);
+                REQUIRE(processed > 0);
+                REQUIRE(processor.pendingFrames() == 0);
+                REQUIRE(processor.getMetrics().frames_skipped == skipped);
+            }
+
+            // The pipeline's OpenCV thread count doesn't outlive it
+            REQUIRE(cv::getNumThreads() == previous_threads);
+        }
+    }
+}
+
+TEST_CASE("VisionProcessor motion stage", "[vision][processor][frame_history]") {
+    auto config = makeConfig();
+    config.enable_color_segmentation = false;
+    VisionProcessor processor(config);
+    REQUIRE(processor.isInitialized());
+
+    auto grey = [&](int value) {
+        return cv::Mat(config.frame_height, config.frame_width, CV_8UC3, cv::Scalar::all(value));
+    };
+    auto changed = [](const cv::Mat& diff) {
+        return cv::countNonZero(diff.reshape(1)) > 0;
+    };
+
+    // The first frame has nothing to compare against and passes through
+    auto first = processor.processFrame(grey(40));
+    REQUIRE(first.success);
+    REQUIRE(cv::norm(first.processed_frame, grey(40), cv::NORM_INF) == 0);
+
+    auto moved = processor.processFrame(grey(120));
+    REQUIRE(moved.success);
+    REQUIRE(cv::norm(moved.processed_frame, grey(255), cv::NORM_INF) == 0);
+
+    // Each frame is diffed against the previous input frame, not against
+    // the previous diff: a repeated frame shows no motion
+    auto repeated = processor.processFrame(grey(120));
+    REQUIRE(repeated.success);
+    REQUIRE_FALSE(changed(repeated.processed_frame));
+
+    // The history keeps the stage's input frames, newest first
+    const auto& history = processor.getFrameHistory();
+    REQUIRE(history.size() == 2);
+    REQUIRE(cv::norm(history.at(0), grey(120), cv::NORM_INF) == 0);
+    REQUIRE(cv::norm(history.at(1), grey(120), cv::NORM_INF) == 0);
+
+    auto back = processor.processFrame(grey(40));
+    REQUIRE(back.success);
+    REQUIRE(cv::norm(back.processed_frame, grey(255), cv::NORM_INF) == 0);
+    REQUIRE(cv::norm(history.newest(), grey(40), cv::NORM_INF) == 0);
+}
+
+TEST_CASE("Fused preprocessing kernel", "[vision][preprocess]") {
+    // Widths cover SIMD blocks, scalar tails and the smallest reflectable size
+    const std::vector<cv::Size> sizes = {
+        {2, 2}, {3, 5}, {11, 7}, {16, 3}, {33, 9}, {641, 17}, {1920, 1080}
+    };
+
+    cv::RNG rng(42);
+    for (const auto& size : sizes) {
+        cv::Mat input(size, CV_8UC3);
+        rng.fill(input, cv::RNG::UNIFORM, 0, 256);
+
+        cv::Mat rgb, expected;
+        cv::cvtColor(input, rgb, cv::COLOR_BGR2RGB);
+        cv::GaussianBlur(rgb, expected, cv::Size(3, 3), 0);
+
+        for (bool simd : {false, true}) {
+            cv::Mat actual;
+            fusedBgrToRgbBlur3x3(input, actual, simd);
+
+            INFO("size " << size.width << "x" << size.height << ", simd " << simd);
+            REQUIRE(actual.size() == expected.size());
+            REQUIRE(actual.type() == expected.type());
+            REQUIRE(cv::norm(actual, expected, cv::NORM_INF) == 0);
+        }
+    }
+
+    SECTION("Non-continuous input") {
+        cv::Mat parent(64, 96, CV_8UC3);
+        rng.fill(parent, cv::RNG::UNIFORM, 0, 256);
+        cv::Mat input = parent(cv::Rect(5, 3, 70, 50)).clone();
+        cv::Mat strided = parent(cv::Rect(5, 3, 70, 50));
+        REQUIRE_FALSE(strided.isContinuous());
+
+        cv::Mat expected, actual;
+        fusedBgrToRgbBlur3x3(input, expected, false);
+        fusedBgrToRgbBlur3x3(strided, actual);
+        REQUIRE(cv::norm(actual, expected, cv::NORM_INF) == 0);
+    }
+}
+
+TEST_CASE("Colour range lookup table", "[vision][segmentation]") {
+    const cv::Scalar lower(20, 60, 40);
+    const cv::Scalar upper(130, 255, 220);
+
+    ColorRangeLut lut;
+    lut.build(lower, upper);
+    REQUIRE(lut.matches(lower, upper));
+    REQUIRE_FALSE(lut.matches(lower, cv::Scalar(131, 255, 220)));
+
+    cv::RNG rng(7);
+    for (const cv::Size size : {cv::Size(1, 1), cv::Size(33, 5), cv::Size(34, 3), cv::Size(641, 17)}) {
+        cv::Mat input(size, CV_8UC3);
+        rng.fill(input, cv::RNG::UNIFORM, 0, 256);
+
+        cv::Mat hsv, expected;
+        cv::cvtColor(input, hsv, cv::COLOR_RGB2HSV);
+        cv::inRange(hsv, lower, upper, expected);
+
+        for (bool simd : {false, true}) {
+            cv::Mat actual;
+            lut.apply(input, actual, simd);
+
+            INFO("size " << size.width << "x" << size.height << ", simd " << simd);
+            REQUIRE(cv::norm(actual, expected, cv::NORM_INF) == 0);
+        }
+    }
+}
+
+TEST_CASE("Motion-gated inference", "[vision][motion_gate]") {
+    // 256x128 at downscale 4 is 64x32, an exact 8x4 grid of 8-pixel blocks
+    MotionGateConfig config;
+    config.downscale = 4;
+    config.block_size = 8;
+    config.threshold = 12.0f;
+    config.min_changed_blocks = 1;
+    config.max_skipped_frames = 3;
+
+    const cv::Mat background(128, 256, CV_8UC3, cv::Scalar(40, 40, 40));
+
+    SECTION("Static frames skip inference") {
+        MotionGate gate(config);
+        REQUIRE(gate.update(background));
+
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE_FALSE(gate.update(background));
+            REQUIRE(gate.getMotionRegions().empty());
+        }
+
+        // Under the threshold counts as static too
+        cv::Mat noise = background + cv::Scalar::all(5);
+        REQUIRE_FALSE(gate.update(noise));
+
+        REQUIRE(gate.getEvaluatedFrames() == 4);
+        REQUIRE(gate.getSkippedFrames() == 3);
+    }
+
+    SECTION("A changed block runs inference") {
+        MotionGate gate(config);
+        REQUIRE(gate.update(background));
+
+        // One block, (2, 1) on the grid, is 32x32 frame pixels
+        cv::Mat moved = background.clone();
+        moved(cv::Rect(64, 32, 32, 32)).setTo(cv::Scalar(255, 255, 255));
+        REQUIRE(gate.update(moved));
+        REQUIRE(cv::countNonZero(gate.getBlockMap()) == 1);
+        REQUIRE(gate.getMotionRegions().size() == 1);
+        REQUIRE(gate.getMotionRegions()[0] == cv::Rect(64, 32, 32, 32));
+
+        // The changed frame is the new reference
+        REQUIRE_FALSE(gate.update(moved));
+    }
+
+    SECTION("max_skipped_frames forces a refresh") {
+        MotionGate gate(config);
+        REQUIRE(gate.update(background));
+
+        std::vector<bool> ran;
+        for (int i = 0; i < 8; ++i) {
+            ran.push_back(gate.update(background));
+        }
+        REQUIRE(ran == std::vector<bool>{false, false, false, true, false, false, false, true});
+    }
+
+    SECTION("A size change resets the reference") {
+        MotionGate gate(config);
+        REQUIRE(gate.update(background));
+        REQUIRE(gate.update(cv::Mat(64, 128, CV_8UC3, cv::Scalar(40, 40, 40))));
+        REQUIRE(gate.getMotionRegions().size() == 1);
+        REQUIRE(gate.getMotionRegions()[0] == cv::Rect(0, 0, 128, 64));
+    }
+}
+
+TEST_CASE("Detection output decoding", "[vision][detector]") {
+    SECTION("Argmax returns the first maximum") {
+        std::vector<float> scores(37, 0.25f);
+        scores[9] = 0.75f;
+        scores[17] = 0.75f;
+        scores[33] = 0.75f;
+
+        for (bool simd : {false, true}) {
+            float max_score = 0.0f;
+            REQUIRE(argmaxScores(scores.data(), static_cast<int>(scores.size()), max_score, simd) == 9);
+            REQUIRE(max_score == 0.75f);
+        }
+    }
+
+    SECTION("Rows rejected by objectness") {
+        // [cx, cy, w, h, objectness, class 0, class 1]
+        const std::vector<float> rows = {
+            0.5f, 0.5f, 0.2f, 0.2f, 0.9f, 0.1f, 0.8f,
+            0.5f, 0.5f, 0.2f, 0.2f, 0.2f, 0.1f, 0.9f,   // Low objectness
+            0.5f, 0.5f, 0.2f, 0.2f, 0.9f, 0.3f, 0.2f,   // Low class score
+        };
+
+        DecodeParams params;
+        params.confidence_threshold = 0.5f;
+        params.scale_x = 100.0f;
+        params.scale_y = 100.0f;
+
+        std::vector<DecodedBox> boxes;
+        decodeDetectionRows(rows.data(), 3, 7, params, boxes);
+        REQUIRE(boxes.size() == 1);
+        REQUIRE(boxes[0].class_id == 1);
+        REQUIRE(boxes[0].box == cv::Rect(40, 40, 20, 20));
+
+        params.objectness_early_out = false;
+        boxes.clear();
+        decodeDetectionRows(rows.data(), 3, 7, params, boxes);
+        REQUIRE(boxes.size() == 2);
+    }
+}
+
+TEST_CASE("Letterbox preprocessing", "[vision][detector]") {
+    Letterbox letterbox;
+    LetterboxParams params;
+    params.input_size = cv::Size(416, 416);
+    cv::Mat blob;
+    Letterbox::ensureBlob(blob, 1, params.input_size);
+    const size_t plane = 416 * 416;
+
+    SECTION("Wide frames are padded top and bottom") {
+        cv::Mat frame(360, 640, CV_8UC3, cv::Scalar(10, 20, 30));
+        LetterboxTransform transform = letterbox.run(frame, blob, 0, params);
+        REQUIRE(transform.scale_x == Catch::Approx(0.65f));
+        REQUIRE(transform.scale_y == Catch::Approx(0.65f));
+        REQUIRE(transform.pad_x == 0.0f);
+        REQUIRE(transform.pad_y == 91.0f);
+
+        const float* data = blob.ptr<float>();
+        REQUIRE(data[0] == Catch::Approx(114.0f / 255.0f));
+        // Planes are RGB
+        const size_t centre = 208 * 416 + 208;
+        REQUIRE(data[centre] == Catch::Approx(30.0f / 255.0f));
+        REQUIRE(data[plane + centre] == Catch::Approx(20.0f / 255.0f));
+        REQUIRE(data[2 * plane + centre] == Catch::Approx(10.0f / 255.0f));
+
+        // A box centred in the input decodes back to the frame centre
+        const std::vector<float> row = {208.0f, 208.0f, 65.0f, 65.0f, 0.9f, 0.9f};
+        DecodeParams decode;
+        decode.scale_x = 1.0f / transform.scale_x;
+        decode.scale_y = 1.0f / transform.scale_y;
+        decode.pad_x = transform.pad_x;
+        decode.pad_y = transform.pad_y;
+        std::vector<DecodedBox> boxes;
+        decodeDetectionRows(row.data(), 1, 6, decode, boxes);
+        REQUIRE(boxes.size() == 1);
+        REQUIRE(boxes[0].box == cv::Rect(270, 130, 100, 100));
+    }
+
+    SECTION("Input-sized frames are copied exactly") {
+        cv::Mat frame(416, 416, CV_8UC3);
+        cv::randu(frame, 0, 256);
+        letterbox.run(frame, blob, 0, params);
+
+        std::vector<cv::Mat> planes(3);
+        for (int c = 0; c < 3; ++c) {
+            planes[c] = cv::Mat(416, 416, CV_32F, blob.ptr<float>() + c * plane);
+        }
+        cv::Mat expected;
+        frame.convertTo(expected, CV_32F, 1.0 / 255.0);
+        std::vector<cv::Mat> channels;
+        cv::split(expected, channels);
+        for (int c = 0; c < 3; ++c) {
+            REQUIRE(cv::norm(planes[c], channels[2 - c], cv::NORM_INF) < 1e-6);
+        }
+    }
+
+    SECTION("Stretching when aspect ratio is not kept") {
+        params.keep_aspect = false;
+        cv::Mat frame(360, 640, CV_8UC3, cv::Scalar::all(0));
+        LetterboxTransform transform = letterbox.run(frame, blob, 0, params);
+        REQUIRE(transform.pad_y == 0.0f);
+        REQUIRE(transform.scale_y == Catch::Approx(416.0f / 360.0f));
+    }
+}
+
+TEST_CASE("Tile grid", "[vision][detector]") {
+    const cv::Size tile(640, 640);
+
+    SECTION("Edge tiles are clamped to the frame") {
+        const cv::Size frame(1920, 1080);
+        auto tiles = Detector::computeTileGrid(frame, tile, 0.2f);
+
+        // 512-pixel stride, with the last column and row pulled back to the edge
+        std::vector<cv::Rect> expected;
+        for (int y : {0, 440}) {
+            for (int x : {0, 512, 1024, 1280}) {
+                expected.emplace_back(x, y, 640, 640);
+            }
+        }
+        REQUIRE(tiles == expected);
+
+        const cv::Rect bounds(cv::Point(0, 0), frame);
+        for (const auto& t : tiles) {
+            REQUIRE((t & bounds) == t);
+        }
+        REQUIRE(tiles.back().br() == bounds.br());
+    }
+
+    SECTION("Neighbours share the configured fraction") {
+        for (float overlap : {0.0f, 0.25f, 0.5f}) {
+            auto tiles = Detector::computeTileGrid(cv::Size(4000, 640), tile, overlap);
+            REQUIRE(tiles.size() > 2);
+
+            // Every step but the last, which is aligned to the edge instead
+            const int shared = static_cast<int>(640 * overlap);
+            for (size_t i = 0; i + 2 < tiles.size(); ++i) {
+                INFO("overlap " << overlap << ", tile " << i);
+                REQUIRE((tiles[i] & tiles[i + 1]).width == shared);
+            }
+            REQUIRE((tiles[tiles.size() - 2] & tiles.back()).width >= shared);
+            REQUIRE(tiles.back().x + tiles.back().width == 4000);
+        }
+    }
+
+    SECTION("Exact fit adds no duplicate tile") {
+        auto tiles = Detector::computeTileGrid(cv::Size(1152, 640), tile, 0.2f);
+        REQUIRE(tiles == std::vector<cv::Rect>{cv::Rect(0, 0, 640, 640), cv::Rect(512, 0, 640, 640)});
+    }
+
+    SECTION("Frames smaller than a tile") {
+        auto tiles = Detector::computeTileGrid(cv::Size(300, 200), tile, 0.2f);
+        REQUIRE(tiles == std::vector<cv::Rect>{cv::Rect(0, 0, 300, 200)});
+
+        // Only one axis short: tiles shrink on that axis alone
+        tiles = Detector::computeTileGrid(cv::Size(1000, 300), tile, 0.2f);
+        REQUIRE(tiles == std::vector<cv::Rect>{cv::Rect(0, 0, 640, 300), cv::Rect(360, 0, 640, 300)});
+    }
+}
+
+TEST_CASE("Adaptive quality controller", "[vision][quality]") {
+    using std::chrono::milliseconds;
+
+    // 10 ms budget: degrade above 9.5 ms, restore below 6 ms. No smoothing,
+    // so each recorded cost is the average.
+    QualityControllerConfig config;
+    config.target_fps = 100.0;
+    config.smoothing = 1.0;
+    config.degrade_ratio = 0.95;
+    config.restore_ratio = 0.6;
+    config.hold_frames = 4;
+    config.min_input_scale = 0.5f;
+    config.max_frame_skip = 2;
+
+    // Frames recorded at `cost` until the controller reaches `level`
+    auto framesUntilLevel = [](QualityController& controller, milliseconds cost, int level) {
+        for (int frames = 1; frames <= 1000; ++frames) {
+            controller.recordFrame(cost);
+            if (controller.getLevel() == level) {
+                return frames;
+            }
+        }
+        return -1;
+    };
+
+    SECTION("Ladder") {
+        QualityController controller(config);
+        // Full, contours off, segmentation off, 0.75 and 0.5 input, skip 1 and 2
+        REQUIRE(controller.getLevelCount() == 7);
+        framesUntilLevel(controller, milliseconds(100), 6);
+
+        auto settings = controller.getSettings();
+        REQUIRE(settings.level == 6);
+        REQUIRE_FALSE(settings.contours);
+        REQUIRE_FALSE(settings.segmentation);
+        REQUIRE(settings.input_scale == Catch::Approx(0.5f));
+        REQUIRE(settings.frame_skip == 2);
+    }
+
+    SECTION("Smoothing") {
+        config.smoothing = 0.25;
+        QualityController controller(config);
+        controller.recordFrame(milliseconds(8));
+        controller.recordFrame(milliseconds(16));
+        REQUIRE(controller.getAverageCostMs() == Catch::Approx(10.0));
+    }
+
+    SECTION("Degrades above degrade_ratio, once per hold_frames") {
+        QualityController controller(config);
+        for (int i = 0; i < 20; ++i) {
+            controller.recordFrame(milliseconds(9));
+        }
+        REQUIRE(controller.getLevel() == 0);
+
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 1) == 1);
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 2) == 4);
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 3) == 4);
+    }
+
+    SECTION("Restores after hold_frames of headroom") {
+        QualityController controller(config);
+        framesUntilLevel(controller, milliseconds(10), 2);
+
+        // Between the ratios: hold the level
+        for (int i = 0; i < 20; ++i) {
+            controller.recordFrame(milliseconds(8));
+        }
+        REQUIRE(controller.getLevel() == 2);
+
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 1) == 1);
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 0) == 4);
+    }
+
+    SECTION("Restores that overshoot back off") {
+        QualityController controller(config);
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 1) == 4);
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 0) == 4);
+
+        // Each restore that is undone right away doubles the next wait
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 1) == 4);
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 0) == 8);
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 1) == 4);
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 0) == 16);
+
+        // A restore that holds for 2 * hold_frames resets the wait
+        for (int i = 0; i < 8; ++i) {
+            controller.recordFrame(milliseconds(5));
+        }
+        REQUIRE(framesUntilLevel(controller, milliseconds(10), 1) == 1);
+        REQUIRE(framesUntilLevel(controller, milliseconds(5), 0) == 4);
+    }
+
+    SECTION("Skip levels drop frames") {
+        QualityController controller(config);
+        auto pattern = [&controller](int calls) {
+            std::vector<bool> processed;
+            for (int i = 0; i < calls; ++i) {
+                processed.push_back(controller.shouldProcess());
+            }
+            return processed;
+        };
+
+        REQUIRE(pattern(3) == std::vector<bool>{true, true, true});
+        REQUIRE(controller.getSkippedFrames() == 0);
+
+        // Skipped frames are free, so 15 ms holds level 5 (7.5 ms per frame)
+        framesUntilLevel(controller, milliseconds(15), 5);
+        for (int i = 0; i < 8; ++i) {
+            controller.recordFrame(milliseconds(15));
+        }
+        REQUIRE(controller.getLevel() == 5);
+        REQUIRE(pattern(6) == std::vector<bool>{true, false, true, false, true, false});
+        REQUIRE(controller.getSkippedFrames() == 3);
+
+        framesUntilLevel(controller, milliseconds(100), 6);
+        REQUIRE(pattern(6) == std::vector<bool>{true, false, false, true, false, false});
+        REQUIRE(controller.getSkippedFrames() == 7);
+    }
+}
+
+TEST_CASE("Frame decoder drop policies", "[vision][frame_decoder]") {
+    using namespace std::chrono_literals;
+
+    // Small MJPEG file; OpenCV reads and writes it without external codecs
+    const std::string path = (std::filesystem::temp_directory_path() / "gloom_decoder_test.avi").string();
+    const int frame_count = 20;
+    {
+        cv::VideoWriter writer(path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30.0, cv::Size(64, 48));
+        REQUIRE(writer.isOpened());
+        for (int i = 0; i < frame_count; ++i) {
+            writer.write(cv::Mat(48, 64, CV_8UC3, cv::Scalar::all(i * 10)));
+        }
+    }
+
+    // Polls the decoder's stats until the predicate holds
+    auto waitFor = [](const FrameDecoder& decoder, auto predicate) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!predicate(decoder.getStats()) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+        return predicate(decoder.getStats());
+    };
+
+    // Drains the decoder, pausing after each frame to stay behind it
+    auto drain = [](FrameDecoder& decoder, std::chrono::milliseconds pause) {
+        std::vector<uint64_t> indices;
+        DecodedFrame frame;
+        while (!decoder.isFinished()) {
+            if (decoder.next(frame)) {
+                REQUIRE(frame.image.size() == cv::Size(64, 48));
+                indices.push_back(frame.index);
+                std::this_thread::sleep_for(pause);
+            }
+        }
+        return indices;
+    };
+
+    FrameDecoderConfig config;
+    config.queue_depth = 2;
+
+    SECTION("NONE delivers every frame") {
+        config.drop_policy = FrameDropPolicy::NONE;
+        FrameDecoder decoder(config);
+        REQUIRE(decoder.open(path));
+        REQUIRE(decoder.start());
+
+        std::vector<uint64_t> expected(frame_count);
+        std::iota(expected.begin(), expected.end(), 0);
+        REQUIRE(drain(decoder, 5ms) == expected);
+
+        auto stats = decoder.getStats();
+        REQUIRE(stats.decoded == frame_count);
+        REQUIRE(stats.delivered == frame_count);
+        REQUIRE(stats.dropped == 0);
+    }
+
+    SECTION("KEEP_LATEST keeps the newest frames") {
+        config.drop_policy = FrameDropPolicy::KEEP_LATEST;
+        FrameDecoder decoder(config);
+        REQUIRE(decoder.open(path));
+        REQUIRE(decoder.start());
+
+        // Nothing consumed until the last frame has pushed out all but one
+        REQUIRE(waitFor(decoder, [&](const FrameDecoderStats& stats) {
+            return stats.dropped == frame_count - 2;
+        }));
+        REQUIRE(drain(decoder, 0ms) == std::vector<uint64_t>{18, 19});
+
+        auto stats = decoder.getStats();
+        REQUIRE(stats.delivered == 2);
+        REQUIRE(stats.dropped == frame_count - 2);
+    }
+
+    SECTION("KEEP_EVERY_NTH keeps multiples of N while behind") {
+        config.drop_policy = FrameDropPolicy::KEEP_EVERY_NTH;
+        config.keep_every_nth = 3;
+        FrameDecoder decoder(config);
+        REQUIRE(decoder.open(path));
+        REQUIRE(decoder.start());
+
+        // 0 and 1 fill the ring, 2 is dropped, 3 waits for space
+        REQUIRE(waitFor(decoder, [](const FrameDecoderStats& stats) { return stats.decoded == 4; }));
+        std::vector<uint64_t> expected{0, 1, 3, 6, 9, 12, 15, 18};
+        REQUIRE(drain(decoder, 30ms) == expected);
+
+        auto stats = decoder.getStats();
+        REQUIRE(stats.decoded == frame_count);
+        REQUIRE(stats.delivered == expected.size());
+        REQUIRE(stats.dropped == frame_count - expected.size());
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Sort-and-sweep NMS", "[vision][nms]") {
+    NmsBoxes boxes;
+    boxes.push(cv::Rect(0, 0, 10, 10), 0.9f, 0);
+    boxes.push(cv::Rect(1, 0, 10, 10), 0.8f, 0);    // Overlaps box 0, same class
+    boxes.push(cv::Rect(1, 1, 10, 10), 0.7f, 1);    // Overlaps box 0, other class
+    boxes.push(cv::Rect(50, 50, 10, 10), 0.6f, 0);
+
+    NonMaxSuppressor nms;
+    std::vector<int> keep;
+
+    SECTION("Class-aware hard NMS") {
+        NmsParams params;
+        params.iou_threshold = 0.4f;
+        nms.run(boxes, params, keep);
+        REQUIRE(keep == std::vector<int>{0, 2, 3});
+
+        params.class_aware = false;
+        nms.run(boxes, params, keep);
+        REQUIRE(keep == std::vector<int>{0, 3});
+    }
+
+    SECTION("SIMD and scalar sweeps agree") {
+        cv::RNG rng(11);
+        NmsBoxes many;
+        for (int i = 0; i < 500; ++i) {
+            many.push(cv::Rect(rng.uniform(0, 200), rng.uniform(0, 200),
+                               rng.uniform(1, 60), rng.uniform(1, 60)),
+                      rng.uniform(0.0f, 1.0f), rng.uniform(0, 3));
+        }
+
+        NmsParams params;
+        std::vector<int> simd_keep;
+        nms.run(many, params, simd_keep);
+        params.allow_simd = false;
+        nms.run(many, params, keep);
+        REQUIRE(keep == simd_keep);
+    }
+
+    SECTION("Linear Soft-NMS decays instead of dropping") {
+        NmsParams params;
+        params.iou_threshold = 0.3f;
+        params.method = NmsMethod::SOFT_LINEAR;
+        params.score_threshold = 0.05f;
+        nms.run(boxes, params, keep);
+
+        // IoU of boxes 0 and 1 is 90 / 110
+        REQUIRE(keep == std::vector<int>{0, 2, 3, 1});
+        REQUIRE(boxes.score[1] == Catch::Approx(0.8f * (1.0f - 90.0f / 110.0f)));
+    }
+}
+
+namespace {
+    Detection makeDetection(cv::Rect box, float confidence, int class_id = 0) {
+        Detection det;
+        det.class_id = class_id;
+        det.confidence = confidence;
+        det.box = box;
+        return det;
+    }
+}
+
+TEST_CASE("Multi-object tracking", "[vision][tracker]") {
+    MultiObjectTracker tracker;
+    std::vector<Detection> tracked;
+
+    // Two objects, one moving right by 2 px per frame
+    auto frameDetections = [](int frame, float second_confidence) {
+        return std::vector<Detection>{
+            makeDetection(cv::Rect(10 + 2 * frame, 100, 40, 40), 0.9f),
+            makeDetection(cv::Rect(300, 50, 40, 40), second_confidence),
+        };
+    };
+
+    SECTION("Identities are stable once confirmed") {
+        for (int frame = 0; frame < 10; ++frame) {
+            tracker.predict();
+            tracker.update(frameDetections(frame, 0.8f));
+            tracked.clear();
+            tracker.getDetections(tracked);
+            // Reported after min_hits matches
+            REQUIRE(tracked.size() == (frame < 2 ? 0u : 2u));
+        }
+        REQUIRE(tracked[0].track_id == 1);
+        REQUIRE(tracked[1].track_id == 2);
+        REQUIRE(std::abs(tracked[0].box.x - 28) <= 1);
+    }
+
+    SECTION("Low-confidence detections keep confirmed tracks alive") {
+        for (int frame = 0; frame < 5; ++frame) {
+            tracker.predict();
+            tracker.update(frameDetections(frame, 0.8f));
+        }
+        for (int frame = 5; frame < 10; ++frame) {
+            tracker.predict();
+            TrackerSummary summary = tracker.update(frameDetections(frame, 0.3f));
+            REQUIRE(summary.lost == 0);
+            REQUIRE(summary.births == 0);
+        }
+        tracker.getDetections(tracked);
+        REQUIRE(tracked.size() == 2);
+        REQUIRE(tracked[1].track_id == 2);
+    }
+
+    SECTION("Cadence backs off while predictions hold") {
+        DetectionCadence cadence;
+        int runs = 0;
+        for (int frame = 0; frame < 60; ++frame) {
+            tracker.predict();
+            if (cadence.tick()) {
+                runs++;
+                cadence.adapt(tracker.update(frameDetections(frame, 0.8f)));
+            }
+        }
+        REQUIRE(cadence.getInterval() == 5);
+        REQUIRE(runs < 20);
+
+        // A new object sends it straight back to every frame
+        tracker.predict();
+        std::vector<Detection> detections = frameDetections(60, 0.8f);
+        detections.push_back(makeDetection(cv::Rect(500, 300, 40, 40), 0.9f));
+        cadence.adapt(tracker.update(detections));
+        REQUIRE(cadence.getInterval() == 1);
+    }
+}
+
+TEST_CASE("INT8 model selection and drift", "[vision][int8]") {
+    SECTION("Quantized model path") {
+        REQUIRE(int8ModelPath("models/yolo.onnx") == "models/yolo.int8.onnx");
+        REQUIRE(int8ModelPath("").empty());
+    }
+
+    SECTION("mAP against reference detections") {
+        std::vector<std::vector<Detection>> reference = {
+            {makeDetection(cv::Rect(0, 0, 50, 50), 0.9f), makeDetection(cv::Rect(100, 100, 50, 50), 0.8f, 1)},
+            {makeDetection(cv::Rect(20, 20, 40, 40), 0.7f)},
+        };
+        REQUIRE(meanAveragePrecision(reference, reference) == Catch::Approx(1.0f));
+
+        // Slightly shifted boxes still match at IoU 0.5
+        auto shifted = reference;
+        shifted[0][0].box.x += 3;
+        REQUIRE(meanAveragePrecision(reference, shifted) == Catch::Approx(1.0f));
+
+        // Missing the only class-1 object halves the mean
+        auto missing = reference;
+        missing[0].pop_back();
+        REQUIRE(meanAveragePrecision(reference, missing) == Catch::Approx(0.5f));
+
+        // A false positive ranked first costs class-0 precision
+        auto noisy = reference;
+        noisy[1].push_back(makeDetection(cv::Rect(200, 200, 30, 30), 0.95f));
+        float map = meanAveragePrecision(reference, noisy);
+        REQUIRE(map < 1.0f);
+        REQUIRE(map > 0.5f);
+    }
+}
+
+TEST_CASE("Detector pool leases", "[vision][detector_pool]") {
+    using namespace std::chrono_literals;
+
+    // Smallest network OpenCV will import: a Darknet 1x1 convolution
+    // with its bias and 3 weights
+    const auto directory = std::filesystem::temp_directory_path() / "gloom_detector_pool_test";
+    DetectorPoolConfig config;
+    config.detector = writeDarknetModel(
+        directory,
+        "[convolutional]\nfilters=1\nsize=1\nstride=1\npad=0\nactivation=linear\n",
+        {0.0f, 0.1f, 0.2f, 0.3f});
+    config.thread_budget = 2;
+
+    SECTION("Leases are exclusive") {
+        config.instances = 2;
+        DetectorPool pool(config);
+        REQUIRE(pool.isInitialized());
+        REQUIRE(pool.size() == 2);
+
+        auto first = pool.acquire();
+        auto second = pool.acquire();
+        REQUIRE(&*first != &*second);
+        REQUIRE(pool.getMetrics().available == 0);
+
+        // Moving a lease doesn't return the instance
+        auto moved = std::move(first);
+        REQUIRE(pool.getMetrics().available == 0);
+    }
+
+    SECTION("acquire() blocks while every instance is busy") {
+        config.instances = 1;
+        DetectorPool pool(config);
+        REQUIRE(pool.isInitialized());
+
+        std::atomic<Detector*> acquired{nullptr};
+        std::thread waiter;
+        Detector* held = nullptr;
+        {
+            auto lease = pool.acquire();
+            held = &*lease;
+            waiter = std::thread([&] {
+                auto second = pool.acquire();
+                acquired = &*second;
+            });
+
+            std::this_thread::sleep_for(100ms);
+            REQUIRE(acquired == nullptr);
+            REQUIRE(pool.getMetrics().waits == 1);
+        }
+        waiter.join();
+        REQUIRE(acquired == held);
+        REQUIRE(pool.getMetrics().available == 1);
+    }
+
+    SECTION("cleanup() waits for outstanding leases") {
+        config.instances = 1;
+        DetectorPool pool(config);
+        REQUIRE(pool.isInitialized());
+
+        std::promise<void> leased;
+        std::atomic<bool> released{false};
+        std::thread holder([&] {
+            auto lease = pool.acquire();
+            leased.set_value();
+            std::this_thread::sleep_for(100ms);
+            released = true;
+        });
+        leased.get_future().wait();
+
+        pool.cleanup();
+        REQUIRE(released);
+        REQUIRE_FALSE(pool.isInitialized());
+        REQUIRE(pool.size() == 0);
+        holder.join();
+    }
+
+    SECTION("acquire() fails once the pool is down") {
+        config.instances = 1;
+        DetectorPool pool(config);
+        REQUIRE(pool.isInitialized());
+
+        // A caller already waiting when cleanup() starts is turned away too
+        std::promise<void> leased;
+        std::thread holder([&] {
+            auto lease = pool.acquire();
+            leased.set_value();
+            std::this_thread::sleep_for(200ms);
+        });
+        leased.get_future().wait();
+
+        std::atomic<bool> waiter_done{false};
+        bool waiter_leased = true;
+        std::thread waiter([&] {
+            waiter_leased = static_cast<bool>(pool.acquire());
+            waiter_done = true;
+        });
+        while (pool.getMetrics().waits == 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+
+        pool.cleanup();
+        holder.join();
+        waiter.join();
+        REQUIRE(waiter_done);
+        REQUIRE_FALSE(waiter_leased);
+
+        REQUIRE_FALSE(pool.acquire());
+        cv::Mat frame(32, 32, CV_8UC3, cv::Scalar::all(0));
+        REQUIRE_FALSE(pool.detect(frame).success);
+    }
+
+    SECTION("INT8 calibration frames are decoded once into the model buffer") {
+        const auto calibration = directory / "calibration";
+        std::filesystem::create_directories(calibration);
+        for (int i = 0; i < 3; ++i) {
+            cv::Mat image(24, 48, CV_8UC3, cv::Scalar::all(i * 40));
+            REQUIRE(cv::imwrite((calibration / ("frame" + std::to_string(i) + ".png")).string(), image));
+        }
+        config.detector.enable_int8 = true;
+        config.detector.int8_calibration_dir = calibration.string();
+        config.detector.int8_calibration_frames = 2;
+
+        ModelBuffer buffer;
+        REQUIRE(Detector::loadModelBuffer(config.detector, buffer));
+        REQUIRE(buffer.framework == "darknet");
+        REQUIRE(buffer.int8_weights.empty());
+        REQUIRE(buffer.calibration.size() == 2);
+        REQUIRE(buffer.calibration[0].size[1] == 3);
+        REQUIRE(buffer.calibration[0].size[2] == 32);
+        REQUIRE(buffer.calibration[0].size[3] == 32);
+
+        // A pre-quantized model takes precedence and is read into the buffer
+        std::filesystem::copy_file(config.detector.model_weights, directory / "model.int8.onnx");
+        config.detector.int8_model_weights = (directory / "model.int8.onnx").string();
+        REQUIRE(Detector::loadModelBuffer(config.detector, buffer));
+        REQUIRE(buffer.int8_weights.size() == std::filesystem::file_size(directory / "model.int8.onnx"));
+        REQUIRE(buffer.calibration.empty());
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Batched detection", "[vision][detector]") {
+    // Global average pooling into a fully connected head: each frame
+    // gives one row [cx, cy, w, h, objectness, score] with the width,
+    // objectness and score following the frame's brightness
+    const auto directory = std::filesystem::temp_directory_path() / "gloom_detector_batch_test";
+    DetectorConfig config = writeDarknetModel(
+        directory,
+        "[avgpool]\n\n[connected]\noutput=6\nactivation=linear\n",
+        {16.0f, 16.0f, 4.0f, 8.0f, 0.0f, 0.0f,  // Biases, then 3 weights per output
+         0.0f, 0.0f, 0.0f,
+         0.0f, 0.0f, 0.0f,
+         16.0f, 0.0f, 0.0f,
+         0.0f, 0.0f, 0.0f,
+         1.0f, 0.0f, 0.0f,
+         1.0f, 0.0f, 0.0f});
+    config.enable_batch_processing = true;
+    config.max_batch_size = 3;
+
+    Detector batched(config);
+    REQUIRE(batched.isInitialized());
+    DetectorConfig single_config = config;
+    single_config.enable_batch_processing = false;
+    Detector single(single_config);
+    REQUIRE(single.isInitialized());
+
+    auto grey = [](int value) { return cv::Mat(32, 32, CV_8UC3, cv::Scalar::all(value)); };
+
+    // A batched frame must decode exactly as it would on its own
+    auto requireMatchesSingle = [&](const cv::Mat& frame, const DetectionResult& result) {
+        REQUIRE(result.success);
+        DetectionResult expected = single.detect(frame);
+        REQUIRE(expected.success);
+        REQUIRE(result.detections.size() == expected.detections.size());
+        for (size_t i = 0; i < expected.detections.size(); ++i) {
+            REQUIRE(result.detections[i].class_id == expected.detections[i].class_id);
+            REQUIRE(result.detections[i].confidence == Catch::Approx(expected.detections[i].confidence));
+            REQUIRE(result.detections[i].box == expected.detections[i].box);
+        }
+    };
+
+    SECTION("An invalid frame fails on its own") {
+        // One full batch of frames 0, 2 and 3, then a trailing batch of frame 4
+        std::vector<cv::Mat> frames = {
+            grey(255),
+            cv::Mat(32, 32, CV_8UC1, cv::Scalar(255)),
+            grey(192),
+            grey(0),
+            grey(224)
+        };
+        auto results = batched.detectBatch(frames);
+        REQUIRE(results.size() == frames.size());
+        REQUIRE_FALSE(results[1].success);
+
+        for (size_t i : {0, 2, 3, 4}) {
+            requireMatchesSingle(frames[i], results[i]);
+        }
+        REQUIRE(results[0].frame_number < results[2].frame_number);
+        REQUIRE(results[2].frame_number < results[3].frame_number);
+        REQUIRE(results[3].frame_number < results[4].frame_number);
+
+        // Each result carries its own frame's box, not a neighbour's
+        REQUIRE(results[0].detections.size() == 1);
+        REQUIRE(results[0].detections[0].confidence == Catch::Approx(1.0f).margin(1e-4));
+        REQUIRE(results[0].detections[0].box == cv::Rect(6, 12, 20, 8));
+        REQUIRE(results[2].detections.size() == 1);
+        REQUIRE(results[2].detections[0].box.width == 16);
+        REQUIRE(results[3].detections.empty());
+        REQUIRE(results[4].detections.size() == 1);
+        REQUIRE(results[4].detections[0].box.width == 18);
+    }
+
+    SECTION("A batch shorter than max_batch_size") {
+        std::vector<cv::Mat> frames = {grey(224), grey(255)};
+        auto results = batched.detectBatch(frames);
+        REQUIRE(results.size() == 2);
+        requireMatchesSingle(frames[0], results[0]);
+        requireMatchesSingle(frames[1], results[1]);
+        REQUIRE(results[0].detections[0].box.width == 18);
+        REQUIRE(results[1].detections[0].box.width == 20);
+
+        // The full-size blob left from a longer batch doesn't leak into a
+        // shorter one
+        REQUIRE(batched.detectBatch({grey(255), grey(255), grey(255)}).size() == 3);
+        results = batched.detectBatch({grey(192)});
+        REQUIRE(results.size() == 1);
+        requireMatchesSingle(grey(192), results[0]);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Batch output splitting", "[vision][batch_inference]") {
+    SECTION("2D outputs are split into equal row blocks") {
+        cv::Mat output(6, 7, CV_32F);
+        for (int r = 0; r < output.rows; ++r) {
+            output.row(r).setTo(cv::Scalar::all(r));
+        }
+
+        auto parts = splitBatchOutput(output, 3);
+        REQUIRE(parts.size() == 3);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(parts[i].rows == 2);
+            REQUIRE(parts[i].cols == 7);
+            REQUIRE(parts[i].at<float>(0, 0) == 2.0f * i);
+            REQUIRE(parts[i].at<float>(1, 6) == 2.0f * i + 1);
+        }
+
+        // Parts are copies, so the network can reuse its output blob
+        output.setTo(cv::Scalar::all(-1));
+        REQUIRE(parts[2].at<float>(0, 0) == 4.0f);
+    }
+
+    SECTION("Leading batch dimension is sliced") {
+        const int shape[] = {2, 3, 4};
+        cv::Mat output(3, shape, CV_32F);
+        std::iota(output.ptr<float>(), output.ptr<float>() + output.total(), 0.0f);
+
+        auto parts = splitBatchOutput(output, 2);
+        REQUIRE(parts.size() == 2);
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(parts[i].dims == 3);
+            REQUIRE(parts[i].size[0] == 1);
+            REQUIRE(parts[i].size[1] == 3);
+            REQUIRE(parts[i].size[2] == 4);
+            REQUIRE(parts[i].ptr<float>()[0] == 12.0f * i);
+            REQUIRE(parts[i].ptr<float>()[11] == 12.0f * i + 11);
+        }
+    }
+
+    SECTION("DetectionOutput rows are regrouped by image id") {
+        // [image_id, label, confidence, x1, y1, x2, y2]; ids 3 and -1 are
+        // outside a batch of 3 and dropped
+        const float rows[][7] = {
+            {1, 5, 0.9f, 0.1f, 0.1f, 0.2f, 0.2f},
+            {0, 2, 0.8f, 0.3f, 0.3f, 0.4f, 0.4f},
+            {1, 7, 0.7f, 0.5f, 0.5f, 0.6f, 0.6f},
+            {3, 1, 0.6f, 0.0f, 0.0f, 1.0f, 1.0f},
+            {-1, 1, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f},
+        };
+        const int shape[] = {1, 1, 5, 7};
+        cv::Mat output(4, shape, CV_32F, const_cast<float*>(&rows[0][0]));
+
+        auto parts = splitBatchOutput(output, 3);
+        REQUIRE(parts.size() == 3);
+        REQUIRE(parts[0].size[2] == 1);
+        REQUIRE(parts[1].size[2] == 2);
+        REQUIRE(parts[2].size[2] == 0);
+        for (const auto& part : parts) {
+            REQUIRE(part.dims == 4);
+            REQUIRE(part.size[0] == 1);
+            REQUIRE(part.size[3] == 7);
+        }
+
+        // Rows keep their order and are renumbered as image 0
+        const float* first = parts[0].ptr<float>();
+        REQUIRE(first[0] == 0.0f);
+        REQUIRE(first[1] == 2.0f);
+        const float* second = parts[1].ptr<float>();
+        REQUIRE(second[0] == 0.0f);
+        REQUIRE(second[1] == 5.0f);
+        REQUIRE(second[7] == 0.0f);
+        REQUIRE(second[8] == 7.0f);
+    }
+
+    SECTION("Unsplittable outputs throw") {
+        REQUIRE_THROWS_AS(splitBatchOutput(cv::Mat(5, 7, CV_32F, cv::Scalar(0)), 2), std::runtime_error);
+
+        const int shape[] = {3, 2, 2};
+        REQUIRE_THROWS_AS(splitBatchOutput(cv::Mat(3, shape, CV_32F, cv::Scalar(0)), 2),
+                          std::runtime_error);
+    }
+}
+
+TEST_CASE("Shared batch inference", "[vision][batch_inference]") {
+    // readNet() takes a single path, so the network is a Darknet config
+    // with only a global average pool: no weights file needed, and each
+    // image's output is the mean of its own channels
+    const auto directory = std::filesystem::temp_directory_path() / "gloom_batch_inference_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    {
+        std::ofstream cfg(directory / "model.cfg");
+        cfg << "[net]\nwidth=32\nheight=32\nchannels=3\n\n[avgpool]\n";
+    }
+
+    BatchInferenceConfig config;
+    config.model_path = (directory / "model.cfg").string();
+    config.use_gpu = false;
+    config.input_width = 32;
+    config.input_height = 32;
+    config.scale_factor = 1.0 / 255.0;
+    config.mean = cv::Scalar(0, 0, 0);
+    config.max_batch_size = 2;
+    config.max_latency = std::chrono::seconds(5);  // Only a full batch runs
+
+    BatchInference inference(config);
+    REQUIRE(inference.initialize());
+
+    // Two streams submitting concurrently share one forward pass
+    auto submitter = [&](int value) {
+        return std::async(std::launch::async, [&inference, value] {
+            return inference.submit(cv::Mat(32, 32, CV_8UC3, cv::Scalar::all(value))).get();
+        });
+    };
+    auto dark = submitter(51);
+    auto bright = submitter(204);
+    auto dark_outputs = dark.get();
+    auto bright_outputs = bright.get();
+
+    REQUIRE(dark_outputs.size() == 1);
+    REQUIRE(bright_outputs.size() == 1);
+    REQUIRE(dark_outputs[0].size[0] == 1);
+    REQUIRE(dark_outputs[0].total() == 3);
+    REQUIRE(dark_outputs[0].ptr<float>()[0] == Catch::Approx(0.2f));
+    REQUIRE(bright_outputs[0].ptr<float>()[0] == Catch::Approx(0.8f));
+
+    auto metrics = inference.getMetrics();
+    REQUIRE(metrics.batches == 1);
+    REQUIRE(metrics.frames == 2);
+    REQUIRE(metrics.average_batch_size == Catch::Approx(2.0));
+
+    // Requests after cleanup fail instead of waiting forever
+    inference.cleanup();
+    auto rejected = inference.submit(cv::Mat(32, 32, CV_8UC3, cv::Scalar::all(0)));
+    REQUIRE_THROWS_AS(rejected.get(), std::runtime_error);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Lazy masks and keypoints", "[vision][detector]") {
+    SECTION("Run-length round trip") {
+        cv::Mat mask(5, 7, CV_8UC1, cv::Scalar(0));
+        mask.at<uchar>(0, 0) = 1;
+        mask.at<uchar>(2, 3) = 9;
+        mask.at<uchar>(2, 4) = 9;
+        mask.at<uchar>(4, 6) = 1;
+
+        RleMask rle = RleMask::encode(mask);
+        REQUIRE(rle.counts() == std::vector<uint32_t>{0, 1, 16, 2, 15, 1});
+        REQUIRE(rle.area() == 4);
+
+        cv::Mat decoded;
+        rle.decode(decoded);
+        REQUIRE(cv::countNonZero(decoded != (mask != 0)) == 0);
+
+        REQUIRE(RleMask::fromCounts(rle.size(), rle.counts()).area() == 4);
+        REQUIRE(RleMask::fromCounts(cv::Size(2, 2), {1, 2}).empty());
+    }
+
+    // 64x64 input holding a 128x96 frame: scale 0.5 with 8 rows of padding.
+    // Prototype 0 is on over the left half, prototype 1 is a constant bias.
+    auto payload = std::make_shared<DetectionPayload>();
+    payload->input_size = cv::Size(64, 64);
+    payload->transform = LetterboxTransform{0.5f, 0.5f, 0.0f, 8.0f};
+    payload->mask_channels = 2;
+    payload->num_keypoints = 1;
+    int shape[] = {1, 2, 16, 16};
+    payload->prototypes.create(4, shape, CV_32F);
+    float* prototypes = payload->prototypes.ptr<float>();
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            prototypes[y * 16 + x] = x < 8 ? 10.0f : 0.0f;
+            prototypes[256 + y * 16 + x] = 1.0f;
+        }
+    }
+    // Mask coefficients, then one keypoint (x, y, confidence) in input pixels
+    payload->extras = (cv::Mat_<float>(1, 5) << 1.0f, -5.0f, 40.0f, 20.0f, 0.9f);
+
+    Detection det = makeDetection(cv::Rect(40, 10, 40, 20), 0.9f);
+    det.attachPayload(payload, 0);
+
+    SECTION("Mask decoded inside the box") {
+        REQUIRE(det.hasMask());
+        REQUIRE(det.mask().size() == det.box.size());
+        // Only frame columns left of x = 64 fall on the left half
+        REQUIRE(det.mask().area() == 24 * 20);
+        cv::Mat dense = det.denseMask();
+        REQUIRE(dense.at<uchar>(0, 23) == 255);
+        REQUIRE(dense.at<uchar>(0, 24) == 0);
+    }
+
+    SECTION("Keypoints follow tile offsets") {
+        det.translate(cv::Point(100, 0));
+        REQUIRE(det.box.x == 140);
+        REQUIRE(det.hasKeypoints());
+        REQUIRE(det.keypoints()[0] == cv::Point(180, 24));
+    }
+
+    SECTION("Low-confidence keypoints are missing") {
+        payload->extras.at<float>(0, 4) = 0.1f;
+        REQUIRE(det.keypoints()[0] == cv::Point(-1, -1));
+    }
+}
+
+TEST_CASE("Binary detection log", "[vision][detection_log]") {
+    auto directory = std::filesystem::temp_directory_path() / "gloom_detection_log_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    DetectionLogConfig config;
+    config.path = (directory / "cameras").string();
+    config.truncate = true;
+    config.buffer_size = 1024;          // Several hand-offs per run
+
+    auto frameDetections = [](uint32_t stream, uint64_t frame) {
+        std::vector<Detection> detections;
+        for (uint64_t i = 0; i < frame % 4; ++i) {
+            Detection det = makeDetection(cv::Rect(static_cast<int>(frame), static_cast<int>(i), 10, 20),
+                                          0.5f, static_cast<int>(i));
+            det.class_name = i == 0 ? "person" : "car";
+            det.track_id = static_cast<int>(stream);
+            detections.push_back(det);
+        }
+        return detections;
+    };
+
+    {
+        DetectionLogWriter writer(config);
+        REQUIRE(writer.isInitialized());
+        for (uint64_t frame = 1; frame <= 200; ++frame) {
+            for (uint32_t stream = 0; stream < 3; ++stream) {
+                REQUIRE(writer.append(stream, frame, frameDetections(stream, frame)));
+            }
+        }
+        writer.flush();
+        auto metrics = writer.getMetrics();
+        REQUIRE(metrics.frames == 600);
+        REQUIRE(metrics.write_errors == 0);
+    }
+
+    SECTION("Random access by stream and frame") {
+        DetectionLogReader reader;
+        REQUIRE(reader.open(config.path));
+        REQUIRE(reader.frameCount() == 600);
+        REQUIRE(reader.streams() == std::vector<uint32_t>{0, 1, 2});
+        REQUIRE(reader.frames(1).size() == 200);
+        REQUIRE(reader.classNames().size() >= 2);
+
+        std::vector<Detection> detections;
+        REQUIRE(reader.read(2, 123, detections));
+        REQUIRE(detections.size() == 3);
+        REQUIRE(detections[0].class_name == "person");
+        REQUIRE(detections[2].class_name == "car");
+        REQUIRE(detections[2].box == cv::Rect(123, 2, 10, 20));
+        REQUIRE(detections[2].track_id == 2);
+
+        REQUIRE(reader.read(0, 4, detections));
+        REQUIRE(detections.empty());
+        REQUIRE_FALSE(reader.read(0, 201, detections));
+        REQUIRE_FALSE(reader.read(7, 1, detections));
+    }
+
+    SECTION("Reopened logs append") {
+        config.truncate = false;
+        {
+            DetectionLogWriter writer(config);
+            REQUIRE(writer.append(0, 500, frameDetections(0, 3)));
+        }
+        DetectionLogReader reader;
+        REQUIRE(reader.open(config.path));
+        REQUIRE(reader.frameCount() == 601);
+
+        std::vector<Detection> detections;
+        REQUIRE(reader.read(0, 500, detections));
+        REQUIRE(detections.size() == 3);
+        REQUIRE(reader.read(1, 200, detections));
+        REQUIRE(detections.size() == 0);
+    }
+
+    SECTION("A failed write is rolled back") {
+        config.truncate = false;
+        const auto records_file = directory / "cameras.dets";
+        const auto records_size = std::filesystem::file_size(records_file);
+        {
+            DetectionLogWriter writer(config);
+
+            // Let the next batch get one record and a bit onto disk, then
+            // fail with EFBIG
+            struct rlimit previous;
+            REQUIRE(::getrlimit(RLIMIT_FSIZE, &previous) == 0);
+            struct rlimit limit = previous;
+            limit.rlim_cur = records_size + sizeof(DetectionRecord) + 8;
+            auto previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+            REQUIRE(::setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+            REQUIRE(writer.append(0, 300, frameDetections(0, 3)));
+            writer.flush();
+
+            REQUIRE(::setrlimit(RLIMIT_FSIZE, &previous) == 0);
+            std::signal(SIGXFSZ, previous_handler);
+            REQUIRE(writer.getMetrics().write_errors == 1);
+            REQUIRE(std::filesystem::file_size(records_file) == records_size);
+
+            REQUIRE(writer.append(0, 301, frameDetections(0, 2)));
+        }
+
+        DetectionLogReader reader;
+        REQUIRE(reader.open(config.path));
+        REQUIRE(reader.frameCount() == 601);
+        REQUIRE(std::filesystem::file_size(records_file) ==
+                records_size + 2 * sizeof(DetectionRecord));
+
+        // The next batch's index points at its own records
+        std::vector<Detection> detections;
+        REQUIRE_FALSE(reader.read(0, 300, detections));
+        REQUIRE(reader.read(0, 301, detections));
+        REQUIRE(detections.size() == 2);
+        REQUIRE(detections[1].box == cv::Rect(2, 1, 10, 20));
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -34,7 +34,8 @@ public:
         double total_satisfaction = calculate_satisfaction(state);
         bool satisfied = total_satisfaction >= threshold_;
 
-        logger_.debug(
+        // Called once per planner expansion, so keep it sampled
+        LOG_EVERY_N(logger_, glooms::utils::LogLevel::DEBUG, 1000,
             "Goal satisfaction level: " + 
             std::to_string(total_satisfaction) +
             (satisfied ? " (satisfied)" : " (not satisfied)")
@@ -1,5 +1,6 @@
 #include "gloom/planning/planner.hpp"
 #include "gloom/utils/logger.hpp"
+#include "gloom/utils/tracer.hpp"
 #include <algorithm>
 #include <queue>
 #include <unordered_set>
@@ -29,6 +30,7 @@ public:
         const Goal& goal,
         const std::vector<Action>& available_actions
     ) {
+        TRACE_SPAN_CAT("Planner::create_plan", "planning");
         logger_.info("Creating plan from initial state to goal");
         
         std::priority_queue<
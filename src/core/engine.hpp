@@ -12,6 +12,7 @@
 #include "state.hpp"
 #include "../solana/client.hpp"
 #include "../utils/logger.hpp"
+#include "../utils/tracer.hpp"
 #include "../utils/config.hpp"
 
 namespace solana {
@@ -121,6 +122,8 @@ private:
 // Template implementations
 template<typename T>
 Result<T> Engine::process_request(const Request<T>& request) {
+    TRACE_SPAN("Engine::process_request");
+
     if (!running_) {
         return Result<T>::error("Engine not running");
     }
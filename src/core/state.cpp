@@ -144,7 +144,8 @@ void State::track_transaction(const Transaction& transaction) {
     }
     
     transactions_[transaction.signature] = transaction;
-    logger.debug("Tracked new transaction: {}", transaction.signature);
+    LOG_RATE_LIMITED(logger, glooms::utils::LogLevel::DEBUG, 10.0, 20.0,
+                     "Tracked new transaction: " + transaction.signature);
 }
 
 std::optional<State::Transaction> State::get_transaction(
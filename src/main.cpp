@@ -4,6 +4,7 @@
 #include <gloom/utils/embeddings.hpp>
 #include <spdlog/spdlog.h>
 #include <CLI/CLI.hpp>
+#include "utils/flight_recorder.hpp"
 #include <iostream>
 #include <string>
 #include <memory>
@@ -11,7 +12,8 @@
 using namespace gloom;
 
 // Command line interface setup
-void setup_cli(CLI::App& app, AgentConfig& config, std::string& input) {
+void setup_cli(CLI::App& app, AgentConfig& config, std::string& input,
+               glooms::utils::FlightRecorderConfig& flight_config, bool& no_flight_recorder) {
     app.add_option("-n,--name", config.name, "Agent name")
         ->default_str("default_agent");
     
@@ -27,9 +29,30 @@ void setup_cli(CLI::App& app, AgentConfig& config, std::string& input) {
         
     app.add_option("-i,--input", input, "Input text")
         ->required();
+
+    app.add_option("--flight-recorder", flight_config.path,
+        "Flight recorder file (default /dev/shm/gloom-flight-<pid>)");
+
+    app.add_option("--flight-capacity", flight_config.capacity,
+        "Log records kept by the flight recorder")
+        ->default_val(8192);
+
+    app.add_flag("--no-flight-recorder", no_flight_recorder,
+        "Disable the crash-time flight recorder");
 }
 
+// Closes the flight recorder on every normal exit. Only a file at the
+// default path is removed; a crash never reaches here, so its ring stays
+// behind for flight_dump.
+struct FlightRecorderGuard {
+    bool remove_file = true;
+    ~FlightRecorderGuard() {
+        glooms::utils::FlightRecorder::instance().close(remove_file);
+    }
+};
+
 int main(int argc, char** argv) {
+    FlightRecorderGuard flight_guard;
     try {
         // Initialize logging
         spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] [thread %t] %v");
@@ -39,10 +62,24 @@ int main(int argc, char** argv) {
         CLI::App app{"Gloom Toolkit - Intelligent Agent Framework"};
         AgentConfig config;
         std::string input;
-        setup_cli(app, config, input);
+        glooms::utils::FlightRecorderConfig flight_config;
+        bool no_flight_recorder = false;
+        setup_cli(app, config, input, flight_config, no_flight_recorder);
         
         CLI11_PARSE(app, argc, argv);
 
+        // Keep every log level in shared memory and dump it to stderr if
+        // the process crashes
+        flight_guard.remove_file = flight_config.path.empty();
+        if (!no_flight_recorder) {
+            auto& recorder = glooms::utils::FlightRecorder::instance();
+            if (recorder.open(flight_config) && recorder.installCrashHandler(2)) {
+                spdlog::info("Flight recorder: {}", recorder.path());
+            } else {
+                spdlog::warn("Flight recorder unavailable");
+            }
+        }
+
         // Initialize agent
         spdlog::info("Initializing agent '{}'...", config.name);
         auto agent = std::make_unique<Agent>(config);
@@ -1,4 +1,5 @@
 #include "gloom/memory/episodic.hpp"
+#include "gloom/utils/tracer.hpp"
 #include <algorithm>
 #include <chrono>
 #include <mutex>
@@ -90,6 +91,7 @@ std::optional<std::vector<Memory>> EpisodicMemory::recall_episode(const std::str
 
 std::vector<std::pair<std::string, std::vector<Memory>>> 
 EpisodicMemory::search(const EpisodeQuery& query, size_t limit) {
+    TRACE_SPAN_CAT("EpisodicMemory::search", "memory");
     std::shared_lock<std::shared_mutex> lock(pimpl->mutex);
     std::vector<std::pair<std::string, std::vector<Memory>>> results;
     
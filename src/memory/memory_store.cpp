@@ -1,4 +1,5 @@
 #include "gloom/memory/memory_store.hpp"
+#include "gloom/utils/tracer.hpp"
 #include <algorithm>
 #include <chrono>
 #include <mutex>
@@ -49,6 +50,7 @@ std::optional<Memory> MemoryStore::retrieve(const std::string& id) {
 }
 
 std::vector<Memory> MemoryStore::search(const Query& query, size_t limit) {
+    TRACE_SPAN_CAT("MemoryStore::search", "memory");
     std::shared_lock<std::shared_mutex> lock(pimpl->mutex);
     std::vector<Memory> results;
     
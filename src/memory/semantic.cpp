@@ -1,4 +1,5 @@
 #include "gloom/memory/semantic.hpp"
+#include "gloom/utils/tracer.hpp"
 #include <algorithm>
 #include <chrono>
 #include <mutex>
@@ -105,6 +106,7 @@ std::vector<SemanticNode> SemanticMemory::search(
     const SemanticQuery& query,
     size_t limit
 ) {
+    TRACE_SPAN_CAT("SemanticMemory::search", "memory");
     std::shared_lock<std::shared_mutex> lock(pimpl->mutex);
     std::vector<SemanticNode> results;
     
@@ -144,6 +146,7 @@ std::vector<SemanticNode> SemanticMemory::get_related_nodes(
     double min_strength,
     size_t limit
 ) {
+    TRACE_SPAN_CAT("SemanticMemory::get_related_nodes", "memory");
     std::shared_lock<std::shared_mutex> lock(pimpl->mutex);
     std::vector<SemanticNode> related;
     
@@ -0,0 +1,357 @@
+#include "utils/file_sink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace glooms {
+namespace utils {
+
+namespace {
+    // O_DIRECT requires block-aligned buffers, lengths and file offsets
+    constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+RotatingFileBuf::RotatingFileBuf(const FileSinkConfig& config)
+    : config_(config)
+    , fd_(-1)
+    , buffer_(nullptr)
+    , capacity_(0)
+    , used_(0)
+    , bytes_written_(0)
+    , sequence_(0)
+    , stopping_(false) {
+    config_.segment_size = std::max<size_t>(config_.segment_size, DIRECT_IO_ALIGNMENT);
+
+    if (config_.mode == FileSinkMode::BATCHED) {
+        capacity_ = alignUp(std::max<size_t>(config_.batch_size, 1), DIRECT_IO_ALIGNMENT);
+        void* memory = nullptr;
+        if (posix_memalign(&memory, DIRECT_IO_ALIGNMENT, capacity_) != 0) {
+            return;
+        }
+        buffer_ = static_cast<char*>(memory);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+
+    if (openSegment() && config_.mode == FileSinkMode::BATCHED &&
+        config_.flush_interval.count() > 0) {
+        flush_thread_ = std::thread(&RotatingFileBuf::flushLoop, this);
+    }
+}
+
+RotatingFileBuf::~RotatingFileBuf() {
+    if (flush_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        flush_cv_.notify_all();
+        flush_thread_.join();
+    }
+    closeSegment();
+    if (config_.mode == FileSinkMode::BATCHED) {
+        std::free(buffer_);
+    }
+}
+
+bool RotatingFileBuf::rotate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rotateSegment();
+}
+
+bool RotatingFileBuf::rotateSegment() {
+    closeSegment();
+    sequence_++;
+    return openSegment();
+}
+
+bool RotatingFileBuf::openSegment() {
+    if (config_.mode == FileSinkMode::BATCHED && !buffer_) {
+        return false;
+    }
+
+    path_ = nextSegmentPath();
+
+    int flags = O_CREAT | O_TRUNC | O_CLOEXEC;
+    flags |= (config_.mode == FileSinkMode::MAPPED) ? O_RDWR : O_WRONLY;
+#ifdef O_DIRECT
+    if (config_.mode == FileSinkMode::BATCHED && config_.use_direct_io) {
+        flags |= O_DIRECT;
+    }
+#endif
+
+    fd_ = ::open(path_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+
+    // Reserve the whole segment up front so appends never extend the file.
+    // A sparse file is only an acceptable stand-in where the filesystem
+    // can't preallocate; out of space, a MAPPED segment would SIGBUS on
+    // the first unbacked page, so the segment isn't opened at all.
+    int reserved = posix_fallocate(fd_, 0, static_cast<off_t>(config_.segment_size));
+    bool can_extend = reserved == EOPNOTSUPP || reserved == EINVAL;
+    if (reserved != 0 &&
+        (!can_extend || ::ftruncate(fd_, static_cast<off_t>(config_.segment_size)) != 0)) {
+        ::close(fd_);
+        ::unlink(path_.c_str());
+        fd_ = -1;
+        return false;
+    }
+
+    if (config_.mode == FileSinkMode::MAPPED) {
+        void* mapped = ::mmap(nullptr, config_.segment_size,
+                              PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        buffer_ = static_cast<char*>(mapped);
+        capacity_ = config_.segment_size;
+    }
+
+    used_ = 0;
+    bytes_written_ = 0;
+    opened_at_ = std::chrono::steady_clock::now();
+
+    segments_.push_back(path_);
+    pruneSegments();
+    return true;
+}
+
+void RotatingFileBuf::closeSegment() {
+    if (fd_ < 0) {
+        return;
+    }
+
+    size_t used = 0;
+    if (config_.mode == FileSinkMode::MAPPED) {
+        used = pending();
+        ::munmap(buffer_, capacity_);
+        buffer_ = nullptr;
+        capacity_ = 0;
+    } else {
+        flushBatch(true);
+        used = bytes_written_;
+    }
+
+    // Drop the unused tail of the preallocated segment
+    if (::ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+        // Segment stays zero-padded; readers treat NULs as end of data
+    }
+    ::close(fd_);
+    fd_ = -1;
+    used_ = 0;
+}
+
+bool RotatingFileBuf::flushBatch(bool final) {
+    size_t size = pending();
+    if (fd_ < 0 || size == 0) {
+        return fd_ >= 0;
+    }
+
+    size_t to_write = size;
+#ifdef O_DIRECT
+    if (config_.use_direct_io) {
+        if (final) {
+            // The unaligned tail has to go through the page cache
+            int flags = ::fcntl(fd_, F_GETFL);
+            ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+        } else {
+            to_write = size / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+            if (to_write == 0) return true;
+        }
+    }
+#endif
+
+    if (!writeAll(fd_, buffer_, to_write)) {
+        return false;
+    }
+    bytes_written_ += to_write;
+
+    size_t remaining = size - to_write;
+    if (remaining > 0) {
+        std::memmove(buffer_, buffer_ + to_write, remaining);
+    }
+    used_ = remaining;
+    return true;
+}
+
+bool RotatingFileBuf::writeAround(const char* s, size_t n) {
+    // One writev() for the pending batch plus an oversized line
+    iovec iov[2];
+    iov[0].iov_base = buffer_;
+    iov[0].iov_len = pending();
+    iov[1].iov_base = const_cast<char*>(s);
+    iov[1].iov_len = n;
+
+    size_t total = iov[0].iov_len + iov[1].iov_len;
+    ssize_t written = ::writev(fd_, iov, 2);
+    if (written < 0) {
+        return false;
+    }
+
+    // Finish a short write piecewise
+    size_t done = static_cast<size_t>(written);
+    if (done < iov[0].iov_len) {
+        if (!writeAll(fd_, buffer_ + done, iov[0].iov_len - done) ||
+            !writeAll(fd_, s, n)) {
+            return false;
+        }
+    } else if (done < total) {
+        size_t line_done = done - iov[0].iov_len;
+        if (!writeAll(fd_, s + line_done, n - line_done)) {
+            return false;
+        }
+    }
+
+    bytes_written_ += total;
+    used_ = 0;
+    return true;
+}
+
+std::streamsize RotatingFileBuf::xsputn(const char* s, std::streamsize n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || n <= 0) {
+        return 0;
+    }
+
+    size_t remaining = static_cast<size_t>(n);
+
+    if (config_.mode == FileSinkMode::MAPPED) {
+        while (remaining > 0) {
+            size_t room = capacity_ - used_;
+            // Keep lines whole unless a single line exceeds a segment
+            bool fits_next = remaining <= capacity_;
+            if (room == 0 || (remaining > room && fits_next && pending() > 0)) {
+                if (!rotateSegment()) break;
+                continue;
+            }
+            size_t chunk = std::min(room, remaining);
+            std::memcpy(buffer_ + used_, s, chunk);
+            used_ += chunk;
+            s += chunk;
+            remaining -= chunk;
+        }
+        return n - static_cast<std::streamsize>(remaining);
+    }
+
+    // BATCHED mode
+    if (bytes_written_ + pending() + remaining > config_.segment_size &&
+        bytes_written_ + pending() > 0) {
+        if (!rotateSegment()) return 0;
+    }
+
+    size_t room = capacity_ - used_;
+    if (remaining <= room) {
+        std::memcpy(buffer_ + used_, s, remaining);
+        used_ += remaining;
+        return n;
+    }
+
+    if (!config_.use_direct_io) {
+        return writeAround(s, remaining) ? n : 0;
+    }
+
+    while (remaining > 0) {
+        room = capacity_ - used_;
+        if (room == 0) {
+            if (!flushBatch(false)) break;
+            continue;
+        }
+        size_t chunk = std::min(room, remaining);
+        std::memcpy(buffer_ + used_, s, chunk);
+        used_ += chunk;
+        s += chunk;
+        remaining -= chunk;
+    }
+    return n - static_cast<std::streamsize>(remaining);
+}
+
+RotatingFileBuf::int_type RotatingFileBuf::overflow(int_type ch) {
+    // The put area is always empty, so every sputc() lands here
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    char c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+int RotatingFileBuf::sync() {
+    // Called on every Logger flush: only a clock read, never a syscall
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0 && config_.max_segment_age.count() > 0) {
+        auto age = std::chrono::steady_clock::now() - opened_at_;
+        bool has_data = pending() > 0 || bytes_written_ > 0;
+        if (has_data && age >= config_.max_segment_age) {
+            rotateSegment();
+        }
+    }
+    return fd_ >= 0 ? 0 : -1;
+}
+
+void RotatingFileBuf::flushLoop() {
+    // With O_DIRECT only whole blocks can be written early; the unaligned
+    // tail waits for the batch to fill or the segment to close
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!flush_cv_.wait_for(lock, config_.flush_interval, [this] { return stopping_; })) {
+        if (pending() > 0) {
+            flushBatch(false);
+        }
+    }
+}
+
+void RotatingFileBuf::pruneSegments() {
+    while (config_.max_segments > 0 && segments_.size() > config_.max_segments) {
+        ::unlink(segments_.front().c_str());
+        segments_.pop_front();
+    }
+}
+
+std::string RotatingFileBuf::nextSegmentPath() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+    std::filesystem::path path(config_.directory);
+    path /= config_.base_name + "." + stamp + "." + std::to_string(sequence_) + ".log";
+    return path.string();
+}
+
+std::shared_ptr<std::ostream> createFileSink(const FileSinkConfig& config) {
+    return std::make_shared<FileSinkStream>(config);
+}
+
+} // namespace utils
+} // namespace glooms
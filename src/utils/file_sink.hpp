@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace glooms {
+namespace utils {
+
+// Enums
+enum class FileSinkMode {
+    MAPPED,   // Lines are copied straight into an mmap'ed, preallocated segment
+    BATCHED   // Lines are buffered and written in large write()/writev() batches
+};
+
+// Configuration struct
+struct FileSinkConfig {
+    // Segment naming: <directory>/<base_name>.<YYYYmmdd-HHMMSS>.<seq>.log
+    std::string directory = ".";
+    std::string base_name = "gloom";
+
+    // Rotation settings
+    size_t segment_size = 64 * 1024 * 1024;
+    std::chrono::seconds max_segment_age{3600};  // 0 disables time rotation
+    size_t max_segments = 8;                     // 0 keeps every segment
+
+    // Write settings
+    FileSinkMode mode = FileSinkMode::MAPPED;
+    size_t batch_size = 256 * 1024;              // BATCHED mode only
+    std::chrono::milliseconds flush_interval{1000};  // BATCHED mode: longest a line stays buffered (0 disables)
+    bool use_direct_io = false;                  // BATCHED mode only (O_DIRECT)
+};
+
+// Stream buffer backing the file sink. Writes never issue a syscall per
+// line: in MAPPED mode lines are copied into the mapped segment itself, so
+// dirty pages are owned by the kernel and survive a process crash; in
+// BATCHED mode a syscall is made when the batch buffer fills up, and a
+// background thread writes out whatever has been pending for
+// flush_interval. MAPPED segments are only used when the whole segment
+// could be reserved on disk, since touching an unbacked page of a
+// mapping raises SIGBUS. The std::streambuf put area is kept empty, so
+// every write, sputc() included, goes through the locked overflow() and
+// xsputn() rather than racing the flush thread on pptr().
+class RotatingFileBuf : public std::streambuf {
+public:
+    explicit RotatingFileBuf(const FileSinkConfig& config);
+    ~RotatingFileBuf() override;
+
+    // Delete copy constructor and assignment operator
+    RotatingFileBuf(const RotatingFileBuf&) = delete;
+    RotatingFileBuf& operator=(const RotatingFileBuf&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+    const std::string& currentPath() const { return path_; }
+    uint64_t rotationCount() const { return sequence_; }
+
+    // Closes the current segment and starts a new one
+    bool rotate();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    // Configuration
+    FileSinkConfig config_;
+
+    // Segment state
+    int fd_;
+    char* buffer_;
+    size_t capacity_;
+    size_t used_;            // Bytes of buffer_ filled and not yet written
+    size_t bytes_written_;   // BATCHED mode: bytes already written to the segment
+    std::string path_;
+    uint64_t sequence_;
+    std::chrono::steady_clock::time_point opened_at_;
+    std::deque<std::string> segments_;
+
+    // Serializes the buffer between writers and the flush thread
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    bool stopping_;
+    std::thread flush_thread_;
+
+    // Internal helper methods
+    void flushLoop();
+    bool rotateSegment();
+    bool openSegment();
+    void closeSegment();
+    bool flushBatch(bool final);
+    bool writeAround(const char* s, size_t n);
+    void pruneSegments();
+    std::string nextSegmentPath();
+    size_t pending() const { return used_; }
+};
+
+// Output stream owning its RotatingFileBuf, suitable for
+// Logger::setOutputStream
+class FileSinkStream : public std::ostream {
+public:
+    explicit FileSinkStream(const FileSinkConfig& config)
+        : std::ostream(nullptr)
+        , buf_(config) {
+        rdbuf(&buf_);
+        if (!buf_.isOpen()) {
+            setstate(std::ios::badbit);
+        }
+    }
+
+    RotatingFileBuf& buffer() { return buf_; }
+
+private:
+    RotatingFileBuf buf_;
+};
+
+// Factory function
+//   Logger::setOutputStream(createFileSink(config));
+std::shared_ptr<std::ostream> createFileSink(const FileSinkConfig& config);
+
+} // namespace utils
+} // namespace glooms
@@ -0,0 +1,480 @@
+#include "utils/flight_recorder.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <iomanip>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace glooms {
+namespace utils {
+
+namespace {
+    constexpr char FLIGHT_MAGIC[8] = {'G', 'L', 'M', 'F', 'L', 'T', '1', '\0'};
+    constexpr uint32_t FLIGHT_VERSION = 1;
+
+    constexpr int CRASH_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    int crash_dump_fd = -1;
+    char crash_stack[64 * 1024];
+
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    uint32_t currentThreadId() {
+        thread_local uint32_t tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+        return tid;
+    }
+
+    const char* levelName(uint8_t level) {
+        static const char* names[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR", "FATAL"};
+        return level < 6 ? names[level] : "?????";
+    }
+
+    // Fixed-capacity, allocation-free line builder shared by the signal
+    // handler and the offline dump
+    class LineWriter {
+    public:
+        LineWriter(char* buffer, size_t capacity)
+            : buffer_(buffer), capacity_(capacity), size_(0) {}
+
+        void put(char c) {
+            if (size_ + 1 < capacity_) buffer_[size_++] = c;
+        }
+
+        void put(const char* text, size_t max_length = SIZE_MAX) {
+            for (size_t i = 0; i < max_length && text[i]; ++i) put(text[i]);
+        }
+
+        void putUnsigned(uint64_t value, int min_width = 1) {
+            char digits[24];
+            int count = 0;
+            do {
+                digits[count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            while (count < min_width) digits[count++] = '0';
+            while (count > 0) put(digits[--count]);
+        }
+
+        void putSigned(int64_t value) {
+            if (value < 0) {
+                put('-');
+                putUnsigned(static_cast<uint64_t>(-(value + 1)) + 1);
+            } else {
+                putUnsigned(static_cast<uint64_t>(value));
+            }
+        }
+
+        void putDouble(double value) {
+            if (value != value) { put("nan"); return; }
+            if (value < 0) { put('-'); value = -value; }
+            if (value >= 1e18) { put("inf"); return; }
+            auto whole = static_cast<uint64_t>(value);
+            auto frac = static_cast<uint64_t>((value - static_cast<double>(whole)) * 1e6 + 0.5);
+            if (frac >= 1000000) { whole++; frac -= 1000000; }
+            putUnsigned(whole);
+            put('.');
+            putUnsigned(frac, 6);
+        }
+
+        void putArg(const FlightRecord& record, size_t index) {
+            auto type = static_cast<FlightArgType>((record.arg_types >> (index * 2)) & 0x3);
+            uint64_t bits = record.payload.args[index];
+            switch (type) {
+                case FlightArgType::INT:    putSigned(static_cast<int64_t>(bits)); break;
+                case FlightArgType::UINT:   putUnsigned(bits); break;
+                case FlightArgType::DOUBLE: {
+                    double value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    putDouble(value);
+                    break;
+                }
+                default: put('?'); break;
+            }
+        }
+
+        size_t finish() {
+            put('\n');
+            return size_;
+        }
+
+        void terminate() {
+            buffer_[size_] = '\0';
+        }
+
+    private:
+        char* buffer_;
+        size_t capacity_;
+        size_t size_;
+    };
+
+    size_t formatRecord(const FlightHeader& header, const char* formats,
+                        const FlightRecord& record, uint64_t index,
+                        char* buffer, size_t capacity) {
+        LineWriter line(buffer, capacity);
+
+        line.put('#');
+        line.putUnsigned(index);
+        line.put(' ');
+        line.putUnsigned(record.timestamp_ns / 1000000000ull);
+        line.put('.');
+        line.putUnsigned(record.timestamp_ns % 1000000000ull, 9);
+        line.put(' ');
+        line.put(levelName(record.level));
+        line.put(" [");
+        line.putUnsigned(record.thread_id);
+        line.put("] ");
+
+        if (record.format_id == FlightRecorder::TEXT_FORMAT_ID) {
+            line.put(record.payload.text, FlightRecord::TEXT_SIZE);
+            return line.finish();
+        }
+
+        if (record.format_id >= header.format_count.load(std::memory_order_acquire)) {
+            line.put("<unknown format ");
+            line.putUnsigned(record.format_id);
+            line.put('>');
+            for (size_t i = 0; i < record.arg_count; ++i) {
+                line.put(' ');
+                line.putArg(record, i);
+            }
+            return line.finish();
+        }
+
+        // Substitute {} placeholders in order; surplus arguments are appended
+        const char* format = formats + record.format_id * header.format_length;
+        size_t next_arg = 0;
+        for (size_t i = 0; i < header.format_length && format[i]; ++i) {
+            if (format[i] == '{' && format[i + 1] == '}' && next_arg < record.arg_count) {
+                line.putArg(record, next_arg++);
+                ++i;
+            } else {
+                line.put(format[i]);
+            }
+        }
+        for (; next_arg < record.arg_count; ++next_arg) {
+            line.put(' ');
+            line.putArg(record, next_arg);
+        }
+        return line.finish();
+    }
+
+    void writeAll(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) return;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // Walks the ring oldest first, skipping slots that were being
+    // overwritten when we got there
+    template<typename Emit>
+    void forEachLine(const FlightHeader& header, const char* formats,
+                     const FlightRecord* records, Emit&& emit) {
+        uint64_t end = header.write_index.load(std::memory_order_acquire);
+        uint64_t begin = end > header.capacity ? end - header.capacity : 0;
+        uint64_t mask = header.capacity - 1;
+
+        char line[512];
+        for (uint64_t index = begin; index < end; ++index) {
+            const FlightRecord& record = records[index & mask];
+            if (record.sequence.load(std::memory_order_acquire) != index + 1) continue;
+            size_t length = formatRecord(header, formats, record, index, line, sizeof(line));
+            if (record.sequence.load(std::memory_order_acquire) != index + 1) continue;
+            emit(line, length);
+        }
+    }
+
+}
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+FlightRecorder::FlightRecorder()
+    : active_(false)
+    , fd_(-1)
+    , base_(nullptr)
+    , mapped_size_(0)
+    , header_(nullptr)
+    , formats_(nullptr)
+    , records_(nullptr)
+    , mask_(0) {
+    // Id 0 is reserved for pre-formatted Logger lines
+    format_list_.push_back("");
+}
+
+FlightRecorder::~FlightRecorder() {
+    close();
+}
+
+bool FlightRecorder::open(const FlightRecorderConfig& config) {
+    close();
+
+    path_ = config.path.empty()
+        ? "/dev/shm/gloom-flight-" + std::to_string(::getpid())
+        : config.path;
+
+    size_t capacity = roundUpPowerOfTwo(std::max<size_t>(config.capacity, 2));
+    size_t format_capacity = std::clamp<size_t>(config.format_capacity, 1, UINT16_MAX);
+
+    size_t formats_offset = alignUp(sizeof(FlightHeader), 64);
+    size_t records_offset = alignUp(formats_offset + format_capacity * FORMAT_LENGTH, 64);
+    size_t total_size = records_offset + capacity * sizeof(FlightRecord);
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (::ftruncate(fd_, static_cast<off_t>(total_size)) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    base_ = ::mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    mapped_size_ = total_size;
+
+    auto* bytes = static_cast<char*>(base_);
+    header_ = reinterpret_cast<FlightHeader*>(bytes);
+    formats_ = bytes + formats_offset;
+    records_ = reinterpret_cast<FlightRecord*>(bytes + records_offset);
+    mask_ = capacity - 1;
+
+    std::memcpy(header_->magic, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC));
+    header_->version = FLIGHT_VERSION;
+    header_->record_size = sizeof(FlightRecord);
+    header_->capacity = static_cast<uint32_t>(capacity);
+    header_->format_capacity = static_cast<uint32_t>(format_capacity);
+    header_->format_length = FORMAT_LENGTH;
+    header_->pid = ::getpid();
+    header_->write_index.store(0, std::memory_order_relaxed);
+    header_->format_count.store(0, std::memory_order_relaxed);
+    header_->crash_signal.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(formats_mutex_);
+        for (size_t id = 0; id < format_list_.size(); ++id) {
+            publishFormat(static_cast<uint16_t>(id), format_list_[id]);
+        }
+    }
+
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void FlightRecorder::close(bool remove) {
+    // Only call at shutdown: writers do not hold a reference to the mapping
+    active_.store(false, std::memory_order_release);
+    if (remove && header_ && header_->crash_signal.load(std::memory_order_relaxed) == 0) {
+        ::unlink(path_.c_str());
+    }
+    if (base_) {
+        ::munmap(base_, mapped_size_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    header_ = nullptr;
+    formats_ = nullptr;
+    records_ = nullptr;
+}
+
+uint16_t FlightRecorder::registerFormat(const char* format) {
+    std::lock_guard<std::mutex> lock(formats_mutex_);
+
+    auto it = format_ids_.find(format);
+    if (it != format_ids_.end()) {
+        return it->second;
+    }
+
+    auto id = static_cast<uint16_t>(format_list_.size());
+    format_list_.push_back(format);
+    format_ids_.emplace(format, id);
+    if (header_) {
+        publishFormat(id, format);
+    }
+    return id;
+}
+
+void FlightRecorder::publishFormat(uint16_t id, const std::string& format) {
+    if (id >= header_->format_capacity) {
+        return;
+    }
+    char* slot = formats_ + static_cast<size_t>(id) * FORMAT_LENGTH;
+    size_t length = std::min(format.size(), FORMAT_LENGTH - 1);
+    std::memcpy(slot, format.data(), length);
+    slot[length] = '\0';
+
+    uint32_t count = header_->format_count.load(std::memory_order_relaxed);
+    if (id + 1u > count) {
+        header_->format_count.store(id + 1u, std::memory_order_release);
+    }
+}
+
+FlightRecord* FlightRecorder::beginRecord(LogLevel level, uint16_t format_id, uint64_t& index) {
+    index = header_->write_index.fetch_add(1, std::memory_order_relaxed);
+    FlightRecord* slot = &records_[index & mask_];
+
+    // Invalidate the slot while it is being rewritten
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    timespec now{};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    slot->timestamp_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ull +
+                         static_cast<uint64_t>(now.tv_nsec);
+    slot->thread_id = currentThreadId();
+    slot->format_id = format_id;
+    slot->level = static_cast<uint8_t>(level);
+    slot->arg_count = 0;
+    slot->arg_types = 0;
+    return slot;
+}
+
+void FlightRecorder::commitRecord(FlightRecord* record, uint64_t index) {
+    record->sequence.store(index + 1, std::memory_order_release);
+}
+
+void FlightRecorder::recordText(LogLevel level, const std::string& prefix,
+                                const std::string& message) {
+    if (!isActive()) {
+        return;
+    }
+
+    uint64_t index = 0;
+    FlightRecord* slot = beginRecord(level, TEXT_FORMAT_ID, index);
+
+    LineWriter text(slot->payload.text, FlightRecord::TEXT_SIZE);
+    text.put('[');
+    text.put(prefix.c_str());
+    text.put("] ");
+    text.put(message.c_str());
+    text.terminate();
+
+    commitRecord(slot, index);
+}
+
+bool FlightRecorder::installCrashHandler(int dump_fd) {
+    crash_dump_fd = dump_fd;
+
+    // Alternate stack so stack overflows can still be reported
+    stack_t stack{};
+    stack.ss_sp = crash_stack;
+    stack.ss_size = sizeof(crash_stack);
+    ::sigaltstack(&stack, nullptr);
+
+    struct sigaction action{};
+    action.sa_handler = [](int signal) {
+        auto& recorder = FlightRecorder::instance();
+        if (recorder.isActive()) {
+            recorder.header_->crash_signal.store(signal, std::memory_order_relaxed);
+            if (crash_dump_fd >= 0) {
+                const char banner[] = "=== flight recorder: crash dump ===\n";
+                writeAll(crash_dump_fd, banner, sizeof(banner) - 1);
+                recorder.dumpTo(crash_dump_fd);
+            }
+        }
+        // SA_RESETHAND restored the default action
+        ::raise(signal);
+    };
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+
+    bool ok = true;
+    for (int signal : CRASH_SIGNALS) {
+        ok &= ::sigaction(signal, &action, nullptr) == 0;
+    }
+    return ok;
+}
+
+void FlightRecorder::dumpTo(int fd) const {
+    if (!header_) {
+        return;
+    }
+    forEachLine(*header_, formats_, records_, [fd](const char* line, size_t length) {
+        writeAll(fd, line, length);
+    });
+}
+
+bool FlightRecorder::dump(const std::string& path, std::ostream& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FlightHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    auto size = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* bytes = static_cast<const char*>(mapped);
+    const auto* header = reinterpret_cast<const FlightHeader*>(bytes);
+
+    size_t formats_offset = alignUp(sizeof(FlightHeader), 64);
+    size_t records_offset = alignUp(
+        formats_offset + static_cast<size_t>(header->format_capacity) * header->format_length, 64);
+    bool valid = std::memcmp(header->magic, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC)) == 0 &&
+                 header->version == FLIGHT_VERSION &&
+                 header->record_size == sizeof(FlightRecord) &&
+                 header->capacity > 0 &&
+                 (header->capacity & (header->capacity - 1)) == 0 &&
+                 records_offset + static_cast<size_t>(header->capacity) * sizeof(FlightRecord) <= size;
+    if (!valid) {
+        ::munmap(mapped, size);
+        return false;
+    }
+
+    const char* formats = bytes + formats_offset;
+    const auto* records = reinterpret_cast<const FlightRecord*>(bytes + records_offset);
+
+    out << "pid " << header->pid
+        << ", " << header->write_index.load() << " records written"
+        << ", capacity " << header->capacity;
+    if (int signal = header->crash_signal.load()) {
+        out << ", crashed with signal " << signal;
+    }
+    out << "\n";
+
+    forEachLine(*header, formats, records, [&out](const char* line, size_t length) {
+        out.write(line, static_cast<std::streamsize>(length));
+    });
+
+    ::munmap(mapped, size);
+    return true;
+}
+
+} // namespace utils
+} // namespace glooms
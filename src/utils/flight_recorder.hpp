@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace glooms {
+namespace utils {
+
+enum class LogLevel;
+
+// Shared-memory layout. The file is a plain MAP_SHARED mapping, so its
+// contents survive the process and can be read by flight_dump afterwards.
+struct FlightHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;            // Power of two
+    uint32_t format_capacity;
+    uint32_t format_length;
+    int32_t pid;
+    std::atomic<uint64_t> write_index;
+    std::atomic<uint32_t> format_count;
+    std::atomic<int32_t> crash_signal;
+};
+
+enum class FlightArgType : uint8_t {
+    NONE = 0,
+    INT = 1,
+    UINT = 2,
+    DOUBLE = 3
+};
+
+struct alignas(64) FlightRecord {
+    static constexpr size_t MAX_ARGS = 12;
+    static constexpr size_t TEXT_SIZE = MAX_ARGS * sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence;   // index + 1 once the record is complete
+    uint64_t timestamp_ns;            // CLOCK_REALTIME
+    uint32_t thread_id;
+    uint16_t format_id;               // TEXT_FORMAT_ID for pre-formatted lines
+    uint8_t level;
+    uint8_t arg_count;
+    uint32_t arg_types;               // 2 bits per argument
+    uint32_t reserved;
+    union {
+        uint64_t args[MAX_ARGS];
+        char text[TEXT_SIZE];
+    } payload;
+};
+
+static_assert(sizeof(FlightRecord) == 128, "FlightRecord must stay two cache lines");
+
+struct FlightRecorderConfig {
+    std::string path;             // Defaults to /dev/shm/gloom-flight-<pid>
+    size_t capacity = 8192;       // Rounded up to a power of two
+    size_t format_capacity = 1024;
+};
+
+// Always-on ring of the most recent log records at every level. Records
+// hold a format id plus raw numeric arguments (or the already-built text
+// of a Logger line), so recording never formats anything.
+class FlightRecorder {
+public:
+    static constexpr uint16_t TEXT_FORMAT_ID = 0;
+    static constexpr size_t FORMAT_LENGTH = 96;
+
+    static FlightRecorder& instance();
+
+    // Delete copy constructor and assignment operator
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // Lifecycle
+    bool open(const FlightRecorderConfig& config = {});
+    // With `remove`, the file is unlinked too, unless a crash was recorded in it
+    void close(bool remove = false);
+    bool isActive() const { return active_.load(std::memory_order_acquire); }
+    const std::string& path() const { return path_; }
+
+    // Recording
+    uint16_t registerFormat(const char* format);
+
+    template<typename... Args>
+    void record(LogLevel level, uint16_t format_id, const Args&... args);
+
+    void recordText(LogLevel level, const std::string& prefix, const std::string& message);
+
+    // Crash handling: on SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT the ring is
+    // marked with the signal and dumped to `dump_fd` (-1 to skip), then
+    // the signal is re-raised with the default action
+    bool installCrashHandler(int dump_fd = 2);
+
+    // Async-signal-safe dump of the live ring
+    void dumpTo(int fd) const;
+
+    // Offline dump of a recorder file, used by the flight_dump tool
+    static bool dump(const std::string& path, std::ostream& out);
+
+private:
+    FlightRecorder();
+    ~FlightRecorder();
+
+    FlightRecord* beginRecord(LogLevel level, uint16_t format_id, uint64_t& index);
+    void commitRecord(FlightRecord* record, uint64_t index);
+    void publishFormat(uint16_t id, const std::string& format);
+
+    template<typename T>
+    static void packArg(FlightRecord* record, size_t index, const T& value);
+
+    // Mapping
+    std::atomic<bool> active_;
+    std::string path_;
+    int fd_;
+    void* base_;
+    size_t mapped_size_;
+    FlightHeader* header_;
+    char* formats_;
+    FlightRecord* records_;
+    uint64_t mask_;
+
+    // Process-side format registry, republished whenever a file is opened
+    std::mutex formats_mutex_;
+    std::vector<std::string> format_list_;
+    std::unordered_map<std::string, uint16_t> format_ids_;
+};
+
+// Template implementations
+template<typename T>
+void FlightRecorder::packArg(FlightRecord* record, size_t index, const T& value) {
+    FlightArgType type;
+    uint64_t bits = 0;
+
+    if constexpr (std::is_floating_point_v<T>) {
+        double converted = static_cast<double>(value);
+        std::memcpy(&bits, &converted, sizeof(bits));
+        type = FlightArgType::DOUBLE;
+    } else if constexpr (std::is_same_v<T, bool> || std::is_unsigned_v<T>) {
+        bits = static_cast<uint64_t>(value);
+        type = FlightArgType::UINT;
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+        type = FlightArgType::INT;
+    } else {
+        static_assert(std::is_arithmetic_v<T>,
+                      "Flight recorder arguments must be numeric");
+    }
+
+    record->payload.args[index] = bits;
+    record->arg_types |= static_cast<uint32_t>(type) << (index * 2);
+}
+
+template<typename... Args>
+void FlightRecorder::record(LogLevel level, uint16_t format_id, const Args&... args) {
+    static_assert(sizeof...(Args) <= FlightRecord::MAX_ARGS,
+                  "Too many flight recorder arguments");
+    if (!isActive()) {
+        return;
+    }
+
+    uint64_t index = 0;
+    FlightRecord* slot = beginRecord(level, format_id, index);
+    slot->arg_count = static_cast<uint8_t>(sizeof...(Args));
+
+    size_t position = 0;
+    (packArg(slot, position++, args), ...);
+    (void)position;
+
+    commitRecord(slot, index);
+}
+
+// Records a message in the flight recorder only. The format string uses
+// {} placeholders and is registered once per call site.
+#define FLIGHT_RECORD(level, format, ...) \
+    do { \
+        auto& flight_recorder_ = glooms::utils::FlightRecorder::instance(); \
+        if (flight_recorder_.isActive()) { \
+            static const uint16_t flight_format_id_ = flight_recorder_.registerFormat(format); \
+            flight_recorder_.record(level, flight_format_id_, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+} // namespace utils
+} // namespace glooms
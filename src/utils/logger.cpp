@@ -1,9 +1,11 @@
 #include "utils/logger.hpp"
+#include "utils/flight_recorder.hpp"
 #include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <mutex>
+#include <algorithm>
 
 namespace glooms {
 namespace utils {
@@ -58,6 +60,12 @@ void Logger::setTimeFormat(const std::string& format) {
 }
 
 void Logger::log(LogLevel level, const std::string& message, const LogContext& context) {
+    // The flight recorder keeps every level, so it runs before filtering
+    auto& recorder = FlightRecorder::instance();
+    if (recorder.isActive()) {
+        recorder.recordText(level, prefix_, message);
+    }
+
     if (!enabled_ || level < level_) return;
 
     std::lock_guard<std::mutex> lock(mutex_);
@@ -118,6 +126,18 @@ void Logger::log(LogLevel level, const std::string& message, const LogContext& c
     output_stream_->flush();
 }
 
+void Logger::logSampled(LogLevel level, uint64_t suppressed,
+                        const std::string& message, const LogContext& context) {
+    if (suppressed == 0) {
+        log(level, message, context);
+        return;
+    }
+
+    LogContext ctx = context;
+    ctx["suppressed"] = std::to_string(suppressed);
+    log(level, message, ctx);
+}
+
 void Logger::trace(const std::string& message, const LogContext& context) {
     log(LogLevel::TRACE, message, context);
 }
@@ -164,5 +184,41 @@ LogLevel Logger::stringToLevel(const std::string& level) {
     return LogLevel::INFO;
 }
 
+bool LogSampler::shouldLog(uint64_t& suppressed) {
+    if (counter_.fetch_add(1, std::memory_order_relaxed) % every_n_ != 0) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+LogRateLimiter::LogRateLimiter(double per_second, double burst)
+    : rate_(per_second > 0.0 ? per_second : 1.0)
+    , burst_(burst >= 1.0 ? burst : 1.0)
+    , tokens_(burst_)
+    , suppressed_(0)
+    , last_refill_(std::chrono::steady_clock::now()) {}
+
+bool LogRateLimiter::shouldLog(uint64_t& suppressed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    last_refill_ = now;
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+
+    if (tokens_ < 1.0) {
+        suppressed_++;
+        return false;
+    }
+
+    tokens_ -= 1.0;
+    suppressed = suppressed_;
+    suppressed_ = 0;
+    return true;
+}
+
 } // namespace utils
 } // namespace glooms
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include <mutex>
 #include <map>
 #include <ostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "flight_recorder.hpp"
+#include "tracer.hpp"
 
 namespace glooms {
 namespace utils {
@@ -47,6 +53,12 @@ public:
     void enable() { enabled_ = true; }
     void disable() { enabled_ = false; }
     bool isEnabled() const { return enabled_; }
+    bool isLevelEnabled(LogLevel level) const { return enabled_ && level >= level_; }
+    // True when a line at `level` would be printed, or kept by the flight
+    // recorder, which records every level
+    bool wouldLog(LogLevel level) const {
+        return isLevelEnabled(level) || FlightRecorder::instance().isActive();
+    }
     LogLevel getLevel() const { return level_; }
 
     // Static configuration methods
@@ -70,6 +82,11 @@ public:
         return last;
     }
 
+    // Emits a line on behalf of a sampled call site, reporting how many
+    // calls the site dropped since its previous emitted line
+    void logSampled(LogLevel level, uint64_t suppressed,
+                    const std::string& message, const LogContext& context = {});
+
 protected:
     // Core logging implementation
     void log(LogLevel level, const std::string& message, const LogContext& context = {});
@@ -107,6 +124,67 @@ private:
 #define LOG_FATAL(logger, message, ...) \
     logger.fatal(message, ##__VA_ARGS__)
 
+// Call-site sampling: lets through 1 in every N calls
+class LogSampler {
+public:
+    explicit LogSampler(uint64_t every_n)
+        : every_n_(every_n > 0 ? every_n : 1)
+        , counter_(0)
+        , suppressed_(0) {}
+
+    // Returns true if this call should be emitted. On success, `suppressed`
+    // holds the number of calls dropped since the last emitted one.
+    bool shouldLog(uint64_t& suppressed);
+
+private:
+    const uint64_t every_n_;
+    std::atomic<uint64_t> counter_;
+    std::atomic<uint64_t> suppressed_;
+};
+
+// Call-site rate limiting: token bucket refilled at `per_second`,
+// holding at most `burst` tokens
+class LogRateLimiter {
+public:
+    LogRateLimiter(double per_second, double burst);
+
+    // Same contract as LogSampler::shouldLog
+    bool shouldLog(uint64_t& suppressed);
+
+private:
+    const double rate_;
+    const double burst_;
+    double tokens_;
+    uint64_t suppressed_;
+    std::chrono::steady_clock::time_point last_refill_;
+    std::mutex mutex_;
+};
+
+// Sampled / rate-limited logging. Each expansion owns its own static
+// sampler, so accounting is per call site. The message is only built
+// when the line is actually emitted (printed or flight-recorded).
+#define LOG_EVERY_N(logger, level, n, message, ...) \
+    do { \
+        static glooms::utils::LogSampler log_site_sampler_(n); \
+        if ((logger).wouldLog(level)) { \
+            uint64_t log_site_suppressed_ = 0; \
+            if (log_site_sampler_.shouldLog(log_site_suppressed_)) { \
+                (logger).logSampled(level, log_site_suppressed_, message, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_RATE_LIMITED(logger, level, per_second, burst, message, ...) \
+    do { \
+        static glooms::utils::LogRateLimiter log_site_limiter_(per_second, burst); \
+        if ((logger).wouldLog(level)) { \
+            uint64_t log_site_suppressed_ = 0; \
+            if (log_site_limiter_.shouldLog(log_site_suppressed_)) { \
+                (logger).logSampled(level, log_site_suppressed_, message, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
 // Source location macros
 #define LOG_LOCATION \
     std::string(__FILE__) + ":" + std::to_string(__LINE__)
@@ -118,26 +196,35 @@ private:
         logger.log(message, ctx); \
     }
 
-// Scoped logging
+// Scoped logging: emits Entering/Exiting trace lines (flight-recorded
+// even below the logger's level) and records the scope as a TraceSpan
+// when the tracer is enabled
 class ScopedLogger {
 public:
     ScopedLogger(Logger& logger, const std::string& scope)
         : logger_(logger)
-        , scope_(scope) {
-        logger_.trace("Entering " + scope_);
+        , scope_(scope)
+        , span_(Tracer::instance().isEnabled() ? Tracer::instance().intern(scope) : "",
+                "scope") {
+        if (logger_.wouldLog(LogLevel::TRACE)) {
+            logger_.trace("Entering " + scope_);
+        }
     }
 
     ~ScopedLogger() {
-        logger_.trace("Exiting " + scope_);
+        if (logger_.wouldLog(LogLevel::TRACE)) {
+            logger_.trace("Exiting " + scope_);
+        }
     }
 
 private:
     Logger& logger_;
     std::string scope_;
+    TraceSpan span_;
 };
 
 #define SCOPED_LOG(logger, scope) \
-    ScopedLogger scoped_logger##__LINE__(logger, scope)
+    glooms::utils::ScopedLogger GLOOMS_TRACE_CONCAT(scoped_logger_, __LINE__)(logger, scope)
 
 // Builder pattern for context
 class LogContextBuilder {
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace glooms {
+namespace utils {
+
+// Bounded single-producer / single-consumer queue. Exactly one thread may
+// push and exactly one (other) thread may pop.
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots_(roundUpPowerOfTwo(capacity < 2 ? 2 : capacity))
+        , mask_(slots_.size() - 1)
+        , head_(0)
+        , tail_(0) {}
+
+    // Delete copy constructor and assignment operator
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocking variants: back off while the queue is full/empty, giving
+    // up once `running` turns false or the deadline passes
+    bool push(T&& value, const std::atomic<bool>& running) {
+        for (int spins = 0; !tryPush(std::move(value)); ++spins) {
+            if (!running.load(std::memory_order_relaxed)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    bool pop(T& value, const std::atomic<bool>& running,
+             std::chrono::steady_clock::time_point deadline =
+                 std::chrono::steady_clock::time_point::max()) {
+        for (int spins = 0; !tryPop(value); ++spins) {
+            if (!running.load(std::memory_order_relaxed) ||
+                std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            backoff(spins);
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    static void backoff(int spins) {
+        if (spins < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::vector<T> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+} // namespace utils
+} // namespace glooms
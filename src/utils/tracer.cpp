@@ -0,0 +1,211 @@
+#include "utils/tracer.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+namespace glooms {
+namespace utils {
+
+namespace {
+    void writeJsonString(std::ostream& out, const char* value) {
+        out << '"';
+        for (const char* p = value; *p; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            switch (c) {
+                case '"':  out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out << escaped;
+                    } else {
+                        out << *p;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    // Chrome trace timestamps are in microseconds. Formatted into a local
+    // buffer so the caller's stream keeps its fill and width.
+    void writeMicros(std::ostream& out, uint64_t ns) {
+        char micros[32];
+        std::snprintf(micros, sizeof(micros), "%llu.%03llu",
+                      static_cast<unsigned long long>(ns / 1000),
+                      static_cast<unsigned long long>(ns % 1000));
+        out << micros;
+    }
+}
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : enabled_(false)
+    , next_span_id_(1)
+    , next_thread_id_(1)
+    , max_events_per_thread_(1 << 20)
+    , epoch_(std::chrono::steady_clock::now()) {}
+
+void Tracer::enable(size_t max_events_per_thread) {
+    max_events_per_thread_ = max_events_per_thread;
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
+
+uint64_t Tracer::nowNs() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch_).count());
+}
+
+TraceThreadBuffer& Tracer::threadBuffer() {
+    // The registry keeps buffers alive after their thread exits
+    thread_local std::shared_ptr<TraceThreadBuffer> buffer = [this] {
+        auto created = std::make_shared<TraceThreadBuffer>();
+        created->thread_id = next_thread_id_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        buffers_.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void Tracer::record(TraceThreadBuffer& buffer, const TraceEvent& event) {
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= max_events_per_thread_) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(event);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    auto& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.thread_name = name;
+}
+
+const char* Tracer::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(intern_mutex_);
+    return interned_.insert(name).first->c_str();
+}
+
+size_t Tracer::eventCount() {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    size_t count = 0;
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+uint64_t Tracer::droppedCount() {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    uint64_t count = 0;
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        count += buffer->dropped;
+    }
+    return count;
+}
+
+void Tracer::writeChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    for (auto& buffer : buffers_) {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+
+        if (!buffer->thread_name.empty()) {
+            out << (first ? "\n" : ",\n")
+                << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                << buffer->thread_id << ",\"args\":{\"name\":";
+            writeJsonString(out, buffer->thread_name.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        for (const auto& event : buffer->events) {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"pid\":1,\"tid\":" << event.thread_id << ",\"ts\":";
+            writeMicros(out, event.start_ns);
+            out << ",\"dur\":";
+            writeMicros(out, event.duration_ns);
+            out << ",\"args\":{\"span_id\":" << event.span_id
+                << ",\"parent_id\":" << event.parent_id << "}}";
+            first = false;
+        }
+    }
+
+    out << "\n]}\n";
+}
+
+bool Tracer::exportChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    writeChromeTrace(out);
+    return out.good();
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category)
+    : buffer_(nullptr)
+    , name_(name)
+    , category_(category)
+    , start_ns_(0)
+    , span_id_(0)
+    , parent_id_(0) {
+    auto& tracer = Tracer::instance();
+    if (!tracer.isEnabled()) {
+        return;
+    }
+
+    buffer_ = &tracer.threadBuffer();
+    span_id_ = tracer.nextSpanId();
+    parent_id_ = buffer_->open_spans.empty() ? 0 : buffer_->open_spans.back();
+    buffer_->open_spans.push_back(span_id_);
+    start_ns_ = tracer.nowNs();
+}
+
+TraceSpan::~TraceSpan() {
+    if (!buffer_) {
+        return;
+    }
+
+    auto& tracer = Tracer::instance();
+    uint64_t end_ns = tracer.nowNs();
+    buffer_->open_spans.pop_back();
+
+    tracer.record(*buffer_, TraceEvent{
+        name_,
+        category_,
+        start_ns_,
+        end_ns - start_ns_,
+        span_id_,
+        parent_id_,
+        buffer_->thread_id
+    });
+}
+
+} // namespace utils
+} // namespace glooms
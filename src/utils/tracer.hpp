@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace glooms {
+namespace utils {
+
+// A completed span. Names and categories must outlive the tracer: string
+// literals, or strings returned by Tracer::intern().
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    uint64_t start_ns;      // Relative to the tracer epoch
+    uint64_t duration_ns;
+    uint64_t span_id;
+    uint64_t parent_id;     // 0 for root spans
+    uint32_t thread_id;
+};
+
+// Per-thread event storage. Only the owning thread appends; the mutex
+// is uncontended except while an export is running.
+struct TraceThreadBuffer {
+    uint32_t thread_id;
+    std::string thread_name;
+    std::vector<TraceEvent> events;
+    std::vector<uint64_t> open_spans;
+    uint64_t dropped = 0;
+    std::mutex mutex;
+};
+
+class Tracer {
+public:
+    static Tracer& instance();
+
+    // Delete copy constructor and assignment operator
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Control
+    void enable(size_t max_events_per_thread = 1 << 20);
+    void disable() { enabled_.store(false, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void clear();
+
+    // Export in Chrome Trace Event format (loadable by chrome://tracing
+    // and Perfetto)
+    void writeChromeTrace(std::ostream& out);
+    bool exportChromeTrace(const std::string& path);
+
+    // Metrics
+    size_t eventCount();
+    uint64_t droppedCount();
+
+    // Utility methods
+    const char* intern(const std::string& name);
+    void setThreadName(const std::string& name);
+    uint64_t nowNs() const;
+
+    // Span bookkeeping, used by TraceSpan
+    TraceThreadBuffer& threadBuffer();
+    uint64_t nextSpanId() { return next_span_id_.fetch_add(1, std::memory_order_relaxed); }
+    void record(TraceThreadBuffer& buffer, const TraceEvent& event);
+
+private:
+    Tracer();
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint64_t> next_span_id_;
+    std::atomic<uint32_t> next_thread_id_;
+    size_t max_events_per_thread_;
+    std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex registry_mutex_;
+    std::vector<std::shared_ptr<TraceThreadBuffer>> buffers_;
+
+    std::mutex intern_mutex_;
+    std::unordered_set<std::string> interned_;
+};
+
+// RAII span: records start, duration, thread and enclosing span. Costs a
+// single relaxed load when tracing is disabled.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "gloom");
+    ~TraceSpan();
+
+    // Delete copy constructor and assignment operator
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceThreadBuffer* buffer_;
+    const char* name_;
+    const char* category_;
+    uint64_t start_ns_;
+    uint64_t span_id_;
+    uint64_t parent_id_;
+};
+
+#define GLOOMS_TRACE_CONCAT_INNER(a, b) a##b
+#define GLOOMS_TRACE_CONCAT(a, b) GLOOMS_TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SPAN(name) \
+    glooms::utils::TraceSpan GLOOMS_TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#define TRACE_SPAN_CAT(name, category) \
+    glooms::utils::TraceSpan GLOOMS_TRACE_CONCAT(trace_span_, __LINE__)(name, category)
+
+} // namespace utils
+} // namespace glooms
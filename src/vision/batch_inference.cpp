@@ -0,0 +1,273 @@
+#include "vision/batch_inference.hpp"
+#include "utils/tracer.hpp"
+
+#include <opencv2/core/cuda.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace glooms {
+namespace vision {
+
+BatchInference::BatchInference(const BatchInferenceConfig& config)
+    : config_(config)
+    , is_initialized_(false)
+    , running_(false)
+    , batch_count_(0)
+    , frame_count_(0)
+    , forward_ns_(0) {
+    config_.max_batch_size = std::max(1, config_.max_batch_size);
+    config_.max_pending = std::max<size_t>(config_.max_pending, config_.max_batch_size);
+}
+
+BatchInference::~BatchInference() {
+    cleanup();
+}
+
+bool BatchInference::initialize() {
+    if (is_initialized_) {
+        return true;
+    }
+
+    try {
+        net_ = cv::dnn::readNet(config_.model_path);
+        if (net_.empty()) {
+            return false;
+        }
+        if (config_.use_gpu && cv::cuda::getCudaEnabledDeviceCount() > 0) {
+            net_.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+            net_.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+        }
+        output_names_ = net_.getUnconnectedOutLayersNames();
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    batch_.reserve(config_.max_batch_size);
+    images_.reserve(config_.max_batch_size);
+
+    running_ = true;
+    worker_ = std::thread(&BatchInference::workerLoop, this);
+    is_initialized_ = true;
+    return true;
+}
+
+void BatchInference::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    queue_ready_.notify_all();
+    queue_space_.notify_all();
+
+    // The worker drains everything still queued before exiting
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    is_initialized_ = false;
+}
+
+std::future<std::vector<cv::Mat>> BatchInference::submit(const cv::Mat& frame) {
+    Request request;
+    auto future = request.result.get_future();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_space_.wait(lock, [this] {
+        return !running_ || queue_.size() < config_.max_pending;
+    });
+
+    if (!running_) {
+        request.result.set_exception(std::make_exception_ptr(
+            std::runtime_error("Batch inference is not running")));
+        return future;
+    }
+
+    request.frame = frame;
+    request.enqueued = std::chrono::steady_clock::now();
+    queue_.push_back(std::move(request));
+    // Wake the worker for the first frame (to arm the latency deadline)
+    // and for a full batch
+    bool wake = queue_.size() == 1 ||
+                queue_.size() >= static_cast<size_t>(config_.max_batch_size);
+    lock.unlock();
+
+    if (wake) {
+        queue_ready_.notify_one();
+    }
+    return future;
+}
+
+void BatchInference::workerLoop() {
+    glooms::utils::Tracer::instance().setThreadName("vision-batch-inference");
+    const size_t max_batch = static_cast<size_t>(config_.max_batch_size);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        queue_ready_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;  // Stopped and drained
+        }
+
+        // Hold the batch open until it fills or the oldest frame's
+        // latency budget runs out
+        auto deadline = queue_.front().enqueued + config_.max_latency;
+        queue_ready_.wait_until(lock, deadline, [&] {
+            return !running_ || queue_.size() >= max_batch;
+        });
+
+        size_t count = std::min(queue_.size(), max_batch);
+        for (size_t i = 0; i < count; ++i) {
+            batch_.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        }
+        lock.unlock();
+        queue_space_.notify_all();
+
+        runBatch();
+        batch_.clear();
+        lock.lock();
+    }
+}
+
+void BatchInference::runBatch() {
+    TRACE_SPAN_CAT("BatchInference::runBatch", "vision");
+
+    try {
+        images_.clear();
+        for (const auto& request : batch_) {
+            images_.push_back(request.frame);
+        }
+
+        cv::dnn::blobFromImages(
+            images_,
+            blob_,
+            config_.scale_factor,
+            cv::Size(config_.input_width, config_.input_height),
+            config_.mean,
+            config_.swap_rb,
+            false
+        );
+
+        auto start = std::chrono::steady_clock::now();
+        net_.setInput(blob_);
+        net_.forward(outputs_, output_names_);
+        forward_ns_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        auto per_frame = scatterOutputs(batch_.size());
+        for (size_t i = 0; i < batch_.size(); ++i) {
+            batch_[i].result.set_value(std::move(per_frame[i]));
+        }
+    } catch (...) {
+        auto error = std::current_exception();
+        for (auto& request : batch_) {
+            request.result.set_exception(error);
+        }
+    }
+
+    // Drop frame references so pooled buffers return promptly
+    images_.clear();
+    batch_count_++;
+    frame_count_ += batch_.size();
+}
+
+std::vector<std::vector<cv::Mat>> BatchInference::scatterOutputs(size_t batch_size) const {
+    std::vector<std::vector<cv::Mat>> per_frame(batch_size);
+    for (auto& outputs : per_frame) {
+        outputs.reserve(outputs_.size());
+    }
+
+    for (const auto& output : outputs_) {
+        auto parts = splitBatchOutput(output, batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            per_frame[i].push_back(std::move(parts[i]));
+        }
+    }
+    return per_frame;
+}
+
+BatchInferenceMetrics BatchInference::getMetrics() const {
+    uint64_t batches = batch_count_.load();
+    uint64_t frames = frame_count_.load();
+
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending = queue_.size();
+    }
+
+    return BatchInferenceMetrics{
+        batches,
+        frames,
+        batches > 0 ? static_cast<double>(frames) / batches : 0.0,
+        batches > 0 ? forward_ns_.load() / 1000.0 / batches : 0.0,
+        pending
+    };
+}
+
+std::vector<cv::Mat> splitBatchOutput(const cv::Mat& output, size_t batch_size) {
+    std::vector<cv::Mat> parts(batch_size);
+
+    // 2D outputs (Darknet region layers) stack each image's rows
+    if (output.dims == 2 && output.rows % static_cast<int>(batch_size) == 0) {
+        int rows = output.rows / static_cast<int>(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            int begin = static_cast<int>(i) * rows;
+            parts[i] = output.rowRange(begin, begin + rows).clone();
+        }
+        return parts;
+    }
+
+    // Leading batch dimension: slice it, keeping a leading 1. Slices are
+    // copied because the network reuses its output blobs.
+    if (output.dims > 2 && static_cast<size_t>(output.size[0]) == batch_size) {
+        std::vector<int> shape(output.size.p, output.size.p + output.dims);
+        shape[0] = 1;
+        for (size_t i = 0; i < batch_size; ++i) {
+            cv::Mat slice(shape, output.type(), const_cast<uchar*>(output.ptr(static_cast<int>(i))));
+            parts[i] = slice.clone();
+        }
+        return parts;
+    }
+
+    // DetectionOutput layout: rows of [image_id, label, confidence, x1, y1, x2, y2]
+    if (output.dims == 4 && output.size[0] == 1 && output.size[1] == 1 &&
+        output.size[3] == 7 && output.type() == CV_32F) {
+        const int rows = output.size[2];
+        const float* data = output.ptr<float>();
+
+        std::vector<int> counts(batch_size, 0);
+        for (int r = 0; r < rows; ++r) {
+            int image = static_cast<int>(data[r * 7]);
+            if (image >= 0 && static_cast<size_t>(image) < batch_size) {
+                counts[image]++;
+            }
+        }
+
+        std::vector<int> filled(batch_size, 0);
+        for (size_t i = 0; i < batch_size; ++i) {
+            int shape[] = {1, 1, counts[i], 7};
+            parts[i].create(4, shape, CV_32F);
+        }
+        for (int r = 0; r < rows; ++r) {
+            int image = static_cast<int>(data[r * 7]);
+            if (image < 0 || static_cast<size_t>(image) >= batch_size) {
+                continue;
+            }
+            float* row = parts[image].ptr<float>() + filled[image]++ * 7;
+            std::copy(data + r * 7, data + r * 7 + 7, row);
+            row[0] = 0.0f;
+        }
+        return parts;
+    }
+
+    throw std::runtime_error("Cannot split network output with leading dimension " +
+                             std::to_string(output.dims > 0 ? output.size[0] : 0) +
+                             " into " + std::to_string(batch_size) + " images");
+}
+
+} // namespace vision
+} // namespace glooms
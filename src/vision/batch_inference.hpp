@@ -0,0 +1,116 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+struct BatchInferenceConfig {
+    // Model settings
+    std::string model_path;
+    bool use_gpu = true;
+
+    // Blob settings, matching VisionProcessor::runInference
+    int input_width = 416;
+    int input_height = 416;
+    double scale_factor = 1.0;
+    cv::Scalar mean = cv::Scalar(127.5, 127.5, 127.5);
+    bool swap_rb = true;
+
+    // Batching settings
+    int max_batch_size = 8;
+    std::chrono::microseconds max_latency{5000};    // Longest a frame waits for peers
+    size_t max_pending = 64;                        // submit() blocks beyond this
+};
+
+struct BatchInferenceMetrics {
+    uint64_t batches;
+    uint64_t frames;
+    double average_batch_size;
+    double average_forward_us;
+    size_t pending;
+};
+
+// Shared inference stage for many streams. Frames submitted from any
+// thread are grouped into one blob of up to max_batch_size images, run
+// through a single forward pass, and each caller receives the output
+// tensors for its own frame (leading dimension 1).
+class BatchInference {
+public:
+    explicit BatchInference(const BatchInferenceConfig& config);
+    ~BatchInference();
+
+    // Delete copy constructor and assignment operator
+    BatchInference(const BatchInference&) = delete;
+    BatchInference& operator=(const BatchInference&) = delete;
+
+    // Core methods
+    bool initialize();
+    void cleanup();
+    std::future<std::vector<cv::Mat>> submit(const cv::Mat& frame);
+
+    // Metrics and status
+    BatchInferenceMetrics getMetrics() const;
+    bool isInitialized() const { return is_initialized_; }
+    const BatchInferenceConfig& getConfig() const { return config_; }
+
+private:
+    struct Request {
+        cv::Mat frame;
+        std::promise<std::vector<cv::Mat>> result;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    // Configuration
+    BatchInferenceConfig config_;
+    bool is_initialized_;
+
+    // Neural network
+    cv::dnn::Net net_;
+    std::vector<std::string> output_names_;
+
+    // Request queue
+    mutable std::mutex mutex_;
+    std::condition_variable queue_ready_;
+    std::condition_variable queue_space_;
+    std::deque<Request> queue_;
+    std::atomic<bool> running_;
+    std::thread worker_;
+
+    // Batch buffers, reused across batches
+    std::vector<Request> batch_;
+    std::vector<cv::Mat> images_;
+    std::vector<cv::Mat> outputs_;
+    cv::Mat blob_;
+
+    // Metrics
+    std::atomic<uint64_t> batch_count_;
+    std::atomic<uint64_t> frame_count_;
+    std::atomic<uint64_t> forward_ns_;
+
+    // Internal helper methods
+    void workerLoop();
+    void runBatch();
+    std::vector<std::vector<cv::Mat>> scatterOutputs(size_t batch_size) const;
+};
+
+// Splits a batched output tensor into per-image tensors. 2D outputs are
+// split into equal row blocks, higher-rank outputs whose leading dimension
+// is the batch are sliced along it, and DetectionOutput style [1, 1, N, 7]
+// tensors are split by their image id column.
+std::vector<cv::Mat> splitBatchOutput(const cv::Mat& output, size_t batch_size);
+
+} // namespace vision
+} // namespace glooms
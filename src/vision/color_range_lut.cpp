@@ -0,0 +1,150 @@
+#include "vision/color_range_lut.hpp"
+#include "vision/simd.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    constexpr size_t kBitmapWords = (size_t(1) << 24) / 32;
+    constexpr int kRowsPerStripe = 16;
+
+    void applyRowScalar(const uchar* in, uchar* out, int begin, int cols, const uint32_t* bitmap) {
+        for (int x = begin; x < cols; ++x) {
+            const uchar* p = in + 3 * x;
+            uint32_t key = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+            // 0 or 0xFFFFFFFF, truncated to 0 or 255
+            out[x] = static_cast<uchar>(0u - ((bitmap[key >> 5] >> (key & 31)) & 1u));
+        }
+    }
+
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    // Looks up 8 pixels: the shuffle builds c0 << 16 | c1 << 8 | c2 keys
+    // from four packed pixels per 128-bit lane, then the word holding
+    // each key's bit is gathered
+    __attribute__((target("avx2")))
+    inline __m256i lookup8Avx2(const uchar* p, const uint32_t* bitmap) {
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        __m256i pixels = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+        __m256i keys = _mm256_shuffle_epi8(pixels, shuffle);
+        __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(bitmap),
+                                               _mm256_srli_epi32(keys, 5), 4);
+        __m256i bits = _mm256_srlv_epi32(words, _mm256_and_si256(keys, _mm256_set1_epi32(31)));
+        return _mm256_and_si256(bits, _mm256_set1_epi32(1));
+    }
+
+    __attribute__((target("avx2")))
+    int applyRowAvx2(const uchar* in, uchar* out, int cols, const uint32_t* bitmap) {
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        int x = 0;
+        // The last 16-byte load of a block reads 4 bytes past it
+        for (; x + 34 <= cols; x += 32) {
+            const uchar* p = in + 3 * x;
+            __m256i a = _mm256_packs_epi32(lookup8Avx2(p, bitmap), lookup8Avx2(p + 24, bitmap));
+            __m256i b = _mm256_packs_epi32(lookup8Avx2(p + 48, bitmap), lookup8Avx2(p + 72, bitmap));
+            // Packing interleaves 128-bit lanes; restore pixel order, then 1 -> 255
+            __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packs_epi16(a, b), order);
+            bytes = _mm256_sub_epi8(_mm256_setzero_si256(), bytes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), bytes);
+        }
+        return x;
+    }
+#endif
+}
+
+ColorRangeLut::ColorRangeLut()
+    : color_code_(-1) {}
+
+void ColorRangeLut::build(const cv::Scalar& lower, const cv::Scalar& upper, int color_code) {
+    TRACE_SPAN_CAT("ColorRangeLut::build", "vision");
+
+    std::vector<uint32_t> bitmap(kBitmapWords, 0);
+
+    // One 256x256 image per value of c0 covers every (c1, c2); each c0
+    // owns a disjoint 2048-word slice of the bitmap
+    cv::parallel_for_(cv::Range(0, 256), [&](const cv::Range& range) {
+        cv::Mat colors(256, 256, CV_8UC3);
+        cv::Mat converted;
+        cv::Mat inside;
+        for (int c1 = 0; c1 < 256; ++c1) {
+            uchar* row = colors.ptr<uchar>(c1);
+            for (int c2 = 0; c2 < 256; ++c2) {
+                row[3 * c2 + 1] = static_cast<uchar>(c1);
+                row[3 * c2 + 2] = static_cast<uchar>(c2);
+            }
+        }
+
+        for (int c0 = range.start; c0 < range.end; ++c0) {
+            for (int c1 = 0; c1 < 256; ++c1) {
+                uchar* row = colors.ptr<uchar>(c1);
+                for (int c2 = 0; c2 < 256; ++c2) {
+                    row[3 * c2] = static_cast<uchar>(c0);
+                }
+            }
+
+            cv::cvtColor(colors, converted, color_code);
+            cv::inRange(converted, lower, upper, inside);
+
+            uint32_t* words = bitmap.data() + (static_cast<size_t>(c0) << 11);
+            for (int c1 = 0; c1 < 256; ++c1) {
+                const uchar* flags = inside.ptr<uchar>(c1);
+                for (int c2 = 0; c2 < 256; ++c2) {
+                    if (flags[c2]) {
+                        words[(c1 << 3) + (c2 >> 5)] |= 1u << (c2 & 31);
+                    }
+                }
+            }
+        }
+    });
+
+    bitmap_.swap(bitmap);
+    lower_ = lower;
+    upper_ = upper;
+    color_code_ = color_code;
+}
+
+void ColorRangeLut::apply(const cv::Mat& input, cv::Mat& mask, bool allow_simd) const {
+    TRACE_SPAN_CAT("ColorRangeLut::apply", "vision");
+    CV_Assert(isBuilt());
+    CV_Assert(input.type() == CV_8UC3);
+
+    mask.create(input.size(), CV_8UC1);
+    static const bool has_avx2 = detectAvx2();
+    const bool simd = allow_simd && has_avx2;
+    const uint32_t* bitmap = bitmap_.data();
+#ifndef GLOOMS_HAVE_AVX2_KERNELS
+    (void)simd;
+#endif
+
+    cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            const uchar* in = input.ptr<uchar>(y);
+            uchar* out = mask.ptr<uchar>(y);
+            int done = 0;
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+            if (simd) {
+                done = applyRowAvx2(in, out, input.cols, bitmap);
+            }
+#endif
+            applyRowScalar(in, out, done, input.cols, bitmap);
+        }
+    }, std::max(1, input.rows / kRowsPerStripe));
+}
+
+void ColorRangeLut::clear() {
+    std::vector<uint32_t>().swap(bitmap_);
+    color_code_ = -1;
+}
+
+bool ColorRangeLut::matches(const cv::Scalar& lower, const cv::Scalar& upper, int color_code) const {
+    return isBuilt() && color_code == color_code_ && lower == lower_ && upper == upper_;
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// Colour segmentation as a single table lookup per pixel. build() runs
+// every 24-bit colour through cv::cvtColor(color_code) and cv::inRange
+// once and stores the membership as a 2 MiB bitmap, so apply() is
+// bit-exact with the convert-then-inRange path but needs no HSV
+// intermediate. The AVX2 variant gathers 8 table words at a time.
+class ColorRangeLut {
+public:
+    ColorRangeLut();
+
+    // Core methods
+    void build(const cv::Scalar& lower, const cv::Scalar& upper,
+               int color_code = cv::COLOR_RGB2HSV);
+    void apply(const cv::Mat& input, cv::Mat& mask, bool allow_simd = true) const;
+    void clear();
+
+    // True when built for exactly these parameters
+    bool matches(const cv::Scalar& lower, const cv::Scalar& upper,
+                 int color_code = cv::COLOR_RGB2HSV) const;
+    bool isBuilt() const { return !bitmap_.empty(); }
+
+private:
+    std::vector<uint32_t> bitmap_;      // Bit (c0 << 16 | c1 << 8 | c2)
+    cv::Scalar lower_;
+    cv::Scalar upper_;
+    int color_code_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,263 @@
+#include "vision/detection_decoder.hpp"
+#include "vision/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    constexpr int kRowsPerTask = 2048;
+
+    int argmaxScalar(const float* scores, int count, float& max_score) {
+        int best = 0;
+        float best_score = scores[0];
+        for (int i = 1; i < count; ++i) {
+            if (scores[i] > best_score) {
+                best_score = scores[i];
+                best = i;
+            }
+        }
+        max_score = best_score;
+        return best;
+    }
+
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    // Each lane keeps the first maximum it sees (strict compare); the
+    // reduction then breaks ties between lanes by lowest index, and the
+    // scalar tail only has later indices
+    __attribute__((target("avx2")))
+    int argmaxAvx2(const float* scores, int count, float& max_score) {
+        __m256 best = _mm256_loadu_ps(scores);
+        __m256i best_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i index = best_index;
+        const __m256i step = _mm256_set1_epi32(8);
+
+        int i = 8;
+        for (; i + 8 <= count; i += 8) {
+            index = _mm256_add_epi32(index, step);
+            __m256 values = _mm256_loadu_ps(scores + i);
+            __m256 greater = _mm256_cmp_ps(values, best, _CMP_GT_OQ);
+            best = _mm256_blendv_ps(best, values, greater);
+            best_index = _mm256_blendv_epi8(best_index, index, _mm256_castps_si256(greater));
+        }
+
+        alignas(32) float lane_scores[8];
+        alignas(32) int lane_indices[8];
+        _mm256_store_ps(lane_scores, best);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lane_indices), best_index);
+
+        float best_score = lane_scores[0];
+        int best_lane_index = lane_indices[0];
+        for (int lane = 1; lane < 8; ++lane) {
+            if (lane_scores[lane] > best_score ||
+                (lane_scores[lane] == best_score && lane_indices[lane] < best_lane_index)) {
+                best_score = lane_scores[lane];
+                best_lane_index = lane_indices[lane];
+            }
+        }
+
+        for (; i < count; ++i) {
+            if (scores[i] > best_score) {
+                best_score = scores[i];
+                best_lane_index = i;
+            }
+        }
+        max_score = best_score;
+        return best_lane_index;
+    }
+#endif
+
+    struct DecodeTask {
+        const float* data;
+        int rows;
+        int cols;
+    };
+}
+
+int argmaxScores(const float* scores, int count, float& max_score, bool allow_simd) {
+    static const bool has_avx2 = detectAvx2();
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    if (allow_simd && has_avx2 && count >= 16) {
+        return argmaxAvx2(scores, count, max_score);
+    }
+#else
+    (void)allow_simd;
+#endif
+    return argmaxScalar(scores, count, max_score);
+}
+
+void decodeDetectionRows(const float* data, int rows, int cols,
+                         const DecodeParams& params, std::vector<DecodedBox>& boxes) {
+    const int num_classes = cols - 5 - params.extra_columns;
+    if (num_classes <= 0) {
+        return;
+    }
+
+    const float threshold = params.confidence_threshold;
+    for (int r = 0; r < rows; ++r) {
+        const float* row = data + static_cast<size_t>(r) * cols;
+
+        // Every final score is at most the objectness, so a low one rules
+        // the row out without touching the class scores
+        const float objectness = row[4];
+        if (params.objectness_early_out && objectness <= threshold) {
+            continue;
+        }
+
+        float confidence;
+        int class_id = argmaxScores(row + 5, num_classes, confidence, params.allow_simd);
+        if (params.multiply_objectness) {
+            confidence *= objectness;
+        }
+        if (confidence <= threshold) {
+            continue;
+        }
+
+        float width = row[2] * params.scale_x;
+        float height = row[3] * params.scale_y;
+        float x = (row[0] - params.pad_x) * params.scale_x - width / 2;
+        float y = (row[1] - params.pad_y) * params.scale_y - height / 2;
+        boxes.push_back(DecodedBox{
+            class_id,
+            confidence,
+            cv::Rect(static_cast<int>(x), static_cast<int>(y),
+                     static_cast<int>(width), static_cast<int>(height)),
+            params.extra_columns > 0 ? row + 5 + num_classes : nullptr
+        });
+    }
+}
+
+void decodeDetectionOutputs(const std::vector<cv::Mat>& outputs,
+                            const DecodeParams& params, std::vector<DecodedBox>& boxes) {
+    // Split every output into row chunks so a single large tensor is
+    // spread across threads as well
+    std::vector<DecodeTask> tasks;
+    for (const auto& output : outputs) {
+        if (output.empty() || output.type() != CV_32F || !output.isContinuous()) {
+            continue;
+        }
+
+        int rows, cols;
+        if (output.dims == 2) {
+            rows = output.rows;
+            cols = output.cols;
+        } else if (output.dims == 3 && output.size[0] == 1) {
+            rows = output.size[1];
+            cols = output.size[2];
+        } else {
+            continue;
+        }
+
+        const float* data = output.ptr<float>();
+        for (int begin = 0; begin < rows; begin += kRowsPerTask) {
+            tasks.push_back(DecodeTask{
+                data + static_cast<size_t>(begin) * cols,
+                std::min(kRowsPerTask, rows - begin),
+                cols
+            });
+        }
+    }
+
+    if (tasks.size() == 1) {
+        decodeDetectionRows(tasks[0].data, tasks[0].rows, tasks[0].cols, params, boxes);
+        return;
+    }
+
+    std::vector<std::vector<DecodedBox>> partial(tasks.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tasks.size())), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; ++t) {
+            decodeDetectionRows(tasks[t].data, tasks[t].rows, tasks[t].cols, params, partial[t]);
+        }
+    });
+
+    for (const auto& part : partial) {
+        boxes.insert(boxes.end(), part.begin(), part.end());
+    }
+}
+
+void decodeKeypoints(const DetectionPayload& payload, int row, cv::Point origin,
+                     std::vector<cv::Point>& keypoints) {
+    keypoints.clear();
+    if (payload.num_keypoints <= 0 || row < 0 || row >= payload.extras.rows) {
+        return;
+    }
+
+    const LetterboxTransform& t = payload.transform;
+    const float* values = payload.extras.ptr<float>(row) + payload.mask_channels;
+    keypoints.reserve(payload.num_keypoints);
+    for (int k = 0; k < payload.num_keypoints; ++k, values += 3) {
+        if (values[2] < payload.keypoint_threshold) {
+            keypoints.emplace_back(-1, -1);
+            continue;
+        }
+        keypoints.emplace_back(
+            static_cast<int>((values[0] - t.pad_x) / t.scale_x) + origin.x,
+            static_cast<int>((values[1] - t.pad_y) / t.scale_y) + origin.y);
+    }
+}
+
+RleMask decodeMask(const DetectionPayload& payload, int row, const cv::Rect& box, cv::Point origin) {
+    if (payload.mask_channels <= 0 || payload.prototypes.dims != 4 ||
+        row < 0 || row >= payload.extras.rows || box.area() <= 0) {
+        return RleMask();
+    }
+
+    const int channels = payload.prototypes.size[1];
+    const int proto_h = payload.prototypes.size[2];
+    const int proto_w = payload.prototypes.size[3];
+    const size_t plane = static_cast<size_t>(proto_h) * proto_w;
+    const LetterboxTransform& t = payload.transform;
+
+    // Prototype cell under each mask column and row: frame pixel centre
+    // -> network input -> prototype grid
+    auto cell = [](float frame, float scale, float pad, int input, int proto) {
+        float position = (frame * scale + pad) * proto / input;
+        return std::clamp(static_cast<int>(position), 0, proto - 1);
+    };
+    std::vector<int> columns(box.width);
+    std::vector<int> rows(box.height);
+    for (int u = 0; u < box.width; ++u) {
+        columns[u] = cell(box.x - origin.x + u + 0.5f, t.scale_x, t.pad_x, payload.input_size.width, proto_w);
+    }
+    for (int v = 0; v < box.height; ++v) {
+        rows[v] = cell(box.y - origin.y + v + 0.5f, t.scale_y, t.pad_y, payload.input_size.height, proto_h);
+    }
+
+    // Logits over the prototype cells the box covers
+    const int cx0 = columns.front();
+    const int cy0 = rows.front();
+    const int cells_w = columns.back() - cx0 + 1;
+    const int cells_h = rows.back() - cy0 + 1;
+    const float* coefficients = payload.extras.ptr<float>(row);
+    const float* prototypes = payload.prototypes.ptr<float>();
+    cv::Mat logits(cells_h, cells_w, CV_32F, cv::Scalar(0));
+    for (int c = 0; c < channels && c < payload.mask_channels; ++c) {
+        const float* proto = prototypes + c * plane;
+        const float coefficient = coefficients[c];
+        for (int y = 0; y < cells_h; ++y) {
+            const float* in = proto + static_cast<size_t>(cy0 + y) * proto_w + cx0;
+            float* out = logits.ptr<float>(y);
+            for (int x = 0; x < cells_w; ++x) {
+                out[x] += coefficient * in[x];
+            }
+        }
+    }
+
+    // sigmoid(logit) > threshold, compared in logit space
+    const float threshold = std::clamp(payload.mask_threshold, 1e-6f, 1.0f - 1e-6f);
+    const float logit_threshold = std::log(threshold / (1.0f - threshold));
+    cv::Mat mask(box.height, box.width, CV_8UC1);
+    for (int v = 0; v < box.height; ++v) {
+        const float* in = logits.ptr<float>(rows[v] - cy0);
+        uchar* out = mask.ptr<uchar>(v);
+        for (int u = 0; u < box.width; ++u) {
+            out[u] = in[columns[u] - cx0] > logit_threshold ? 255 : 0;
+        }
+    }
+    return RleMask::encode(mask);
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
+
+#include "vision/letterbox.hpp"
+#include "vision/rle_mask.hpp"
+
+namespace glooms {
+namespace vision {
+
+// A decoded candidate, before class names and NMS
+struct DecodedBox {
+    int class_id;
+    float confidence;
+    cv::Rect box;
+    const float* extra;                 // Trailing columns of the row, if any
+};
+
+struct DecodeParams {
+    float confidence_threshold = 0.5f;
+    // Network input to frame coordinates: frame = (input - pad) * scale
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    float pad_x = 0.0f;                 // Letterbox border, in input pixels
+    float pad_y = 0.0f;
+    // Reject rows whose objectness (column 4) is at or below the threshold
+    // before scanning class scores. Exact when class scores are already
+    // scaled by objectness (Darknet region layers) or multiply_objectness
+    // is set.
+    bool objectness_early_out = true;
+    bool multiply_objectness = false;   // Confidence = objectness * class score
+    int extra_columns = 0;              // Trailing non-class columns (mask coefficients, keypoints)
+    bool allow_simd = true;
+};
+
+// What lazy mask and keypoint decoding needs from one image's outputs.
+// The network reuses its output buffers, so the trailing columns of each
+// candidate and the mask prototypes are copied out; everything else is
+// decoded only when a detection's mask or keypoints are first read.
+struct DetectionPayload {
+    cv::Mat extras;                     // One row of trailing columns per candidate
+    cv::Mat prototypes;                 // [1, C, h, w] mask prototypes, or empty
+    LetterboxTransform transform;       // Frame to network input
+    cv::Size input_size;
+    int mask_channels = 0;              // Leading extra columns: mask coefficients
+    int num_keypoints = 0;              // Then (x, y, confidence) per keypoint
+    float mask_threshold = 0.5f;
+    float keypoint_threshold = 0.5f;
+};
+
+// Keypoints of candidate `row` in frame coordinates, shifted by `origin`;
+// points below the keypoint threshold are (-1, -1) so indices stay stable
+void decodeKeypoints(const DetectionPayload& payload, int row, cv::Point origin,
+                     std::vector<cv::Point>& keypoints);
+
+// Mask of candidate `row` over `box` (frame coordinates, shifted by
+// `origin`), with the mask prototypes evaluated only under the box
+RleMask decodeMask(const DetectionPayload& payload, int row, const cv::Rect& box, cv::Point origin);
+
+// Index of the first maximum of `count` floats, as cv::minMaxLoc reports it
+int argmaxScores(const float* scores, int count, float& max_score, bool allow_simd = true);
+
+// Decodes YOLO-style rows [cx, cy, w, h, objectness, class scores...] read
+// straight from a float buffer, appending candidates above the threshold
+void decodeDetectionRows(const float* data, int rows, int cols,
+                         const DecodeParams& params, std::vector<DecodedBox>& boxes);
+
+// Decodes every output tensor (2D, or 3D with a leading 1) in parallel.
+// Candidates come back in output and row order.
+void decodeDetectionOutputs(const std::vector<cv::Mat>& outputs,
+                            const DecodeParams& params, std::vector<DecodedBox>& boxes);
+
+} // namespace vision
+} // namespace glooms
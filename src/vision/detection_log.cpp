@@ -0,0 +1,550 @@
+#include "vision/detection_log.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    constexpr uint32_t LOG_VERSION = 1;
+    constexpr char RECORDS_MAGIC[8] = {'G', 'L', 'M', 'D', 'E', 'T', 'S', '\0'};
+    constexpr char INDEX_MAGIC[8] = {'G', 'L', 'M', 'D', 'I', 'D', 'X', '\0'};
+
+    std::string recordsPath(const std::string& path) { return path + ".dets"; }
+    std::string indexPath(const std::string& path) { return path + ".idx"; }
+    std::string namesPath(const std::string& path) { return path + ".names"; }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // Cuts a record file back to `count` complete records
+    bool truncateRecords(int fd, uint64_t count, size_t record_size) {
+        off_t size = static_cast<off_t>(sizeof(DetectionLogHeader) + count * record_size);
+        while (::ftruncate(fd, size) != 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool validHeader(const DetectionLogHeader& header, const char* magic, uint32_t record_size) {
+        return std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 &&
+               header.version == LOG_VERSION &&
+               header.record_size == record_size;
+    }
+
+    // Opens (or creates) one of the log's record files for appending and
+    // returns the number of complete records already in it. A torn record
+    // left by a crash is cut off so appends stay aligned.
+    int openForAppend(const std::string& path, const char* magic, uint32_t record_size,
+                      bool truncate, uint64_t& count) {
+        int flags = O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC;
+        if (truncate) {
+            flags |= O_TRUNC;
+        }
+        int fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) {
+            return -1;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return -1;
+        }
+
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size == 0) {
+            DetectionLogHeader header{};
+            std::memcpy(header.magic, magic, sizeof(header.magic));
+            header.version = LOG_VERSION;
+            header.record_size = record_size;
+            if (!writeAll(fd, &header, sizeof(header))) {
+                ::close(fd);
+                return -1;
+            }
+            count = 0;
+            return fd;
+        }
+
+        DetectionLogHeader header{};
+        if (size < sizeof(header) ||
+            ::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            !validHeader(header, magic, record_size)) {
+            ::close(fd);
+            return -1;
+        }
+
+        count = (size - sizeof(header)) / record_size;
+        size_t complete = sizeof(header) + count * record_size;
+        if (complete != size && ::ftruncate(fd, static_cast<off_t>(complete)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::vector<std::string> readClassNames(const std::string& path) {
+        std::vector<std::string> names;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            names.push_back(line);
+        }
+        return names;
+    }
+
+    // Maps a whole file read-only, returning the number of complete
+    // records after a valid header
+    const void* mapRecords(const std::string& path, const char* magic, uint32_t record_size,
+                           void*& map, size_t& map_size, size_t& count) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(DetectionLogHeader)) {
+            ::close(fd);
+            return nullptr;
+        }
+
+        map_size = static_cast<size_t>(st.st_size);
+        map = ::mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            map = nullptr;
+            map_size = 0;
+            return nullptr;
+        }
+
+        const auto* header = static_cast<const DetectionLogHeader*>(map);
+        if (!validHeader(*header, magic, record_size)) {
+            ::munmap(map, map_size);
+            map = nullptr;
+            map_size = 0;
+            return nullptr;
+        }
+
+        count = (map_size - sizeof(DetectionLogHeader)) / record_size;
+        return static_cast<const char*>(map) + sizeof(DetectionLogHeader);
+    }
+}
+
+DetectionLogWriter::DetectionLogWriter(const DetectionLogConfig& config)
+    : config_(config)
+    , is_initialized_(false)
+    , records_fd_(-1)
+    , index_fd_(-1)
+    , names_dirty_(false)
+    , flush_requested_(false)
+    , writing_(false)
+    , running_(false)
+    , records_on_disk_(0)
+    , index_on_disk_(0)
+    , write_failed_(false)
+    , frame_count_(0)
+    , record_count_(0)
+    , flush_count_(0)
+    , bytes_written_(0)
+    , write_errors_(0) {
+    initialize();
+}
+
+DetectionLogWriter::~DetectionLogWriter() {
+    cleanup();
+}
+
+bool DetectionLogWriter::initialize() {
+    if (is_initialized_) {
+        return true;
+    }
+    if (config_.path.empty()) {
+        return false;
+    }
+
+    records_fd_ = openForAppend(recordsPath(config_.path), RECORDS_MAGIC, sizeof(DetectionRecord),
+                                config_.truncate, records_on_disk_);
+    index_fd_ = openForAppend(indexPath(config_.path), INDEX_MAGIC, sizeof(FrameIndexEntry),
+                              config_.truncate, index_on_disk_);
+    if (records_fd_ < 0 || index_fd_ < 0) {
+        closeFiles();
+        return false;
+    }
+
+    if (config_.truncate) {
+        class_names_.clear();
+        std::remove(namesPath(config_.path).c_str());
+    } else {
+        class_names_ = readClassNames(namesPath(config_.path));
+    }
+    names_dirty_ = false;
+    write_failed_ = false;
+
+    size_t reserve_records = config_.buffer_size / sizeof(DetectionRecord);
+    front_.records.reserve(reserve_records);
+    back_.records.reserve(reserve_records);
+
+    running_ = true;
+    writer_ = std::thread(&DetectionLogWriter::writerLoop, this);
+    is_initialized_ = true;
+    return true;
+}
+
+void DetectionLogWriter::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    flush_ready_.notify_all();
+
+    // The writer drains the front buffer before exiting
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    closeFiles();
+    is_initialized_ = false;
+}
+
+void DetectionLogWriter::closeFiles() {
+    if (records_fd_ >= 0) {
+        ::close(records_fd_);
+        records_fd_ = -1;
+    }
+    if (index_fd_ >= 0) {
+        ::close(index_fd_);
+        index_fd_ = -1;
+    }
+}
+
+bool DetectionLogWriter::append(uint32_t stream_id, uint64_t frame_number,
+                                const std::vector<Detection>& detections) {
+    TRACE_SPAN_CAT("DetectionLogWriter::append", "vision");
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return false;
+        }
+
+        // Offset within the buffer; the writer rebases it onto the file
+        front_.frames.push_back(FrameIndexEntry{
+            frame_number,
+            front_.records.size(),
+            stream_id,
+            static_cast<uint32_t>(detections.size())
+        });
+
+        for (const auto& det : detections) {
+            front_.records.push_back(DetectionRecord{
+                det.class_id,
+                det.confidence,
+                det.box.x,
+                det.box.y,
+                det.box.width,
+                det.box.height,
+                det.track_id,
+                0
+            });
+
+            // Class names are learned from the detections themselves
+            if (det.class_id >= 0 && !det.class_name.empty()) {
+                size_t id = static_cast<size_t>(det.class_id);
+                if (id >= class_names_.size()) {
+                    class_names_.resize(id + 1);
+                }
+                if (class_names_[id].empty()) {
+                    class_names_[id] = det.class_name;
+                    names_dirty_ = true;
+                }
+            }
+        }
+
+        // Only the transition past the threshold needs a wake-up
+        wake = front_.bytes() >= config_.buffer_size && !writing_;
+    }
+    frame_count_++;
+    record_count_ += detections.size();
+
+    if (wake) {
+        flush_ready_.notify_one();
+    }
+    return true;
+}
+
+bool DetectionLogWriter::append(uint32_t stream_id, const DetectionResult& result) {
+    if (!result.success) {
+        return false;
+    }
+    return append(stream_id, result.frame_number, result.detections);
+}
+
+void DetectionLogWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        return;
+    }
+    flush_requested_ = true;
+    flush_ready_.notify_one();
+    flush_done_.wait(lock, [this] {
+        return !running_ || (front_.empty() && !writing_);
+    });
+}
+
+void DetectionLogWriter::writerLoop() {
+    glooms::utils::Tracer::instance().setThreadName("vision-detection-log");
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        flush_ready_.wait_for(lock, config_.flush_interval, [this] {
+            return !running_ || flush_requested_ || front_.bytes() >= config_.buffer_size;
+        });
+        flush_requested_ = false;
+
+        if (front_.empty()) {
+            if (!running_) {
+                break;  // Stopped and drained
+            }
+            flush_done_.notify_all();
+            continue;
+        }
+
+        std::swap(front_, back_);
+        std::vector<std::string> names;
+        if (names_dirty_) {
+            names = class_names_;
+            names_dirty_ = false;
+        }
+        writing_ = true;
+        lock.unlock();
+
+        // The sidecar goes first so names exist for every written record
+        if (!names.empty() && !writeClassNames(names)) {
+            write_errors_++;
+        }
+        if (!writeBuffer(back_)) {
+            write_errors_++;
+        }
+        back_.clear();
+        flush_count_++;
+
+        lock.lock();
+        writing_ = false;
+        flush_done_.notify_all();
+    }
+    flush_done_.notify_all();
+}
+
+bool DetectionLogWriter::writeBuffer(Buffer& buffer) {
+    TRACE_SPAN_CAT("DetectionLogWriter::writeBuffer", "vision");
+
+    if (write_failed_) {
+        return false;
+    }
+
+    for (auto& entry : buffer.frames) {
+        entry.first_record += records_on_disk_;
+    }
+
+    size_t record_bytes = buffer.records.size() * sizeof(DetectionRecord);
+    size_t index_bytes = buffer.frames.size() * sizeof(FrameIndexEntry);
+
+    // Records before the index entries that refer to them
+    if (!writeAll(records_fd_, buffer.records.data(), record_bytes) ||
+        !writeAll(index_fd_, buffer.frames.data(), index_bytes)) {
+        // Drop the whole batch, including any partial write, so the next
+        // one starts where records_on_disk_ says
+        if (!truncateRecords(records_fd_, records_on_disk_, sizeof(DetectionRecord)) ||
+            !truncateRecords(index_fd_, index_on_disk_, sizeof(FrameIndexEntry))) {
+            write_failed_ = true;
+        }
+        return false;
+    }
+
+    records_on_disk_ += buffer.records.size();
+    index_on_disk_ += buffer.frames.size();
+    bytes_written_ += record_bytes + index_bytes;
+    return true;
+}
+
+bool DetectionLogWriter::writeClassNames(const std::vector<std::string>& names) {
+    // Replace the sidecar atomically so readers never see half a table
+    std::string path = namesPath(config_.path);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        for (const auto& name : names) {
+            file << name << '\n';
+        }
+        if (!file) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+DetectionLogMetrics DetectionLogWriter::getMetrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DetectionLogMetrics{
+        frame_count_.load(),
+        record_count_.load(),
+        flush_count_.load(),
+        bytes_written_.load(),
+        write_errors_.load()
+    };
+}
+
+DetectionLogReader::DetectionLogReader()
+    : records_map_(nullptr)
+    , records_map_size_(0)
+    , index_map_(nullptr)
+    , index_map_size_(0)
+    , records_(nullptr)
+    , entries_(nullptr)
+    , record_count_(0)
+    , frame_count_(0) {}
+
+DetectionLogReader::~DetectionLogReader() {
+    close();
+}
+
+bool DetectionLogReader::open(const std::string& path) {
+    TRACE_SPAN_CAT("DetectionLogReader::open", "vision");
+    close();
+
+    records_ = static_cast<const DetectionRecord*>(mapRecords(
+        recordsPath(path), RECORDS_MAGIC, sizeof(DetectionRecord),
+        records_map_, records_map_size_, record_count_));
+    entries_ = static_cast<const FrameIndexEntry*>(mapRecords(
+        indexPath(path), INDEX_MAGIC, sizeof(FrameIndexEntry),
+        index_map_, index_map_size_, frame_count_));
+    if (!records_ || !entries_) {
+        close();
+        return false;
+    }
+
+    // Index entries past the last complete record belong to a write that
+    // was still in flight and are left out
+    for (size_t i = 0; i < frame_count_; ++i) {
+        const FrameIndexEntry& entry = entries_[i];
+        if (entry.first_record + entry.count > record_count_) {
+            continue;
+        }
+        streams_[entry.stream_id].emplace_back(entry.frame_number, i);
+    }
+    for (auto& [stream_id, frames] : streams_) {
+        std::stable_sort(frames.begin(), frames.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+    }
+
+    class_names_ = readClassNames(namesPath(path));
+    return true;
+}
+
+void DetectionLogReader::close() {
+    if (records_map_) {
+        ::munmap(records_map_, records_map_size_);
+    }
+    if (index_map_) {
+        ::munmap(index_map_, index_map_size_);
+    }
+    records_map_ = nullptr;
+    records_map_size_ = 0;
+    index_map_ = nullptr;
+    index_map_size_ = 0;
+    records_ = nullptr;
+    entries_ = nullptr;
+    record_count_ = 0;
+    frame_count_ = 0;
+    streams_.clear();
+    class_names_.clear();
+}
+
+bool DetectionLogReader::read(uint32_t stream_id, uint64_t frame_number,
+                              std::vector<Detection>& detections) const {
+    detections.clear();
+
+    auto stream = streams_.find(stream_id);
+    if (stream == streams_.end()) {
+        return false;
+    }
+
+    const auto& frames = stream->second;
+    auto it = std::upper_bound(frames.begin(), frames.end(), frame_number,
+        [](uint64_t number, const auto& frame) { return number < frame.first; });
+    if (it == frames.begin() || std::prev(it)->first != frame_number) {
+        return false;
+    }
+
+    const FrameIndexEntry& entry = entries_[std::prev(it)->second];
+    detections.reserve(entry.count);
+    for (uint32_t i = 0; i < entry.count; ++i) {
+        const DetectionRecord& record = records_[entry.first_record + i];
+        Detection det;
+        det.class_id = record.class_id;
+        det.confidence = record.confidence;
+        det.box = cv::Rect(record.x, record.y, record.width, record.height);
+        det.track_id = record.track_id;
+        if (record.class_id >= 0 && static_cast<size_t>(record.class_id) < class_names_.size()) {
+            det.class_name = class_names_[record.class_id];
+        }
+        detections.push_back(std::move(det));
+    }
+    return true;
+}
+
+std::vector<uint32_t> DetectionLogReader::streams() const {
+    std::vector<uint32_t> ids;
+    ids.reserve(streams_.size());
+    for (const auto& [stream_id, frames] : streams_) {
+        ids.push_back(stream_id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<uint64_t> DetectionLogReader::frames(uint32_t stream_id) const {
+    std::vector<uint64_t> numbers;
+    auto stream = streams_.find(stream_id);
+    if (stream == streams_.end()) {
+        return numbers;
+    }
+    numbers.reserve(stream->second.size());
+    for (const auto& frame : stream->second) {
+        if (numbers.empty() || numbers.back() != frame.first) {
+            numbers.push_back(frame.first);
+        }
+    }
+    return numbers;
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vision/detector.hpp"
+
+namespace glooms {
+namespace vision {
+
+// On-disk layout, in native byte order. A log at <path> is three files:
+//   <path>.dets   header + DetectionRecord per detection
+//   <path>.idx    header + FrameIndexEntry per logged frame
+//   <path>.names  class names, one per line, line number = class id
+// Records are written before the index entries that refer to them, so
+// every complete index entry points at records already on disk.
+struct DetectionLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+struct DetectionRecord {
+    int32_t class_id;
+    float confidence;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    int32_t track_id;
+    uint32_t reserved;
+};
+
+struct FrameIndexEntry {
+    uint64_t frame_number;
+    uint64_t first_record;
+    uint32_t stream_id;
+    uint32_t count;
+};
+
+static_assert(sizeof(DetectionRecord) == 32, "DetectionRecord is part of the file format");
+static_assert(sizeof(FrameIndexEntry) == 24, "FrameIndexEntry is part of the file format");
+
+struct DetectionLogConfig {
+    std::string path;                                   // Without extension
+    bool truncate = false;                              // Appends to an existing log otherwise
+    size_t buffer_size = 1024 * 1024;                   // Bytes buffered before a hand-off
+    std::chrono::milliseconds flush_interval{1000};     // Longest data sits unwritten
+};
+
+struct DetectionLogMetrics {
+    uint64_t frames;
+    uint64_t records;
+    uint64_t flushes;
+    uint64_t bytes_written;
+    uint64_t write_errors;
+};
+
+// Append-only log of every frame's detections across streams. Masks and
+// keypoints are not logged; use utils::saveDetections for those.
+//
+// append() copies records into the front buffer under a short lock and
+// returns. A background thread swaps the front and back buffers once the
+// front holds buffer_size bytes (or flush_interval passes) and writes
+// the back buffer out, so frame threads never wait on the disk. If the
+// disk falls behind, the front buffer grows rather than blocking. A batch
+// that fails to write is cut back off both files and counted in
+// write_errors; later batches still land where their index says.
+class DetectionLogWriter {
+public:
+    explicit DetectionLogWriter(const DetectionLogConfig& config);
+    ~DetectionLogWriter();
+
+    // Delete copy constructor and assignment operator
+    DetectionLogWriter(const DetectionLogWriter&) = delete;
+    DetectionLogWriter& operator=(const DetectionLogWriter&) = delete;
+
+    // Core methods
+    bool initialize();
+    void cleanup();
+    bool append(uint32_t stream_id, uint64_t frame_number, const std::vector<Detection>& detections);
+    bool append(uint32_t stream_id, const DetectionResult& result);
+    // Blocks until everything appended so far is written
+    void flush();
+
+    // Metrics and status
+    DetectionLogMetrics getMetrics() const;
+    bool isInitialized() const { return is_initialized_; }
+    const DetectionLogConfig& getConfig() const { return config_; }
+
+private:
+    struct Buffer {
+        std::vector<DetectionRecord> records;
+        std::vector<FrameIndexEntry> frames;
+
+        size_t bytes() const {
+            return records.size() * sizeof(DetectionRecord) + frames.size() * sizeof(FrameIndexEntry);
+        }
+        bool empty() const { return frames.empty(); }
+        void clear() {
+            records.clear();
+            frames.clear();
+        }
+    };
+
+    // Configuration
+    DetectionLogConfig config_;
+    bool is_initialized_;
+
+    // Files
+    int records_fd_;
+    int index_fd_;
+
+    // Buffers and class table, guarded by mutex_. back_ belongs to the
+    // writer thread between swaps.
+    mutable std::mutex mutex_;
+    std::condition_variable flush_ready_;
+    std::condition_variable flush_done_;
+    Buffer front_;
+    Buffer back_;
+    std::vector<std::string> class_names_;
+    bool names_dirty_;
+    bool flush_requested_;
+    bool writing_;
+    bool running_;
+    std::thread writer_;
+
+    // Complete records and index entries on disk, owned by the writer
+    // thread. Index entries are rebased onto records_on_disk_ as written.
+    uint64_t records_on_disk_;
+    uint64_t index_on_disk_;
+    bool write_failed_;                 // Files could not be cut back; no more writes
+
+    // Metrics
+    std::atomic<uint64_t> frame_count_;
+    std::atomic<uint64_t> record_count_;
+    std::atomic<uint64_t> flush_count_;
+    std::atomic<uint64_t> bytes_written_;
+    std::atomic<uint64_t> write_errors_;
+
+    // Internal helper methods
+    void writerLoop();
+    bool writeBuffer(Buffer& buffer);
+    bool writeClassNames(const std::vector<std::string>& names);
+    void closeFiles();
+};
+
+// Random access to a log by (stream, frame). The record and index files
+// are mapped read-only; opening builds a per-stream frame table and
+// reads touch only the mapped pages of the requested frame. Reopen to see
+// frames appended since.
+class DetectionLogReader {
+public:
+    DetectionLogReader();
+    ~DetectionLogReader();
+
+    // Delete copy constructor and assignment operator
+    DetectionLogReader(const DetectionLogReader&) = delete;
+    DetectionLogReader& operator=(const DetectionLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return records_ != nullptr; }
+
+    // False when the frame was not logged. A frame logged more than once
+    // reads back its last entry.
+    bool read(uint32_t stream_id, uint64_t frame_number, std::vector<Detection>& detections) const;
+
+    std::vector<uint32_t> streams() const;
+    std::vector<uint64_t> frames(uint32_t stream_id) const;   // Ascending
+    size_t frameCount() const { return frame_count_; }
+    size_t recordCount() const { return record_count_; }
+    const std::vector<std::string>& classNames() const { return class_names_; }
+
+private:
+    // Mappings
+    void* records_map_;
+    size_t records_map_size_;
+    void* index_map_;
+    size_t index_map_size_;
+    const DetectionRecord* records_;
+    const FrameIndexEntry* entries_;
+    size_t record_count_;
+    size_t frame_count_;
+
+    // (frame number, entry) pairs per stream, sorted by frame number
+    std::unordered_map<uint32_t, std::vector<std::pair<uint64_t, size_t>>> streams_;
+    std::vector<std::string> class_names_;
+};
+
+} // namespace vision
+} // namespace glooms
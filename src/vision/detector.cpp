@@ -1,7 +1,10 @@
 #include "vision/detector.hpp"
+#include "vision/batch_inference.hpp"
+#include "vision/detection_decoder.hpp"
 #include "utils/logger.hpp"
 
 #include <opencv2/dnn.hpp>
+#include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/cudaimgproc.hpp>
 #include <fstream>
@@ -10,11 +13,71 @@
 namespace glooms {
 namespace vision {
 
+namespace {
+
+// INT8 runs only on the CPU backend
+bool wantsInt8(const DetectorConfig& config) {
+    return config.enable_int8 && !(config.use_gpu && cv::cuda::getCudaEnabledDeviceCount() > 0);
+}
+
+std::string int8WeightsPath(const DetectorConfig& config) {
+    return config.int8_model_weights.empty() ? int8ModelPath(config.model_weights) : config.int8_model_weights;
+}
+
+// Calibration frames go through the same letterboxing as inference
+std::vector<cv::Mat> loadCalibrationBlobs(const DetectorConfig& config) {
+    std::vector<cv::Mat> calibration;
+    if (config.int8_calibration_dir.empty()) {
+        return calibration;
+    }
+
+    LetterboxParams params;
+    params.input_size = cv::Size(config.input_width, config.input_height);
+    params.keep_aspect = config.maintain_aspect_ratio;
+    params.pad_value = config.letterbox_pad_value;
+
+    Letterbox letterbox;
+    auto images = listImages(config.int8_calibration_dir,
+                             static_cast<size_t>(std::max(1, config.int8_calibration_frames)));
+    for (const auto& image_path : images) {
+        cv::Mat image = cv::imread(image_path, cv::IMREAD_COLOR);
+        if (image.empty()) {
+            continue;
+        }
+        cv::Mat blob;
+        Letterbox::ensureBlob(blob, 1, params.input_size);
+        letterbox.run(image, blob, 0, params);
+        calibration.push_back(blob);
+    }
+    return calibration;
+}
+
+} // namespace
+
 Detector::Detector(const DetectorConfig& config)
     : config_(config)
     , logger_("VisionDetector")
     , detection_count_(0)
-    , is_initialized_(false) {
+    , is_initialized_(false)
+    , gpu_enabled_(false)
+    , int8_enabled_(false)
+    , tile_cursor_(0)
+    , tiles_run_(0)
+    , tiles_skipped_(0) {
+    initialize();
+}
+
+Detector::Detector(const DetectorConfig& config, std::shared_ptr<const ModelBuffer> model)
+    : config_(config)
+    , logger_("VisionDetector")
+    , detection_count_(0)
+    , is_initialized_(false)
+    , gpu_enabled_(false)
+    , int8_enabled_(false)
+    , tile_cursor_(0)
+    , tiles_run_(0)
+    , tiles_skipped_(0)
+    , model_(std::move(model)) {
     initialize();
 }
 
@@ -36,7 +99,11 @@ bool Detector::initialize() {
         }
 
         // Load neural network
-        net_ = cv::dnn::readNet(config_.model_weights, config_.model_config);
+        if (model_) {
+            net_ = cv::dnn::readNet(model_->framework, model_->weights, model_->config);
+        } else {
+            net_ = cv::dnn::readNet(config_.model_weights, config_.model_config);
+        }
         
         // Configure backend
         if (config_.use_gpu && cv::cuda::getCudaEnabledDeviceCount() > 0) {
@@ -49,6 +116,7 @@ bool Detector::initialize() {
             net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
             gpu_enabled_ = false;
             logger_.warn("Using CPU for detection");
+            initializeInt8();
         }
 
         // Initialize output layer names
@@ -64,6 +132,63 @@ bool Detector::initialize() {
     }
 }
 
+void Detector::initializeInt8() {
+    int8_enabled_ = false;
+    if (!config_.enable_int8) {
+        return;
+    }
+
+    // A pool's detectors share the model bytes and calibration blobs
+    // loaded once by loadModelBuffer(); standalone ones read them here
+    std::string path = int8WeightsPath(config_);
+    try {
+        cv::dnn::Net quantized;
+        if (model_ && !model_->int8_weights.empty()) {
+            quantized = cv::dnn::readNet("onnx", model_->int8_weights);
+        } else if (!model_ && !path.empty() && std::ifstream(path).good()) {
+            quantized = cv::dnn::readNet(path);
+        }
+        if (!quantized.empty()) {
+            quantized.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
+            quantized.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            net_ = quantized;
+            int8_enabled_ = true;
+            logger_.info("Using INT8 model: " + path);
+            return;
+        }
+    } catch (const cv::Exception& e) {
+        logger_.warn("Failed to load INT8 model, using FP32: " + std::string(e.what()));
+    }
+
+    if (config_.int8_calibration_dir.empty()) {
+        return;
+    }
+
+    std::vector<cv::Mat> loaded;
+    if (!model_) {
+        loaded = loadCalibrationBlobs(config_);
+    }
+    const std::vector<cv::Mat>& calibration = model_ ? model_->calibration : loaded;
+    if (calibration.empty()) {
+        logger_.warn("No calibration frames in " + config_.int8_calibration_dir + ", using FP32");
+        return;
+    }
+
+    std::string error;
+    if (!quantizeNet(net_, calibration, config_.int8_per_channel, error)) {
+        logger_.warn("INT8 quantization failed, using FP32: " + error);
+        return;
+    }
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    int8_enabled_ = true;
+    logger_.info("Quantized model to INT8 with " + std::to_string(calibration.size()) + " calibration frames");
+}
+
+bool Detector::getQuantizationDetails(QuantizationDetails& details) const {
+    return int8_enabled_ && vision::getQuantizationDetails(net_, details);
+}
+
 void Detector::cleanup() {
     net_.clear();
     class_names_.clear();
@@ -77,37 +202,30 @@ DetectionResult Detector::detect(const cv::Mat& frame) {
     }
 
     try {
-        detection_count_++;
+        const uint64_t frame_number = ++detection_count_;
         std::vector<Detection> detections;
 
-        // Create blob from image
-        cv::Mat blob = cv::dnn::blobFromImage(
-            frame, 
-            1/255.0,
-            cv::Size(config_.input_width, config_.input_height),
-            cv::Scalar(0,0,0),
-            true, 
-            false
-        );
-
-        // Run inference
-        net_.setInput(blob);
-        std::vector<cv::Mat> outputs;
-        net_.forward(outputs, output_names_);
-
-        // Process detections
-        processDetections(frame, outputs, detections);
+        // Tiling only pays off when the frame is larger than the model input
+        if (config_.enable_tiling &&
+            (frame.cols > config_.input_width || frame.rows > config_.input_height)) {
+            detectTiled(frame, detections);
+        } else {
+            detectFullFrame(frame, config_.confidence_threshold, detections);
+        }
 
-        // Apply non-maximum suppression if enabled
+        // Apply non-maximum suppression if enabled; with tiling this also
+        // merges duplicates across tile overlaps
         if (config_.enable_nms) {
-            applyNMS(detections);
+            applyNMS(detections, scratch_);
         }
+        FLIGHT_RECORD(glooms::utils::LogLevel::DEBUG, "Detector frame {}: {} detections",
+                      frame_number, detections.size());
 
         return DetectionResult{
             true,
             "Detection successful",
             detections,
-            detection_count_
+            frame_number
         };
 
     } catch (const std::exception& e) {
@@ -116,78 +234,411 @@ DetectionResult Detector::detect(const cv::Mat& frame) {
     }
 }
 
-void Detector::processDetections(
+std::vector<DetectionResult> Detector::detectBatch(const std::vector<cv::Mat>& frames) {
+    std::vector<DetectionResult> results(frames.size());
+    if (!is_initialized_) {
+        for (auto& result : results) {
+            result = DetectionResult{false, "Detector not initialized"};
+        }
+        return results;
+    }
+
+    // Tiling already batches the tiles of each frame
+    if (!config_.enable_batch_processing || config_.enable_tiling) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            results[i] = detect(frames[i]);
+        }
+        return results;
+    }
+
+    const size_t batch_size = static_cast<size_t>(std::max(1, config_.max_batch_size));
+    std::vector<size_t> indices;
+    indices.reserve(batch_size);
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!validateFrame(frames[i])) {
+            results[i] = DetectionResult{false, "Invalid frame"};
+        } else {
+            indices.push_back(i);
+        }
+
+        if (indices.size() == batch_size || (i + 1 == frames.size() && !indices.empty())) {
+            try {
+                runBatch(frames, indices, results);
+            } catch (const std::exception& e) {
+                logger_.error("Batch detection failed: " + std::string(e.what()));
+                for (size_t index : indices) {
+                    results[index] = DetectionResult{false, "Detection error: " + std::string(e.what())};
+                }
+            }
+            indices.clear();
+        }
+    }
+    return results;
+}
+
+void Detector::runBatch(
+    const std::vector<cv::Mat>& frames,
+    const std::vector<size_t>& indices,
+    std::vector<DetectionResult>& results
+) {
+    const size_t count = indices.size();
+
+    // The blob is sized for a full batch once; a short batch uses a
+    // header over its leading images
+    const cv::Size input_size(config_.input_width, config_.input_height);
+    Letterbox::ensureBlob(batch_blob_, std::max(config_.max_batch_size, 1), input_size);
+    batch_transforms_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        batch_transforms_[i] = preprocessFrame(frames[indices[i]], batch_blob_, static_cast<int>(i));
+    }
+    const int shape[] = {static_cast<int>(count), 3, input_size.height, input_size.width};
+    cv::Mat blob(4, shape, CV_32F, batch_blob_.ptr<float>());
+
+    // One forward pass for the whole batch
+    net_.setInput(blob);
+    net_.forward(batch_outputs_, output_names_);
+
+    std::vector<std::vector<cv::Mat>> per_image(count);
+    for (const auto& output : batch_outputs_) {
+        auto parts = splitBatchOutput(output, count);
+        for (size_t i = 0; i < count; ++i) {
+            per_image[i].push_back(std::move(parts[i]));
+        }
+    }
+
+    // Images are independent from here on; each gets its own scratch
+    if (batch_scratch_.size() < count) {
+        batch_scratch_.resize(count);
+    }
+    std::vector<std::vector<Detection>> detections(count);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(count)), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            processDetections(batch_transforms_[i], per_image[i], detections[i],
+                              config_.confidence_threshold, batch_scratch_[i]);
+            if (config_.enable_nms) {
+                applyNMS(detections[i], batch_scratch_[i]);
+            }
+        }
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        results[indices[i]] = DetectionResult{
+            true,
+            "Detection successful",
+            std::move(detections[i]),
+            ++detection_count_
+        };
+    }
+}
+
+void Detector::detectFullFrame(
     const cv::Mat& frame,
-    const std::vector<cv::Mat>& outputs,
+    float confidence_threshold,
     std::vector<Detection>& detections
 ) {
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-
-    // Get frame dimensions
-    float width_ratio = float(frame.cols) / config_.input_width;
-    float height_ratio = float(frame.rows) / config_.input_height;
-
-    // Process network outputs
-    for (const auto& output : outputs) {
-        float* data = (float*)output.data;
-        for (int i = 0; i < output.rows; ++i, data += output.cols) {
-            cv::Mat scores = output.row(i).colRange(5, output.cols);
-            cv::Point class_id_point;
-            double confidence;
-            
-            // Get maximum score and its index
-            cv::minMaxLoc(scores, nullptr, &confidence, nullptr, &class_id_point);
-            
-            if (confidence > config_.confidence_threshold) {
-                // Get bounding box dimensions
-                float center_x = data[0] * width_ratio;
-                float center_y = data[1] * height_ratio;
-                float width = data[2] * width_ratio;
-                float height = data[3] * height_ratio;
-                float x = center_x - width/2;
-                float y = center_y - height/2;
-
-                // Store detection
-                Detection det;
-                det.class_id = class_id_point.x;
-                det.confidence = static_cast<float>(confidence);
-                det.box = cv::Rect(x, y, width, height);
-                det.class_name = class_names_[det.class_id];
-                
-                detections.push_back(det);
+    // Letterbox into the persistent input blob
+    Letterbox::ensureBlob(input_blob_, 1, cv::Size(config_.input_width, config_.input_height));
+    LetterboxTransform transform = preprocessFrame(frame, input_blob_);
+
+    // Run inference
+    net_.setInput(input_blob_);
+    net_.forward(outputs_, output_names_);
+
+    // Process detections
+    processDetections(transform, outputs_, detections, confidence_threshold, scratch_);
+}
+
+void Detector::detectTiled(const cv::Mat& frame, std::vector<Detection>& detections) {
+    auto tiles = computeTileGrid(
+        frame.size(),
+        cv::Size(config_.input_width, config_.input_height),
+        config_.tile_overlap
+    );
+
+    if (!config_.enable_tile_selection) {
+        runTileBatch(frame, tiles, detections);
+        return;
+    }
+
+    // Coarse pass over the whole frame at a low threshold: its confident
+    // detections are kept (large objects), and every candidate marks the
+    // tiles that deserve a full-resolution look
+    std::vector<Detection> candidates;
+    float coarse_threshold = std::min(config_.tile_selection_threshold, config_.confidence_threshold);
+    detectFullFrame(frame, coarse_threshold, candidates);
+
+    std::vector<bool> selected(tiles.size(), false);
+    for (const auto& candidate : candidates) {
+        if (candidate.confidence >= config_.confidence_threshold) {
+            detections.push_back(candidate);
+        }
+        for (size_t t = 0; t < tiles.size(); ++t) {
+            if (!selected[t] && (tiles[t] & candidate.box).area() > 0) {
+                selected[t] = true;
             }
         }
     }
+
+    // Visit a few unselected tiles in rotation so objects the coarse pass
+    // can't see at all are still found eventually
+    int refresh = config_.tile_refresh_per_frame;
+    for (size_t n = 0; n < tiles.size() && refresh > 0; ++n) {
+        size_t t = (tile_cursor_ + n) % tiles.size();
+        if (!selected[t]) {
+            selected[t] = true;
+            refresh--;
+            tile_cursor_ = t + 1;
+        }
+    }
+
+    std::vector<cv::Rect> active;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        if (selected[t]) {
+            active.push_back(tiles[t]);
+        }
+    }
+    tiles_skipped_ += tiles.size() - active.size();
+
+    runTileBatch(frame, active, detections);
 }
 
-void Detector::applyNMS(std::vector<Detection>& detections) {
-    // Sort detections by confidence
-    std::sort(detections.begin(), detections.end(),
-        [](const Detection& a, const Detection& b) {
-            return a.confidence > b.confidence;
-        });
+void Detector::runTileBatch(
+    const cv::Mat& frame,
+    const std::vector<cv::Rect>& tiles,
+    std::vector<Detection>& detections
+) {
+    const size_t batch_size = static_cast<size_t>(std::max(1, config_.tile_batch_size));
+    const cv::Size input_size(config_.input_width, config_.input_height);
+    Letterbox::ensureBlob(tile_blob_, static_cast<int>(batch_size), input_size);
+    tile_transforms_.resize(batch_size);
+
+    for (size_t begin = 0; begin < tiles.size(); begin += batch_size) {
+        size_t end = std::min(tiles.size(), begin + batch_size);
+        const size_t count = end - begin;
+
+        // Tiles are ROI views, sampled straight into the blob
+        for (size_t t = begin; t < end; ++t) {
+            tile_transforms_[t - begin] = preprocessFrame(frame(tiles[t]), tile_blob_, static_cast<int>(t - begin));
+        }
+        const int shape[] = {static_cast<int>(count), 3, input_size.height, input_size.width};
+        cv::Mat blob(4, shape, CV_32F, tile_blob_.ptr<float>());
 
-    std::vector<Detection> selected;
-    std::vector<bool> suppressed(detections.size(), false);
+        net_.setInput(blob);
+        net_.forward(outputs_, output_names_);
+
+        // Split each output per tile and shift boxes into frame coordinates
+        std::vector<std::vector<cv::Mat>> per_tile(count);
+        for (const auto& output : outputs_) {
+            auto parts = splitBatchOutput(output, count);
+            for (size_t i = 0; i < parts.size(); ++i) {
+                per_tile[i].push_back(parts[i]);
+            }
+        }
 
-    for (size_t i = 0; i < detections.size(); ++i) {
-        if (suppressed[i]) continue;
+        for (size_t i = 0; i < count; ++i) {
+            size_t first = detections.size();
+            processDetections(tile_transforms_[i], per_tile[i], detections, config_.confidence_threshold, scratch_);
 
-        selected.push_back(detections[i]);
+            const cv::Point offset = tiles[begin + i].tl();
+            for (size_t d = first; d < detections.size(); ++d) {
+                detections[d].translate(offset);
+            }
+        }
+        tiles_run_ += count;
+    }
+}
+
+std::vector<cv::Rect> Detector::computeTileGrid(cv::Size frame_size, cv::Size tile_size, float overlap) {
+    // Tile origins along one axis; the last tile is aligned to the far edge
+    auto origins = [overlap](int length, int tile) {
+        std::vector<int> positions;
+        if (length <= tile) {
+            positions.push_back(0);
+            return positions;
+        }
+        int stride = std::max(1, static_cast<int>(tile * (1.0f - std::clamp(overlap, 0.0f, 0.9f))));
+        for (int position = 0; position + tile < length; position += stride) {
+            positions.push_back(position);
+        }
+        positions.push_back(length - tile);
+        return positions;
+    };
+
+    int tile_width = std::min(tile_size.width, frame_size.width);
+    int tile_height = std::min(tile_size.height, frame_size.height);
 
-        for (size_t j = i + 1; j < detections.size(); ++j) {
-            if (suppressed[j]) continue;
+    std::vector<cv::Rect> tiles;
+    for (int y : origins(frame_size.height, tile_height)) {
+        for (int x : origins(frame_size.width, tile_width)) {
+            tiles.emplace_back(x, y, tile_width, tile_height);
+        }
+    }
+    return tiles;
+}
 
-            float iou = calculateIoU(detections[i].box, detections[j].box);
-            if (iou > config_.nms_threshold) {
-                suppressed[j] = true;
+void Detector::processDetections(
+    const LetterboxTransform& transform,
+    const std::vector<cv::Mat>& outputs,
+    std::vector<Detection>& detections,
+    float confidence_threshold,
+    DetectionScratch& scratch
+) {
+    // Decode straight from the output buffers
+    DecodeParams params;
+    params.confidence_threshold = confidence_threshold;
+    params.scale_x = 1.0f / transform.scale_x;
+    params.scale_y = 1.0f / transform.scale_y;
+    params.pad_x = transform.pad_x;
+    params.pad_y = transform.pad_y;
+    params.objectness_early_out = config_.objectness_early_out;
+    params.multiply_objectness = config_.multiply_objectness;
+
+    // Mask coefficients and keypoints trail the class scores; prototypes
+    // come as a separate 4D output
+    cv::Mat prototypes;
+    if (config_.enable_segmentation) {
+        for (const auto& output : outputs) {
+            if (output.dims == 4 && output.size[0] == 1 && output.type() == CV_32F) {
+                prototypes = output;
+                break;
             }
         }
     }
+    const int mask_channels = prototypes.empty() ? 0 : prototypes.size[1];
+    const int num_keypoints = config_.enable_keypoints ? std::max(0, config_.num_keypoints) : 0;
+    params.extra_columns = mask_channels + 3 * num_keypoints;
+
+    scratch.decoded.clear();
+    decodeDetectionOutputs(outputs, params, scratch.decoded);
+
+    // Copy out only what lazy decoding needs before the network reuses
+    // its output buffers
+    std::shared_ptr<DetectionPayload> payload;
+    if (params.extra_columns > 0 && !scratch.decoded.empty()) {
+        payload = std::make_shared<DetectionPayload>();
+        payload->extras.create(static_cast<int>(scratch.decoded.size()), params.extra_columns, CV_32F);
+        for (size_t i = 0; i < scratch.decoded.size(); ++i) {
+            std::copy_n(scratch.decoded[i].extra, params.extra_columns,
+                        payload->extras.ptr<float>(static_cast<int>(i)));
+        }
+        if (mask_channels > 0) {
+            prototypes.copyTo(payload->prototypes);
+        }
+        payload->transform = transform;
+        payload->input_size = cv::Size(config_.input_width, config_.input_height);
+        payload->mask_channels = mask_channels;
+        payload->num_keypoints = num_keypoints;
+        payload->mask_threshold = config_.mask_threshold;
+        payload->keypoint_threshold = config_.keypoint_threshold;
+    }
+
+    detections.reserve(detections.size() + scratch.decoded.size());
+    for (size_t i = 0; i < scratch.decoded.size(); ++i) {
+        const auto& decoded = scratch.decoded[i];
+        Detection det;
+        det.class_id = decoded.class_id;
+        det.confidence = decoded.confidence;
+        det.box = decoded.box;
+        if (decoded.class_id < static_cast<int>(class_names_.size())) {
+            det.class_name = class_names_[decoded.class_id];
+        }
+        if (payload) {
+            det.attachPayload(payload, static_cast<int>(i));
+        }
+        detections.push_back(std::move(det));
+    }
+}
+
+void Detector::applyNMS(std::vector<Detection>& detections, DetectionScratch& scratch) {
+    scratch.nms_boxes.clear();
+    scratch.nms_boxes.reserve(detections.size());
+    for (const auto& det : detections) {
+        scratch.nms_boxes.push(det.box, det.confidence, det.class_id);
+    }
+
+    NmsParams params;
+    params.iou_threshold = config_.nms_threshold;
+    params.class_aware = config_.class_aware_nms;
+    params.method = config_.nms_method;
+    params.soft_sigma = config_.soft_nms_sigma;
+    params.score_threshold = config_.confidence_threshold;
+    scratch.nms.run(scratch.nms_boxes, params, scratch.nms_keep);
+
+    // Survivors are moved, not copied, in descending score order
+    std::vector<Detection> selected;
+    selected.reserve(scratch.nms_keep.size());
+    for (int index : scratch.nms_keep) {
+        selected.push_back(std::move(detections[index]));
+        selected.back().confidence = scratch.nms_boxes.score[index];
+    }
+    detections.swap(selected);
+}
+
+LetterboxTransform Detector::preprocessFrame(const cv::Mat& frame, cv::Mat& blob, int index) {
+    LetterboxParams params;
+    params.input_size = cv::Size(config_.input_width, config_.input_height);
+    params.keep_aspect = config_.maintain_aspect_ratio;
+    params.pad_value = config_.letterbox_pad_value;
+    return letterbox_.run(frame, blob, index, params);
+}
+
+bool Detector::validateFrame(const cv::Mat& frame) const {
+    // Batched blobs need the same channel layout for every image
+    return !frame.empty() && frame.channels() == 3;
+}
+
+bool Detector::loadModelBuffer(const DetectorConfig& config, ModelBuffer& buffer) {
+    auto readFile = [](const std::string& path, std::vector<uchar>& bytes) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), bytes.size()));
+    };
+
+    // readNet only infers the framework from file names, so do the same here
+    auto extension = [](const std::string& path) {
+        size_t dot = path.rfind('.');
+        return dot == std::string::npos ? std::string() : path.substr(dot + 1);
+    };
+    const std::string ext = extension(config.model_weights);
+    if (ext == "onnx") {
+        buffer.framework = "onnx";
+    } else if (ext == "weights") {
+        buffer.framework = "darknet";
+    } else if (ext == "caffemodel") {
+        buffer.framework = "caffe";
+    } else if (ext == "pb") {
+        buffer.framework = "tensorflow";
+    } else if (ext == "tflite") {
+        buffer.framework = "tflite";
+    } else {
+        return false;
+    }
 
-    detections = selected;
+    buffer.config.clear();
+    if (!readFile(config.model_weights, buffer.weights)) {
+        return false;
+    }
+    if (!config.model_config.empty() && !readFile(config.model_config, buffer.config)) {
+        return false;
+    }
+
+    // INT8 inputs are optional: a pre-quantized model, or failing that the
+    // calibration frames, decoded once for every detector built from here
+    buffer.int8_weights.clear();
+    buffer.calibration.clear();
+    if (wantsInt8(config)) {
+        std::string int8_path = int8WeightsPath(config);
+        if (int8_path.empty() || !readFile(int8_path, buffer.int8_weights)) {
+            buffer.int8_weights.clear();
+            buffer.calibration = loadCalibrationBlobs(config);
+        }
+    }
+    return true;
 }
 
 float Detector::calculateIoU(const cv::Rect& box1, const cv::Rect& box2) {
@@ -208,13 +659,153 @@ float Detector::calculateIoU(const cv::Rect& box1, const cv::Rect& box2) {
 
 DetectorMetrics Detector::getMetrics() const {
     return DetectorMetrics{
-        detection_count_,
+        detection_count_.load(),
         gpu_enabled_,
+        int8_enabled_,
         static_cast<int>(class_names_.size()),
         config_.input_width,
-        config_.input_height
+        config_.input_height,
+        tiles_run_,
+        tiles_skipped_
     };
 }
 
+bool Detection::hasKeypoints() const {
+    return keypoints_.has_value() || (payload_ && payload_->num_keypoints > 0);
+}
+
+bool Detection::hasMask() const {
+    return mask_.has_value() || (payload_ && payload_->mask_channels > 0);
+}
+
+const std::vector<cv::Point>& Detection::keypoints() const {
+    if (!keypoints_) {
+        keypoints_.emplace();
+        if (payload_) {
+            decodeKeypoints(*payload_, payload_row_, origin_, *keypoints_);
+        }
+    }
+    return *keypoints_;
+}
+
+const RleMask& Detection::mask() const {
+    if (!mask_) {
+        mask_ = payload_ ? decodeMask(*payload_, payload_row_, box, origin_) : RleMask();
+    }
+    return *mask_;
+}
+
+cv::Mat Detection::denseMask() const {
+    cv::Mat dense;
+    mask().decode(dense);
+    return dense;
+}
+
+void Detection::setKeypoints(std::vector<cv::Point> keypoints) {
+    keypoints_ = std::move(keypoints);
+}
+
+void Detection::setMask(RleMask mask) {
+    mask_ = std::move(mask);
+}
+
+void Detection::attachPayload(std::shared_ptr<const DetectionPayload> payload, int row) {
+    payload_ = std::move(payload);
+    payload_row_ = row;
+    origin_ = cv::Point();
+    keypoints_.reset();
+    mask_.reset();
+}
+
+void Detection::translate(cv::Point offset) {
+    box.x += offset.x;
+    box.y += offset.y;
+    origin_ += offset;
+    if (keypoints_) {
+        for (auto& point : *keypoints_) {
+            if (point.x >= 0 || point.y >= 0) {
+                point += offset;
+            }
+        }
+    }
+}
+
+namespace utils {
+
+bool saveDetections(const std::string& filename, const std::vector<Detection>& detections) {
+    try {
+        cv::FileStorage fs(filename, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            return false;
+        }
+
+        fs << "detections" << "[";
+        for (const auto& det : detections) {
+            fs << "{";
+            fs << "class_id" << det.class_id;
+            fs << "class_name" << det.class_name;
+            fs << "confidence" << det.confidence;
+            fs << "box" << det.box;
+            fs << "track_id" << det.track_id;
+            if (det.hasKeypoints()) {
+                fs << "keypoints" << det.keypoints();
+            }
+            // Masks stay run-length encoded on disk
+            if (det.hasMask() && !det.mask().empty()) {
+                const RleMask& mask = det.mask();
+                std::vector<int> counts(mask.counts().begin(), mask.counts().end());
+                fs << "mask" << "{";
+                fs << "size" << mask.size();
+                fs << "counts" << counts;
+                fs << "}";
+            }
+            fs << "}";
+        }
+        fs << "]";
+        return true;
+    } catch (const cv::Exception&) {
+        return false;
+    }
+}
+
+std::vector<Detection> loadDetections(const std::string& filename) {
+    std::vector<Detection> detections;
+    try {
+        cv::FileStorage fs(filename, cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            return detections;
+        }
+
+        for (const auto& node : fs["detections"]) {
+            Detection det;
+            det.class_id = static_cast<int>(node["class_id"]);
+            det.class_name = static_cast<std::string>(node["class_name"]);
+            det.confidence = static_cast<float>(node["confidence"]);
+            node["box"] >> det.box;
+            det.track_id = node["track_id"].empty() ? -1 : static_cast<int>(node["track_id"]);
+
+            if (!node["keypoints"].empty()) {
+                std::vector<cv::Point> keypoints;
+                node["keypoints"] >> keypoints;
+                det.setKeypoints(std::move(keypoints));
+            }
+            cv::FileNode mask = node["mask"];
+            if (!mask.empty()) {
+                cv::Size size;
+                std::vector<int> counts;
+                mask["size"] >> size;
+                mask["counts"] >> counts;
+                det.setMask(RleMask::fromCounts(size, std::vector<uint32_t>(counts.begin(), counts.end())));
+            }
+            detections.push_back(std::move(det));
+        }
+    } catch (const cv::Exception&) {
+        detections.clear();
+    }
+    return detections;
+}
+
+} // namespace utils
+
 } // namespace vision
-} // namespace glooms
\ No newline at end of file
+} // namespace glooms
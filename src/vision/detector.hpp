@@ -2,10 +2,18 @@
 
 #include <opencv2/core.hpp>
 #include <opencv2/dnn.hpp>
+#include <atomic>
+#include <optional>
 #include <string>
 #include <vector>
 #include <memory>
 
+#include "vision/detection_decoder.hpp"
+#include "vision/int8_quantization.hpp"
+#include "vision/letterbox.hpp"
+#include "vision/nms.hpp"
+#include "vision/rle_mask.hpp"
+
 namespace glooms {
 namespace vision {
 
@@ -18,8 +26,30 @@ struct Detection {
     std::string class_name;
     float confidence;
     cv::Rect box;
-    std::vector<cv::Point> keypoints;  // Optional keypoints
-    cv::Mat mask;                      // Optional segmentation mask
+    int track_id = -1;                 // Set by MultiObjectTracker, -1 when untracked
+
+    // Optional keypoints and segmentation mask. Detectors attach the raw
+    // output they come from, and each is decoded on first access and then
+    // cached, so boxes-only consumers never pay for them. The first access
+    // is not thread-safe.
+    bool hasKeypoints() const;
+    bool hasMask() const;
+    const std::vector<cv::Point>& keypoints() const;
+    const RleMask& mask() const;       // Covers box
+    cv::Mat denseMask() const;         // Box-sized CV_8UC1, empty without a mask
+
+    void setKeypoints(std::vector<cv::Point> keypoints);
+    void setMask(RleMask mask);
+    void attachPayload(std::shared_ptr<const DetectionPayload> payload, int row);
+    // Moves the box, and anything decoded later, by `offset`
+    void translate(cv::Point offset);
+
+private:
+    std::shared_ptr<const DetectionPayload> payload_;
+    int payload_row_ = -1;
+    cv::Point origin_;
+    mutable std::optional<std::vector<cv::Point>> keypoints_;
+    mutable std::optional<RleMask> mask_;
 };
 
 struct DetectorConfig {
@@ -31,22 +61,49 @@ struct DetectorConfig {
     // Input settings
     int input_width = 416;
     int input_height = 416;
-    bool maintain_aspect_ratio = true;
+    bool maintain_aspect_ratio = true;      // Letterbox instead of stretching
+    float letterbox_pad_value = 114.0f;     // Border colour around letterboxed frames
 
     // Detection settings
     float confidence_threshold = 0.5f;
     float nms_threshold = 0.4f;
     bool enable_nms = true;
+    bool class_aware_nms = true;            // Boxes only suppress boxes of their own class
+    NmsMethod nms_method = NmsMethod::HARD;
+    float soft_nms_sigma = 0.5f;            // NmsMethod::SOFT_GAUSSIAN spread
+    bool objectness_early_out = true;       // Skip rows by objectness before scanning classes
+    bool multiply_objectness = false;       // Score = objectness * class score (raw YOLOv5-style heads)
     
     // Hardware settings
     bool use_gpu = true;
     int gpu_id = 0;
 
+    // INT8 CPU inference, used when CUDA is unavailable: a pre-quantized
+    // model is preferred, otherwise the FP32 model is quantized at load
+    // from calibration frames
+    bool enable_int8 = true;
+    std::string int8_model_weights;         // Defaults to <weights>.int8.onnx when present
+    std::string int8_calibration_dir;       // Sample frames for load-time quantization
+    int int8_calibration_frames = 32;
+    bool int8_per_channel = false;          // Per-tensor weight scales when false
+
     // Advanced settings
     bool enable_batch_processing = false;
     int max_batch_size = 1;
     bool enable_keypoints = false;
     bool enable_segmentation = false;
+    int num_keypoints = 17;                 // (x, y, confidence) columns after the mask coefficients
+    float keypoint_threshold = 0.5f;
+    float mask_threshold = 0.5f;
+
+    // Tiled inference: overlapping model-sized tiles at native resolution,
+    // merged with cross-tile NMS
+    bool enable_tiling = false;
+    float tile_overlap = 0.2f;              // Fraction of a tile shared with its neighbour
+    int tile_batch_size = 8;                // Tiles per forward pass
+    bool enable_tile_selection = true;      // Coarse full-frame pass picks the tiles
+    float tile_selection_threshold = 0.1f;  // Coarse confidence that makes a tile worth running
+    int tile_refresh_per_frame = 1;         // Unselected tiles still visited in rotation
 };
 
 struct DetectionResult {
@@ -56,18 +113,41 @@ struct DetectionResult {
     uint64_t frame_number;
 };
 
+// Per-image decoding and NMS scratch, reused across frames
+struct DetectionScratch {
+    std::vector<DecodedBox> decoded;
+    NmsBoxes nms_boxes;
+    std::vector<int> nms_keep;
+    NonMaxSuppressor nms;
+};
+
+// Model files read into memory once, so several detectors can build
+// their networks without going back to disk
+struct ModelBuffer {
+    std::string framework;              // As cv::dnn::readNet expects: "onnx", "darknet", ...
+    std::vector<uchar> weights;
+    std::vector<uchar> config;
+    std::vector<uchar> int8_weights;    // Pre-quantized ONNX model, when one was found
+    std::vector<cv::Mat> calibration;   // Letterboxed calibration blobs, when there is none
+};
+
 struct DetectorMetrics {
     uint64_t detection_count;
     bool gpu_enabled;
+    bool int8_enabled;
     int num_classes;
     int input_width;
     int input_height;
+    uint64_t tiles_run;
+    uint64_t tiles_skipped;
 };
 
 class Detector {
 public:
     // Constructor & Destructor
     explicit Detector(const DetectorConfig& config);
+    // Builds the network from an already loaded model instead of the files
+    Detector(const DetectorConfig& config, std::shared_ptr<const ModelBuffer> model);
     ~Detector();
 
     // Delete copy constructor and assignment operator
@@ -79,8 +159,10 @@ public:
     void cleanup();
     DetectionResult detect(const cv::Mat& frame);
 
-    // Batch processing methods
-    DetectionResult detectBatch(const std::vector<cv::Mat>& frames);
+    // Batch processing methods: frames go through the network together in
+    // blobs of up to max_batch_size images, then each frame is decoded and
+    // suppressed in parallel. Results are per frame, in input order.
+    std::vector<DetectionResult> detectBatch(const std::vector<cv::Mat>& frames);
     
     // Configuration methods
     void setConfig(const DetectorConfig& config) { config_ = config; }
@@ -95,25 +177,35 @@ public:
     DetectorMetrics getMetrics() const;
     bool isInitialized() const { return is_initialized_; }
     bool isGPUEnabled() const { return gpu_enabled_; }
+    bool isInt8Enabled() const { return int8_enabled_; }
+    bool getQuantizationDetails(QuantizationDetails& details) const;
 
     // Utility methods
     static float calculateIoU(const cv::Rect& box1, const cv::Rect& box2);
+    static std::vector<cv::Rect> computeTileGrid(cv::Size frame_size, cv::Size tile_size, float overlap);
     static bool isGPUAvailable() { return cv::cuda::getCudaEnabledDeviceCount() > 0; }
+    static bool loadModelBuffer(const DetectorConfig& config, ModelBuffer& buffer);
 
 protected:
     // Detection pipeline methods
     void processDetections(
-        const cv::Mat& frame,
+        const LetterboxTransform& transform,
         const std::vector<cv::Mat>& outputs,
-        std::vector<Detection>& detections
+        std::vector<Detection>& detections,
+        float confidence_threshold,
+        DetectionScratch& scratch
     );
+
+    void detectFullFrame(const cv::Mat& frame, float confidence_threshold, std::vector<Detection>& detections);
+    void detectTiled(const cv::Mat& frame, std::vector<Detection>& detections);
+    void runTileBatch(const cv::Mat& frame, const std::vector<cv::Rect>& tiles, std::vector<Detection>& detections);
     
-    void applyNMS(std::vector<Detection>& detections);
+    void applyNMS(std::vector<Detection>& detections, DetectionScratch& scratch);
     
     // Helper methods
     bool loadClasses();
     bool validateFrame(const cv::Mat& frame) const;
-    void preprocessFrame(const cv::Mat& frame, cv::Mat& blob);
+    LetterboxTransform preprocessFrame(const cv::Mat& frame, cv::Mat& blob, int index = 0);
     void postprocessDetections(std::vector<Detection>& detections);
 
 private:
@@ -121,23 +213,44 @@ private:
     DetectorConfig config_;
     bool is_initialized_;
     bool gpu_enabled_;
+    bool int8_enabled_;
 
     // Neural network
+    std::shared_ptr<const ModelBuffer> model_;
     cv::dnn::Net net_;
     std::vector<std::string> output_names_;
     std::vector<std::string> class_names_;
 
     // Processing state
-    uint64_t detection_count_;
-    std::vector<cv::Mat> batch_buffer_;
+    std::atomic<uint64_t> detection_count_;
+    Letterbox letterbox_;
+    cv::Mat input_blob_;
+    std::vector<cv::Mat> outputs_;
+    cv::Mat batch_blob_;
+    std::vector<cv::Mat> batch_outputs_;
+    std::vector<LetterboxTransform> batch_transforms_;
+    std::vector<DetectionScratch> batch_scratch_;
+
+    // Tiling state
+    size_t tile_cursor_;
+    uint64_t tiles_run_;
+    uint64_t tiles_skipped_;
+    cv::Mat tile_blob_;
+    std::vector<LetterboxTransform> tile_transforms_;
+
+    // Decoding and NMS scratch for single-frame detection
+    DetectionScratch scratch_;
 
     // Utilities
     Logger& logger_;
 
     // Internal helper methods
     void initializeGPU();
+    void initializeInt8();
     void initializeNetwork();
     void cleanupResources();
+    void runBatch(const std::vector<cv::Mat>& frames, const std::vector<size_t>& indices,
+                  std::vector<DetectionResult>& results);
 };
 
 // Factory function
@@ -147,7 +260,9 @@ std::unique_ptr<Detector> createDetector(const DetectorConfig& config);
 namespace utils {
     std::vector<cv::Scalar> generateColors(int num_classes);
     void drawDetections(cv::Mat& frame, const std::vector<Detection>& detections);
-    void saveDetections(const std::string& filename, const std::vector<Detection>& detections);
+    // YAML or JSON by extension; masks are written run-length encoded.
+    // Continuous per-frame logging goes through DetectionLogWriter instead.
+    bool saveDetections(const std::string& filename, const std::vector<Detection>& detections);
     std::vector<Detection> loadDetections(const std::string& filename);
 }
 
@@ -0,0 +1,155 @@
+#include "vision/detector_pool.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+
+namespace glooms {
+namespace vision {
+
+DetectorPool::Lease::Lease(DetectorPool* pool, size_t index, Detector* detector)
+    : pool_(pool)
+    , index_(index)
+    , detector_(detector) {}
+
+DetectorPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_)
+    , index_(other.index_)
+    , detector_(other.detector_) {
+    other.pool_ = nullptr;
+    other.detector_ = nullptr;
+}
+
+DetectorPool::Lease::~Lease() {
+    if (pool_) {
+        pool_->release(index_);
+    }
+}
+
+DetectorPool::DetectorPool(const DetectorPoolConfig& config)
+    : config_(config)
+    , is_initialized_(false)
+    , threads_per_instance_(0)
+    , previous_threads_(-1)
+    , detection_count_(0)
+    , waits_(0) {
+    initialize();
+}
+
+DetectorPool::~DetectorPool() {
+    cleanup();
+}
+
+bool DetectorPool::initialize() {
+    TRACE_SPAN_CAT("DetectorPool::initialize", "vision");
+    cleanup();
+
+    const int cores = std::max(1, cv::getNumberOfCPUs());
+    const int budget = config_.thread_budget > 0 ? config_.thread_budget : cores;
+    const int instances = config_.instances > 0 ? config_.instances : std::max(1, cores / 4);
+
+    auto model = std::make_shared<ModelBuffer>();
+    if (!Detector::loadModelBuffer(config_.detector, *model)) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Detector>> detectors;
+    for (int i = 0; i < instances; ++i) {
+        auto detector = std::make_unique<Detector>(config_.detector, model);
+        if (!detector->isInitialized()) {
+            return false;
+        }
+        detectors.push_back(std::move(detector));
+    }
+
+    threads_per_instance_ = std::max(1, budget / instances);
+    previous_threads_ = cv::getNumThreads();
+    cv::setNumThreads(threads_per_instance_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        detectors_ = std::move(detectors);
+        free_.clear();
+        for (size_t i = detectors_.size(); i-- > 0;) {
+            free_.push_back(i);
+        }
+        is_initialized_ = true;
+    }
+    return true;
+}
+
+void DetectorPool::cleanup() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_initialized_) {
+        return;
+    }
+
+    // Turn away new and waiting acquire() calls, then wait for
+    // outstanding leases before the detectors go away
+    is_initialized_ = false;
+    available_cv_.notify_all();
+    available_cv_.wait(lock, [this] { return free_.size() == detectors_.size(); });
+    detectors_.clear();
+    free_.clear();
+
+    if (previous_threads_ >= 0) {
+        cv::setNumThreads(previous_threads_);
+        previous_threads_ = -1;
+    }
+}
+
+DetectorPool::Lease DetectorPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (is_initialized_ && free_.empty()) {
+        waits_++;
+        available_cv_.wait(lock, [this] { return !free_.empty() || !is_initialized_; });
+    }
+    if (!is_initialized_) {
+        return Lease(nullptr, 0, nullptr);
+    }
+    size_t index = free_.back();
+    free_.pop_back();
+    return Lease(this, index, detectors_[index].get());
+}
+
+void DetectorPool::release(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(index);
+    }
+    // cleanup() may be waiting for every instance, so wake all waiters
+    available_cv_.notify_all();
+}
+
+DetectionResult DetectorPool::detect(const cv::Mat& frame) {
+    TRACE_SPAN_CAT("DetectorPool::detect", "vision");
+    if (!is_initialized_) {
+        return DetectionResult{false, "Detector pool not initialized"};
+    }
+
+    DetectionResult result;
+    {
+        Lease lease = acquire();
+        if (!lease) {
+            return DetectionResult{false, "Detector pool not initialized"};
+        }
+        result = lease->detect(frame);
+    }
+    if (result.success) {
+        result.frame_number = ++detection_count_;
+    }
+    return result;
+}
+
+DetectorPoolMetrics DetectorPool::getMetrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DetectorPoolMetrics{
+        detection_count_.load(),
+        detectors_.size(),
+        free_.size(),
+        threads_per_instance_,
+        waits_.load()
+    };
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vision/detector.hpp"
+
+namespace glooms {
+namespace vision {
+
+struct DetectorPoolConfig {
+    DetectorConfig detector;
+    int instances = 0;                  // Networks in the pool; 0 for one per 4 cores
+    int thread_budget = 0;              // OpenCV threads shared by all instances; 0 for every core
+};
+
+struct DetectorPoolMetrics {
+    uint64_t detection_count;
+    size_t instances;
+    size_t available;
+    int threads_per_instance;
+    uint64_t waits;                     // detect() calls that found every instance busy
+};
+
+// Serves concurrent detect() calls from a fixed set of Detector
+// instances. cv::dnn::Net is not safe to share between threads, so each
+// call leases a whole instance and returns it afterwards. The model files,
+// INT8 model and calibration frames are read once and every network is
+// built from the same buffer; load-time quantization still runs per
+// instance, as a quantized cv::dnn::Net can't be copied.
+//
+// OpenCV's thread count is process-wide: the pool sets it to
+// thread_budget / instances so that all instances running at once stay
+// within the budget, and restores the previous value when destroyed.
+class DetectorPool {
+public:
+    // Exclusive use of one instance until destroyed
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        // False when the pool was not initialized or is shutting down
+        explicit operator bool() const { return detector_ != nullptr; }
+        Detector& operator*() const { return *detector_; }
+        Detector* operator->() const { return detector_; }
+
+    private:
+        friend class DetectorPool;
+        Lease(DetectorPool* pool, size_t index, Detector* detector);
+
+        DetectorPool* pool_;
+        size_t index_;
+        Detector* detector_;
+    };
+
+    explicit DetectorPool(const DetectorPoolConfig& config);
+    ~DetectorPool();
+
+    // Delete copy constructor and assignment operator
+    DetectorPool(const DetectorPool&) = delete;
+    DetectorPool& operator=(const DetectorPool&) = delete;
+
+    // Core methods
+    bool initialize();
+    void cleanup();
+    // Runs on the first free instance, blocking while all are busy.
+    // Frame numbers count detections across the whole pool.
+    DetectionResult detect(const cv::Mat& frame);
+    // Blocks while all instances are busy. The lease is empty when the
+    // pool is not initialized, or cleanup() starts while waiting.
+    Lease acquire();
+
+    // Metrics and status
+    DetectorPoolMetrics getMetrics() const;
+    bool isInitialized() const { return is_initialized_; }
+    size_t size() const { return detectors_.size(); }
+
+private:
+    void release(size_t index);
+
+    DetectorPoolConfig config_;
+    std::atomic<bool> is_initialized_;  // Changed under mutex_
+    std::vector<std::unique_ptr<Detector>> detectors_;
+    int threads_per_instance_;
+    int previous_threads_;
+
+    // Free instances, guarded by mutex_
+    mutable std::mutex mutex_;
+    std::condition_variable available_cv_;
+    std::vector<size_t> free_;
+
+    std::atomic<uint64_t> detection_count_;
+    std::atomic<uint64_t> waits_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,279 @@
+#include "vision/frame_decoder.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+#include <ctime>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+
+uint64_t threadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+FrameDecoder::FrameDecoder(const FrameDecoderConfig& config)
+    : config_(config)
+    , is_live_(false)
+    , source_fps_(0.0)
+    , head_(0)
+    , count_(0)
+    , running_(false)
+    , end_of_stream_(false)
+    , decoded_count_(0)
+    , delivered_count_(0)
+    , dropped_count_(0)
+    , decode_cpu_ns_(0)
+    , decode_wall_ns_(0) {
+    config_.queue_depth = std::max(1, config_.queue_depth);
+    config_.keep_every_nth = std::max(1, config_.keep_every_nth);
+
+    // One buffer per ring slot, plus the frame being decoded and the one
+    // the consumer is holding
+    frame_pool_.setCapacity(static_cast<size_t>(config_.queue_depth) + 2);
+    ring_.resize(config_.queue_depth);
+}
+
+FrameDecoder::~FrameDecoder() {
+    stop();
+    capture_.release();
+}
+
+bool FrameDecoder::open(const std::string& path) {
+    stop();
+    is_live_ = false;
+    try {
+        capture_.open(path);
+    } catch (const cv::Exception&) {
+        return false;
+    }
+    return openCapture();
+}
+
+bool FrameDecoder::open(int camera_id) {
+    stop();
+    is_live_ = true;
+    try {
+        capture_.open(camera_id);
+    } catch (const cv::Exception&) {
+        return false;
+    }
+    if (capture_.isOpened()) {
+        // The ring does the buffering; a deep driver queue only adds latency
+        capture_.set(cv::CAP_PROP_BUFFERSIZE, 1);
+    }
+    return openCapture();
+}
+
+bool FrameDecoder::openCapture() {
+    if (!capture_.isOpened()) {
+        return false;
+    }
+
+    source_fps_ = capture_.get(cv::CAP_PROP_FPS);
+    frame_size_ = cv::Size(static_cast<int>(capture_.get(cv::CAP_PROP_FRAME_WIDTH)),
+                           static_cast<int>(capture_.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    if (frame_size_.area() > 0) {
+        frame_pool_.reserve(frame_size_, CV_8UC3, frame_pool_.getCapacity());
+    }
+    return true;
+}
+
+bool FrameDecoder::start() {
+    if (running_ || !capture_.isOpened()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = 0;
+        count_ = 0;
+        end_of_stream_ = false;
+    }
+    running_ = true;
+    thread_ = std::thread(&FrameDecoder::decodeLoop, this);
+    return true;
+}
+
+void FrameDecoder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    frame_ready_.notify_all();
+    space_ready_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& slot : ring_) {
+        slot.image.release();
+    }
+    head_ = 0;
+    count_ = 0;
+}
+
+bool FrameDecoder::next(DecodedFrame& frame, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    frame_ready_.wait_for(lock, timeout, [this] {
+        return count_ > 0 || end_of_stream_ || !running_;
+    });
+    if (count_ == 0) {
+        return false;
+    }
+
+    // Assigning over the caller's previous frame returns its buffer to the pool
+    frame = std::move(ring_[head_]);
+    head_ = (head_ + 1) % ring_.size();
+    count_--;
+    lock.unlock();
+
+    space_ready_.notify_one();
+    delivered_count_++;
+    return true;
+}
+
+bool FrameDecoder::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return end_of_stream_ && count_ == 0;
+}
+
+void FrameDecoder::decodeLoop() {
+    glooms::utils::Tracer::instance().setThreadName("vision-decoder");
+    const uint64_t cpu_start = threadCpuNs();
+
+    // Live sources pace themselves; files are paced only when asked to
+    const bool paced = !is_live_ && config_.pace_fps > 0.0;
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(paced ? 1.0 / config_.pace_fps : 0.0));
+    auto release_at = std::chrono::steady_clock::now();
+
+    const uint64_t nth = static_cast<uint64_t>(config_.keep_every_nth);
+    DecodedFrame frame;
+    uint64_t index = 0;
+
+    while (running_) {
+        // Frames KEEP_EVERY_NTH is about to drop are only grabbed, which
+        // skips the color conversion and copy
+        bool keep = true;
+        if (config_.drop_policy == FrameDropPolicy::KEEP_EVERY_NTH) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            keep = count_ < ring_.size() || index % nth == 0;
+        }
+
+        bool ok = decodeFrame(index, keep, frame);
+        decode_cpu_ns_ = threadCpuNs() - cpu_start;
+        if (!ok) {
+            break;
+        }
+        index++;
+
+        if (!keep) {
+            dropped_count_++;
+            continue;
+        }
+
+        if (paced) {
+            std::this_thread::sleep_until(release_at);
+            // Don't burst to catch up after a stall
+            release_at = std::max(release_at + period, std::chrono::steady_clock::now() - period);
+        }
+
+        if (!enqueue(frame)) {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_of_stream_ = true;
+    }
+    frame_ready_.notify_all();
+}
+
+bool FrameDecoder::decodeFrame(uint64_t index, bool retrieve, DecodedFrame& frame) {
+    TRACE_SPAN_CAT("FrameDecoder::decodeFrame", "vision");
+    auto start = std::chrono::steady_clock::now();
+
+    bool ok;
+    try {
+        if (!retrieve) {
+            ok = capture_.grab();
+        } else {
+            // read() decodes straight into the pooled buffer when the size
+            // matches and reallocates the header otherwise
+            cv::Mat image;
+            if (frame_size_.area() > 0) {
+                image = frame_pool_.acquire(frame_size_, CV_8UC3);
+            }
+            ok = capture_.read(image) && !image.empty();
+            if (ok) {
+                frame_size_ = image.size();
+                frame.image = image;
+                frame.index = index;
+                frame.decoded = std::chrono::steady_clock::now();
+            }
+        }
+    } catch (const cv::Exception&) {
+        ok = false;
+    }
+
+    decode_wall_ns_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    if (ok) {
+        decoded_count_++;
+    }
+    return ok;
+}
+
+bool FrameDecoder::enqueue(DecodedFrame& frame) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (count_ == ring_.size()) {
+        if (config_.drop_policy == FrameDropPolicy::KEEP_LATEST) {
+            ring_[head_].image.release();
+            head_ = (head_ + 1) % ring_.size();
+            count_--;
+            dropped_count_++;
+        } else {
+            space_ready_.wait(lock, [this] { return !running_ || count_ < ring_.size(); });
+            if (!running_) {
+                return false;
+            }
+        }
+    }
+
+    ring_[(head_ + count_) % ring_.size()] = std::move(frame);
+    count_++;
+    lock.unlock();
+
+    frame_ready_.notify_one();
+    return true;
+}
+
+FrameDecoderStats FrameDecoder::getStats() const {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued = count_;
+    }
+
+    return FrameDecoderStats{
+        decoded_count_.load(),
+        delivered_count_.load(),
+        dropped_count_.load(),
+        queued,
+        decode_cpu_ns_.load() / 1e6,
+        decode_wall_ns_.load() / 1e6,
+        frame_pool_.getStats()
+    };
+}
+
+} // namespace vision
+} // namespace glooms
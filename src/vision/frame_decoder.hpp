@@ -0,0 +1,112 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glooms/frame_drop_policy.hpp"
+#include "vision/frame_pool.hpp"
+
+namespace glooms {
+namespace vision {
+
+struct FrameDecoderConfig {
+    int queue_depth = 4;                // Frames decoded ahead of the consumer
+    FrameDropPolicy drop_policy = FrameDropPolicy::KEEP_LATEST;
+    int keep_every_nth = 2;
+    double pace_fps = 0.0;              // Release file frames at this rate (0: as fast as possible)
+};
+
+struct DecodedFrame {
+    cv::Mat image;                      // Pooled; release it to recycle the buffer
+    uint64_t index = 0;                 // Position in the source stream
+    std::chrono::steady_clock::time_point decoded;
+};
+
+struct FrameDecoderStats {
+    uint64_t decoded;
+    uint64_t delivered;
+    uint64_t dropped;
+    size_t queued;
+    double decode_cpu_ms;               // Decoder thread CPU time
+    double decode_wall_ms;              // Time spent inside read()/grab()
+    FramePoolStats frame_pool;
+};
+
+// Reads a video file or camera on its own thread into a bounded ring of
+// pooled frames, so decoding overlaps with processing. When the consumer
+// falls behind and the ring fills, frames are dropped according to the
+// configured policy. Decoder CPU time is measured on the decode thread
+// and reported separately from processing. next() must be called from a
+// single thread.
+class FrameDecoder {
+public:
+    explicit FrameDecoder(const FrameDecoderConfig& config = FrameDecoderConfig());
+    ~FrameDecoder();
+
+    // Delete copy constructor and assignment operator
+    FrameDecoder(const FrameDecoder&) = delete;
+    FrameDecoder& operator=(const FrameDecoder&) = delete;
+
+    // Core methods
+    bool open(const std::string& path);
+    bool open(int camera_id);
+    bool start();
+    void stop();
+    bool next(DecodedFrame& frame,
+              std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+    // Status
+    bool isOpened() const { return capture_.isOpened(); }
+    bool isFinished() const;
+    bool isLive() const { return is_live_; }
+    double getSourceFps() const { return source_fps_; }
+    FrameDecoderStats getStats() const;
+
+private:
+    // Configuration
+    FrameDecoderConfig config_;
+
+    // Source
+    cv::VideoCapture capture_;
+    bool is_live_;
+    double source_fps_;
+    cv::Size frame_size_;
+
+    // Ring of decoded frames, oldest at head_
+    FramePool frame_pool_;
+    std::vector<DecodedFrame> ring_;
+    size_t head_;
+    size_t count_;
+    mutable std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::condition_variable space_ready_;
+
+    // Thread state
+    std::thread thread_;
+    std::atomic<bool> running_;
+    bool end_of_stream_;
+
+    // Metrics
+    std::atomic<uint64_t> decoded_count_;
+    std::atomic<uint64_t> delivered_count_;
+    std::atomic<uint64_t> dropped_count_;
+    std::atomic<uint64_t> decode_cpu_ns_;
+    std::atomic<uint64_t> decode_wall_ns_;
+
+    // Internal helper methods
+    bool openCapture();
+    void decodeLoop();
+    bool decodeFrame(uint64_t index, bool retrieve, DecodedFrame& frame);
+    bool enqueue(DecodedFrame& frame);
+};
+
+} // namespace vision
+} // namespace glooms
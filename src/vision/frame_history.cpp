@@ -0,0 +1,94 @@
+#include "vision/frame_history.hpp"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace glooms {
+namespace vision {
+
+FrameHistory::FrameHistory(size_t capacity, int downscale)
+    : newest_(0)
+    , count_(0)
+    , downscale_(0) {
+    reset(capacity, downscale);
+}
+
+void FrameHistory::reset(size_t capacity, int downscale) {
+    slots_.clear();
+    slots_.resize(capacity);
+    newest_ = capacity > 0 ? capacity - 1 : 0;
+    count_ = 0;
+    downscale_ = downscale > 1 ? downscale : 0;
+}
+
+void FrameHistory::clear() {
+    for (auto& slot : slots_) {
+        slot.frame.release();
+        slot.downscaled.release();
+    }
+    newest_ = slots_.empty() ? 0 : slots_.size() - 1;
+    count_ = 0;
+}
+
+void FrameHistory::push(cv::Mat& frame) {
+    if (slots_.empty()) {
+        return;
+    }
+
+    // The evicted (or empty) header goes back to the caller
+    Slot& slot = advance();
+    cv::swap(slot.frame, frame);
+    updateDownscaled(slot);
+}
+
+void FrameHistory::pushCopy(const cv::Mat& frame) {
+    if (slots_.empty()) {
+        return;
+    }
+
+    // Reuses the evicted buffer when the shape matches
+    Slot& slot = advance();
+    frame.copyTo(slot.frame);
+    updateDownscaled(slot);
+}
+
+const cv::Mat& FrameHistory::at(size_t age) const {
+    return slots_[slotIndex(age)].frame;
+}
+
+const cv::Mat& FrameHistory::downscaledAt(size_t age) const {
+    return slots_[slotIndex(age)].downscaled;
+}
+
+size_t FrameHistory::slotIndex(size_t age) const {
+    if (age >= count_) {
+        throw std::out_of_range("Frame history age " + std::to_string(age) +
+                                " beyond " + std::to_string(count_) + " frames");
+    }
+    return (newest_ + slots_.size() - age) % slots_.size();
+}
+
+FrameHistory::Slot& FrameHistory::advance() {
+    newest_ = (newest_ + 1) % slots_.size();
+    if (count_ < slots_.size()) {
+        count_++;
+    }
+    return slots_[newest_];
+}
+
+void FrameHistory::updateDownscaled(Slot& slot) {
+    if (downscale_ == 0 || slot.frame.empty()) {
+        return;
+    }
+
+    // The slot's previous downscaled buffer is the same size in steady
+    // state, so resize() writes in place
+    cv::Size size(std::max(1, slot.frame.cols / downscale_),
+                  std::max(1, slot.frame.rows / downscale_));
+    cv::resize(slot.frame, slot.downscaled, size, 0, 0, cv::INTER_AREA);
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// Fixed-capacity ring of the most recent frames, for temporal stages.
+// push() swaps the caller's buffer into the ring in O(1), so recording a
+// frame never copies or allocates; the caller gets the evicted buffer
+// back. Each slot can also keep a copy shrunk by `downscale`, resized
+// into a buffer that is reused once the slot has been filled. Not
+// thread-safe.
+class FrameHistory {
+public:
+    explicit FrameHistory(size_t capacity = 0, int downscale = 0);
+
+    // Delete copy constructor and assignment operator
+    FrameHistory(const FrameHistory&) = delete;
+    FrameHistory& operator=(const FrameHistory&) = delete;
+
+    // Core methods
+    void push(cv::Mat& frame);
+    void pushCopy(const cv::Mat& frame);
+    void clear();
+    void reset(size_t capacity, int downscale = 0);
+
+    // Access by age: 0 is the newest frame, size() - 1 the oldest
+    const cv::Mat& at(size_t age) const;
+    const cv::Mat& downscaledAt(size_t age) const;
+    const cv::Mat& newest() const { return at(0); }
+
+    // Status
+    size_t size() const { return count_; }
+    size_t capacity() const { return slots_.size(); }
+    bool empty() const { return count_ == 0; }
+    bool isFull() const { return count_ == slots_.size(); }
+    int getDownscale() const { return downscale_; }
+
+private:
+    struct Slot {
+        cv::Mat frame;
+        cv::Mat downscaled;
+    };
+
+    size_t slotIndex(size_t age) const;
+    Slot& advance();
+    void updateDownscaled(Slot& slot);
+
+    std::vector<Slot> slots_;
+    size_t newest_;
+    size_t count_;
+    int downscale_;
+};
+
+} // namespace vision
+} // namespace glooms
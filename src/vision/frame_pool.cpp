@@ -0,0 +1,94 @@
+#include "vision/frame_pool.hpp"
+
+#include <algorithm>
+
+namespace glooms {
+namespace vision {
+
+FramePool::FramePool(size_t capacity)
+    : capacity_(capacity) {}
+
+bool FramePool::isFree(const cv::Mat& buffer) {
+    // The pool's own header is the only remaining reference. Other threads
+    // release their headers concurrently, so read the count the way OpenCV
+    // updates it: atomically.
+    return buffer.u && CV_XADD(&buffer.u->refcount, 0) == 1;
+}
+
+cv::Mat FramePool::acquire(cv::Size size, int type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.acquisitions++;
+
+    cv::Mat* reusable = nullptr;
+    for (auto& buffer : buffers_) {
+        if (!isFree(buffer)) {
+            continue;
+        }
+        if (buffer.size() == size && buffer.type() == type) {
+            return buffer;
+        }
+        if (!reusable) {
+            reusable = &buffer;
+        }
+    }
+
+    stats_.allocations++;
+
+    if (buffers_.size() < capacity_) {
+        buffers_.emplace_back(size, type);
+        return buffers_.back();
+    }
+
+    // Full: repurpose a free buffer of another shape before giving up
+    if (reusable) {
+        reusable->create(size, type);
+        return *reusable;
+    }
+
+    stats_.misses++;
+    return cv::Mat(size, type);
+}
+
+void FramePool::reserve(cv::Size size, int type, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t matching = static_cast<size_t>(std::count_if(buffers_.begin(), buffers_.end(),
+        [&](const cv::Mat& buffer) { return buffer.size() == size && buffer.type() == type; }));
+
+    while (matching < count && buffers_.size() < capacity_) {
+        buffers_.emplace_back(size, type);
+        stats_.allocations++;
+        matching++;
+    }
+}
+
+void FramePool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Headers still held by callers keep their buffers alive
+    buffers_.clear();
+}
+
+void FramePool::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    if (buffers_.size() > capacity_) {
+        buffers_.resize(capacity_);
+    }
+}
+
+size_t FramePool::getCapacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+FramePoolStats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FramePoolStats stats = stats_;
+    stats.pooled = buffers_.size();
+    stats.in_use = static_cast<size_t>(std::count_if(buffers_.begin(), buffers_.end(),
+        [](const cv::Mat& buffer) { return !isFree(buffer); }));
+    return stats;
+}
+
+} // namespace vision
+} // namespace glooms
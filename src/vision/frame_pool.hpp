@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// Pool statistics
+struct FramePoolStats {
+    uint64_t acquisitions = 0;
+    uint64_t allocations = 0;   // Buffers created or resized by the pool
+    uint64_t misses = 0;        // Pool exhausted, unpooled buffer returned
+    size_t pooled = 0;
+    size_t in_use = 0;
+};
+
+// Recycled cv::Mat buffers. acquire() hands out a header sharing one of
+// the pooled buffers; the buffer becomes free again as soon as every
+// header referencing it is released, so callers never return anything
+// explicitly. Thread-safe.
+class FramePool {
+public:
+    explicit FramePool(size_t capacity = 0);
+
+    // Delete copy constructor and assignment operator
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Core methods
+    cv::Mat acquire(cv::Size size, int type);
+    void reserve(cv::Size size, int type, size_t count);
+    void clear();
+
+    // Configuration methods
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const;
+
+    // Metrics
+    FramePoolStats getStats() const;
+
+private:
+    static bool isFree(const cv::Mat& buffer);
+
+    mutable std::mutex mutex_;
+    size_t capacity_;
+    std::vector<cv::Mat> buffers_;
+    FramePoolStats stats_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,207 @@
+#include "vision/int8_quantization.hpp"
+#include "vision/detector.hpp"
+#include "utils/tracer.hpp"
+
+#include <opencv2/core/version.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <map>
+
+// Net::quantize and INT8 layers arrived in OpenCV 4.6
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+#define GLOOMS_HAVE_DNN_QUANTIZE 1
+#endif
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    bool isImageFile(const std::filesystem::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp";
+    }
+
+    struct ScoredDetection {
+        float confidence;
+        size_t image;
+        cv::Rect box;
+    };
+
+    // All-point interpolated area under the precision/recall curve
+    float averagePrecision(std::vector<ScoredDetection>& candidates,
+                           const std::vector<std::vector<cv::Rect>>& truth,
+                           size_t truth_count, float iou_threshold) {
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const ScoredDetection& a, const ScoredDetection& b) {
+                      return a.confidence > b.confidence;
+                  });
+
+        std::vector<std::vector<bool>> used(truth.size());
+        for (size_t i = 0; i < truth.size(); ++i) {
+            used[i].assign(truth[i].size(), false);
+        }
+
+        std::vector<float> precision;
+        std::vector<float> recall;
+        size_t true_positives = 0;
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            const auto& candidate = candidates[k];
+            const auto& boxes = truth[candidate.image];
+
+            int best = -1;
+            float best_iou = iou_threshold;
+            for (size_t t = 0; t < boxes.size(); ++t) {
+                float iou = Detector::calculateIoU(candidate.box, boxes[t]);
+                if (iou >= best_iou && !used[candidate.image][t]) {
+                    best_iou = iou;
+                    best = static_cast<int>(t);
+                }
+            }
+            if (best >= 0) {
+                used[candidate.image][best] = true;
+                true_positives++;
+            }
+            precision.push_back(float(true_positives) / (k + 1));
+            recall.push_back(float(true_positives) / truth_count);
+        }
+
+        // Make precision monotonically decreasing, then integrate over recall
+        for (size_t k = precision.size(); k-- > 1;) {
+            precision[k - 1] = std::max(precision[k - 1], precision[k]);
+        }
+        float ap = 0.0f;
+        float previous_recall = 0.0f;
+        for (size_t k = 0; k < precision.size(); ++k) {
+            ap += (recall[k] - previous_recall) * precision[k];
+            previous_recall = recall[k];
+        }
+        return ap;
+    }
+}
+
+bool isQuantizationSupported() {
+#ifdef GLOOMS_HAVE_DNN_QUANTIZE
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string int8ModelPath(const std::string& model_path) {
+    if (model_path.empty()) {
+        return "";
+    }
+    std::filesystem::path path(model_path);
+    std::filesystem::path quantized = path.parent_path() /
+        (path.stem().string() + ".int8" + path.extension().string());
+    return quantized.string();
+}
+
+std::vector<std::string> listImages(const std::string& directory, size_t limit) {
+    std::vector<std::string> images;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec) && isImageFile(entry.path())) {
+            images.push_back(entry.path().string());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    if (limit > 0 && images.size() > limit) {
+        images.resize(limit);
+    }
+    return images;
+}
+
+bool quantizeNet(cv::dnn::Net& net, const std::vector<cv::Mat>& calibration,
+                 bool per_channel, std::string& error) {
+    TRACE_SPAN_CAT("quantizeNet", "vision");
+#ifdef GLOOMS_HAVE_DNN_QUANTIZE
+    if (calibration.empty()) {
+        error = "No calibration data";
+        return false;
+    }
+    try {
+        cv::dnn::Net quantized = net.quantize(calibration, CV_32F, CV_32F, per_channel);
+        if (quantized.empty()) {
+            error = "Quantization produced an empty network";
+            return false;
+        }
+        net = quantized;
+        return true;
+    } catch (const cv::Exception& e) {
+        error = e.what();
+        return false;
+    }
+#else
+    (void)net;
+    (void)calibration;
+    (void)per_channel;
+    error = "OpenCV " CV_VERSION " cannot quantize networks (needs 4.6 or later)";
+    return false;
+#endif
+}
+
+bool getQuantizationDetails(const cv::dnn::Net& net, QuantizationDetails& details) {
+#ifdef GLOOMS_HAVE_DNN_QUANTIZE
+    try {
+        net.getInputDetails(details.input_scales, details.input_zeropoints);
+        net.getOutputDetails(details.output_scales, details.output_zeropoints);
+        return true;
+    } catch (const cv::Exception&) {
+        // Not a quantized network
+        return false;
+    }
+#else
+    (void)net;
+    (void)details;
+    return false;
+#endif
+}
+
+float meanAveragePrecision(const std::vector<std::vector<Detection>>& reference,
+                           const std::vector<std::vector<Detection>>& candidate,
+                           float iou_threshold) {
+    // Ground truth per class, per image
+    std::map<int, std::vector<std::vector<cv::Rect>>> truth;
+    std::map<int, size_t> truth_count;
+    for (size_t image = 0; image < reference.size(); ++image) {
+        for (const auto& det : reference[image]) {
+            auto& boxes = truth[det.class_id];
+            boxes.resize(reference.size());
+            boxes[image].push_back(det.box);
+            truth_count[det.class_id]++;
+        }
+    }
+
+    if (truth.empty()) {
+        // Nothing to find: perfect only if nothing was reported
+        for (const auto& dets : candidate) {
+            if (!dets.empty()) {
+                return 0.0f;
+            }
+        }
+        return 1.0f;
+    }
+
+    std::map<int, std::vector<ScoredDetection>> scored;
+    for (size_t image = 0; image < candidate.size() && image < reference.size(); ++image) {
+        for (const auto& det : candidate[image]) {
+            if (truth.count(det.class_id)) {
+                scored[det.class_id].push_back(ScoredDetection{det.confidence, image, det.box});
+            }
+        }
+    }
+
+    float sum = 0.0f;
+    for (const auto& [class_id, boxes] : truth) {
+        sum += averagePrecision(scored[class_id], boxes, truth_count[class_id], iou_threshold);
+    }
+    return sum / truth.size();
+}
+
+} // namespace vision
+} // namespace glooms
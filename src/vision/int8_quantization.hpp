@@ -0,0 +1,49 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <string>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+struct Detection;
+
+// Input and output quantization parameters of an INT8 network, one
+// entry per tensor: real = scale * (quantized - zeropoint)
+struct QuantizationDetails {
+    std::vector<float> input_scales;
+    std::vector<int> input_zeropoints;
+    std::vector<float> output_scales;
+    std::vector<int> output_zeropoints;
+};
+
+// Whether this OpenCV build can quantize networks (Net::quantize, 4.6+)
+bool isQuantizationSupported();
+
+// Where a pre-quantized model is looked for: model.onnx -> model.int8.onnx
+std::string int8ModelPath(const std::string& model_path);
+
+// Image files in `directory`, sorted by name; at most `limit` unless 0
+std::vector<std::string> listImages(const std::string& directory, size_t limit = 0);
+
+// Replaces `net` with an INT8 copy whose activation scales come from
+// running the calibration blobs. Inputs and outputs stay FP32, so
+// preprocessing and decoding are unchanged. On failure `net` is left as
+// it was and `error` says why.
+bool quantizeNet(cv::dnn::Net& net, const std::vector<cv::Mat>& calibration,
+                 bool per_channel, std::string& error);
+
+bool getQuantizationDetails(const cv::dnn::Net& net, QuantizationDetails& details);
+
+// Mean average precision of `candidate` detections at an IoU threshold,
+// treating `reference` detections (per image) as ground truth. Per-class
+// AP uses all-point interpolation; classes absent from the reference are
+// not scored.
+float meanAveragePrecision(const std::vector<std::vector<Detection>>& reference,
+                           const std::vector<std::vector<Detection>>& candidate,
+                           float iou_threshold = 0.5f);
+
+} // namespace vision
+} // namespace glooms
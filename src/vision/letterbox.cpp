@@ -0,0 +1,138 @@
+#include "vision/letterbox.hpp"
+#include "utils/tracer.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    constexpr int kRowsPerStripe = 16;
+
+    // Source coordinate of output sample `i` under cv::resize's
+    // INTER_LINEAR convention (pixel centres aligned), clamped to the edge
+    inline void sourceTap(int i, float ratio, int length, int& i0, int& i1, float& weight) {
+        float s = std::max(0.0f, (i + 0.5f) * ratio - 0.5f);
+        i0 = std::min(static_cast<int>(s), length - 1);
+        i1 = std::min(i0 + 1, length - 1);
+        weight = i0 == i1 ? 0.0f : s - i0;
+    }
+}
+
+void Letterbox::ensureBlob(cv::Mat& blob, int batch, cv::Size input_size) {
+    const int shape[] = {batch, 3, input_size.height, input_size.width};
+    blob.create(4, shape, CV_32F);
+}
+
+LetterboxTransform Letterbox::run(const cv::Mat& frame, cv::Mat& blob, int index,
+                                  const LetterboxParams& params) {
+    TRACE_SPAN_CAT("Letterbox::run", "vision");
+    CV_Assert(!frame.empty() && frame.depth() == CV_8U);
+
+    const int width = params.input_size.width;
+    const int height = params.input_size.height;
+    CV_Assert(blob.type() == CV_32F && blob.dims == 4 && blob.size[1] == 3 &&
+              blob.size[2] == height && blob.size[3] == width &&
+              index >= 0 && index < blob.size[0]);
+
+    const cv::Mat* source = &frame;
+    if (frame.channels() != 3) {
+        cv::cvtColor(frame, bgr_, frame.channels() == 4 ? cv::COLOR_BGRA2BGR : cv::COLOR_GRAY2BGR);
+        source = &bgr_;
+    }
+    const cv::Mat& src = *source;
+
+    // Content size and placement in the input
+    int content_w = width;
+    int content_h = height;
+    if (params.keep_aspect) {
+        double ratio = std::min(double(width) / src.cols, double(height) / src.rows);
+        content_w = std::clamp(static_cast<int>(std::lround(src.cols * ratio)), 1, width);
+        content_h = std::clamp(static_cast<int>(std::lround(src.rows * ratio)), 1, height);
+    }
+    const int pad_x = (width - content_w) / 2;
+    const int pad_y = (height - content_h) / 2;
+
+    LetterboxTransform transform;
+    transform.scale_x = float(content_w) / src.cols;
+    transform.scale_y = float(content_h) / src.rows;
+    transform.pad_x = static_cast<float>(pad_x);
+    transform.pad_y = static_cast<float>(pad_y);
+
+    // Horizontal taps are the same for every row
+    const float ratio_x = float(src.cols) / content_w;
+    x0_.resize(content_w);
+    x1_.resize(content_w);
+    wx_.resize(content_w);
+    for (int x = 0; x < content_w; ++x) {
+        int i0, i1;
+        sourceTap(x, ratio_x, src.cols, i0, i1, wx_[x]);
+        x0_[x] = 3 * i0;
+        x1_[x] = 3 * i1;
+    }
+
+    const size_t plane_size = static_cast<size_t>(width) * height;
+    float* base = blob.ptr<float>() + static_cast<size_t>(index) * 3 * plane_size;
+    float* planes[3];
+    for (int c = 0; c < 3; ++c) {
+        // Source channel c goes to plane 2 - c when swapping
+        planes[c] = base + (params.swap_rb ? 2 - c : c) * plane_size;
+    }
+
+    const float scale = params.scale;
+    const float pad = params.pad_value * params.scale;
+    const float ratio_y = float(src.rows) / content_h;
+    const int* x0 = x0_.data();
+    const int* x1 = x1_.data();
+    const float* wx = wx_.data();
+
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; ++y) {
+            float* out[3];
+            for (int c = 0; c < 3; ++c) {
+                out[c] = planes[c] + static_cast<size_t>(y) * width;
+            }
+
+            const int cy = y - pad_y;
+            if (cy < 0 || cy >= content_h) {
+                for (int c = 0; c < 3; ++c) {
+                    std::fill(out[c], out[c] + width, pad);
+                }
+                continue;
+            }
+
+            for (int c = 0; c < 3; ++c) {
+                std::fill(out[c], out[c] + pad_x, pad);
+                std::fill(out[c] + pad_x + content_w, out[c] + width, pad);
+                out[c] += pad_x;
+            }
+
+            int y0, y1;
+            float wy;
+            sourceTap(cy, ratio_y, src.rows, y0, y1, wy);
+            const uchar* top = src.ptr<uchar>(y0);
+            const uchar* bottom = src.ptr<uchar>(y1);
+
+            for (int x = 0; x < content_w; ++x) {
+                const uchar* tl = top + x0[x];
+                const uchar* tr = top + x1[x];
+                const uchar* bl = bottom + x0[x];
+                const uchar* br = bottom + x1[x];
+                const float w = wx[x];
+                for (int c = 0; c < 3; ++c) {
+                    float t = tl[c] + (tr[c] - tl[c]) * w;
+                    float b = bl[c] + (br[c] - bl[c]) * w;
+                    out[c][x] = (t + (b - t) * wy) * scale;
+                }
+            }
+        }
+    }, std::max(1, height / kRowsPerStripe));
+
+    return transform;
+}
+
+} // namespace vision
+} // namespace glooms
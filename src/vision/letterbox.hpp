@@ -0,0 +1,48 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// Where a frame landed in the network input:
+// input = frame * scale + pad, per axis
+struct LetterboxTransform {
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    float pad_x = 0.0f;
+    float pad_y = 0.0f;
+};
+
+struct LetterboxParams {
+    cv::Size input_size = cv::Size(416, 416);
+    bool keep_aspect = true;            // Pad instead of stretching
+    float scale = 1.0f / 255.0f;        // Applied to every output value
+    float pad_value = 114.0f;           // Border colour, in pixel units
+    bool swap_rb = true;                // BGR frames in, RGB planes out
+};
+
+// Resizes BGR frames straight into planar float network input. Bilinear
+// sampling, channel swap, scaling and border fill happen in one pass over
+// the output, so no intermediate resized or converted image exists. The
+// caller owns the blob and keeps it between frames. Not thread-safe.
+class Letterbox {
+public:
+    // Writes image `index` of an [N, 3, height, width] CV_32F blob and
+    // returns the transform that maps frame coordinates into it
+    LetterboxTransform run(const cv::Mat& frame, cv::Mat& blob, int index,
+                           const LetterboxParams& params);
+
+    // Allocates the blob only when its shape changes
+    static void ensureBlob(cv::Mat& blob, int batch, cv::Size input_size);
+
+private:
+    cv::Mat bgr_;                       // Conversion buffer for non-BGR frames
+    std::vector<int> x0_;               // Byte offset of the left source pixel
+    std::vector<int> x1_;               // Byte offset of the right source pixel
+    std::vector<float> wx_;             // Weight of the right source pixel
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,99 @@
+#include "vision/motion_gate.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+namespace glooms {
+namespace vision {
+
+MotionGate::MotionGate(const MotionGateConfig& config)
+    : config_(config)
+    , skipped_in_row_(0)
+    , evaluated_frames_(0)
+    , skipped_frames_(0) {
+    config_.downscale = std::max(1, config_.downscale);
+    config_.block_size = std::max(1, config_.block_size);
+}
+
+void MotionGate::reset() {
+    reference_.release();
+    motion_regions_.clear();
+    skipped_in_row_ = 0;
+}
+
+bool MotionGate::update(const cv::Mat& frame) {
+    evaluated_frames_++;
+
+    cv::Size small_size(
+        std::max(1, frame.cols / config_.downscale),
+        std::max(1, frame.rows / config_.downscale)
+    );
+    cv::resize(frame, small_, small_size, 0, 0, cv::INTER_AREA);
+    if (small_.channels() == 3) {
+        cv::cvtColor(small_, gray_, cv::COLOR_RGB2GRAY);
+    } else {
+        small_.copyTo(gray_);
+    }
+
+    // Nothing to compare against: treat the whole frame as changed
+    if (reference_.empty() || reference_.size() != gray_.size()) {
+        block_map_.release();
+        motion_regions_.assign(1, cv::Rect(0, 0, frame.cols, frame.rows));
+        cv::swap(reference_, gray_);
+        skipped_in_row_ = 0;
+        return true;
+    }
+
+    // Block means of the absolute difference; INTER_AREA averages exactly
+    // when the block grid divides the image
+    cv::absdiff(gray_, reference_, diff_);
+    cv::Size grid(
+        std::max(1, gray_.cols / config_.block_size),
+        std::max(1, gray_.rows / config_.block_size)
+    );
+    cv::resize(diff_, block_means_, grid, 0, 0, cv::INTER_AREA);
+    cv::threshold(block_means_, block_map_, config_.threshold, 255, cv::THRESH_BINARY);
+
+    int changed = cv::countNonZero(block_map_);
+    bool refresh = skipped_in_row_ >= config_.max_skipped_frames;
+
+    if (changed < config_.min_changed_blocks && !refresh) {
+        motion_regions_.clear();
+        skipped_in_row_++;
+        skipped_frames_++;
+        return false;
+    }
+
+    buildRegions(frame.size());
+    cv::swap(reference_, gray_);
+    skipped_in_row_ = 0;
+    return true;
+}
+
+void MotionGate::buildRegions(cv::Size frame_size) {
+    motion_regions_.clear();
+    if (block_map_.empty()) {
+        return;
+    }
+
+    // Scale from block grid to frame coordinates
+    double scale_x = static_cast<double>(frame_size.width) / block_map_.cols;
+    double scale_y = static_cast<double>(frame_size.height) / block_map_.rows;
+    cv::Rect bounds(0, 0, frame_size.width, frame_size.height);
+
+    cv::findContours(block_map_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    for (const auto& contour : contours_) {
+        cv::Rect blocks = cv::boundingRect(contour);
+        cv::Rect region(
+            cvFloor(blocks.x * scale_x),
+            cvFloor(blocks.y * scale_y),
+            cvCeil(blocks.width * scale_x),
+            cvCeil(blocks.height * scale_y)
+        );
+        motion_regions_.push_back(region & bounds);
+    }
+}
+
+} // namespace vision
+} // namespace glooms
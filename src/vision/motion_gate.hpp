@@ -0,0 +1,63 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+struct MotionGateConfig {
+    int downscale = 8;              // Frame is shrunk by this factor first
+    int block_size = 8;             // Block edge, in downscaled pixels
+    float threshold = 12.0f;        // Mean absolute gray difference per block
+    int min_changed_blocks = 1;     // Blocks that must change to run inference
+    int max_skipped_frames = 30;    // Force a refresh after this many skips
+};
+
+// Decides per frame whether inference needs to run. Each frame is
+// compared against the frame the last inference ran on, so slow drift
+// accumulates until it crosses the threshold.
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateConfig& config = MotionGateConfig());
+
+    // Delete copy constructor and assignment operator
+    MotionGate(const MotionGate&) = delete;
+    MotionGate& operator=(const MotionGate&) = delete;
+
+    // Returns true when inference should run on this frame
+    bool update(const cv::Mat& frame);
+    void reset();
+
+    // Changed regions of the last update, in frame coordinates
+    const std::vector<cv::Rect>& getMotionRegions() const { return motion_regions_; }
+    const cv::Mat& getBlockMap() const { return block_map_; }
+
+    // Metrics
+    uint64_t getEvaluatedFrames() const { return evaluated_frames_.load(); }
+    uint64_t getSkippedFrames() const { return skipped_frames_.load(); }
+
+private:
+    void buildRegions(cv::Size frame_size);
+
+    MotionGateConfig config_;
+    int skipped_in_row_;
+
+    // Scratch buffers, reused across frames
+    cv::Mat small_;
+    cv::Mat gray_;
+    cv::Mat reference_;
+    cv::Mat diff_;
+    cv::Mat block_means_;
+    cv::Mat block_map_;
+    std::vector<std::vector<cv::Point>> contours_;
+    std::vector<cv::Rect> motion_regions_;
+
+    std::atomic<uint64_t> evaluated_frames_;
+    std::atomic<uint64_t> skipped_frames_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,245 @@
+#include "vision/nms.hpp"
+#include "vision/simd.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    // Same operations, in the same order, as Detector::calculateIoU; the
+    // coordinates are exact small integers, so results match bit for bit
+    inline float iouScalar(float ax1, float ay1, float ax2, float ay2, float a_area,
+                           float bx1, float by1, float bx2, float by2, float b_area) {
+        float w = std::max(0.0f, std::min(ax2, bx2) - std::max(ax1, bx1));
+        float h = std::max(0.0f, std::min(ay2, by2) - std::max(ay1, by1));
+        float intersection = w * h;
+        return intersection / (a_area + b_area - intersection);
+    }
+
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    __attribute__((target("avx2")))
+    size_t iouAvx2(float ax1, float ay1, float ax2, float ay2, float a_area,
+                   const float* x1, const float* y1, const float* x2, const float* y2,
+                   const float* area, float* iou, size_t begin, size_t end) {
+        const __m256 rx1 = _mm256_set1_ps(ax1);
+        const __m256 ry1 = _mm256_set1_ps(ay1);
+        const __m256 rx2 = _mm256_set1_ps(ax2);
+        const __m256 ry2 = _mm256_set1_ps(ay2);
+        const __m256 r_area = _mm256_set1_ps(a_area);
+        const __m256 zero = _mm256_setzero_ps();
+
+        size_t j = begin;
+        for (; j + 8 <= end; j += 8) {
+            __m256 w = _mm256_sub_ps(_mm256_min_ps(rx2, _mm256_loadu_ps(x2 + j)),
+                                     _mm256_max_ps(rx1, _mm256_loadu_ps(x1 + j)));
+            __m256 h = _mm256_sub_ps(_mm256_min_ps(ry2, _mm256_loadu_ps(y2 + j)),
+                                     _mm256_max_ps(ry1, _mm256_loadu_ps(y1 + j)));
+            __m256 intersection = _mm256_mul_ps(_mm256_max_ps(w, zero), _mm256_max_ps(h, zero));
+            __m256 uni = _mm256_sub_ps(_mm256_add_ps(r_area, _mm256_loadu_ps(area + j)), intersection);
+            _mm256_storeu_ps(iou + j, _mm256_div_ps(intersection, uni));
+        }
+        return j;
+    }
+#endif
+}
+
+void NmsBoxes::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+    area.clear();
+    score.clear();
+    class_id.clear();
+}
+
+void NmsBoxes::reserve(size_t count) {
+    x1.reserve(count);
+    y1.reserve(count);
+    x2.reserve(count);
+    y2.reserve(count);
+    area.reserve(count);
+    score.reserve(count);
+    class_id.reserve(count);
+}
+
+void NmsBoxes::push(const cv::Rect& box, float confidence, int id) {
+    x1.push_back(static_cast<float>(box.x));
+    y1.push_back(static_cast<float>(box.y));
+    x2.push_back(static_cast<float>(box.x + box.width));
+    y2.push_back(static_cast<float>(box.y + box.height));
+    area.push_back(static_cast<float>(box.width * box.height));
+    score.push_back(confidence);
+    class_id.push_back(id);
+}
+
+void NonMaxSuppressor::run(NmsBoxes& boxes, const NmsParams& params, std::vector<int>& keep) {
+    TRACE_SPAN_CAT("NonMaxSuppressor::run", "vision");
+    keep.clear();
+
+    const size_t count = boxes.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Group by class, best score first within each group
+    order_.resize(count);
+    std::iota(order_.begin(), order_.end(), 0);
+    const bool class_aware = params.class_aware;
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+        if (class_aware && boxes.class_id[a] != boxes.class_id[b]) {
+            return boxes.class_id[a] < boxes.class_id[b];
+        }
+        if (boxes.score[a] != boxes.score[b]) {
+            return boxes.score[a] > boxes.score[b];
+        }
+        return a < b;
+    });
+
+    for (size_t begin = 0; begin < count;) {
+        size_t end = begin + 1;
+        while (end < count &&
+               (!class_aware || boxes.class_id[order_[end]] == boxes.class_id[order_[begin]])) {
+            end++;
+        }
+
+        gather(boxes, begin, end);
+        if (params.method == NmsMethod::HARD) {
+            sweepHard(params, keep);
+        } else {
+            sweepSoft(boxes, params, keep);
+        }
+        begin = end;
+    }
+
+    // Merge the classes back into one descending-score list
+    std::sort(keep.begin(), keep.end(), [&](int a, int b) {
+        if (boxes.score[a] != boxes.score[b]) {
+            return boxes.score[a] > boxes.score[b];
+        }
+        return a < b;
+    });
+}
+
+void NonMaxSuppressor::gather(const NmsBoxes& boxes, size_t begin, size_t end) {
+    const size_t count = end - begin;
+    x1_.resize(count);
+    y1_.resize(count);
+    x2_.resize(count);
+    y2_.resize(count);
+    area_.resize(count);
+    score_.resize(count);
+    index_.resize(count);
+    iou_.resize(count);
+
+    for (size_t k = 0; k < count; ++k) {
+        int i = order_[begin + k];
+        x1_[k] = boxes.x1[i];
+        y1_[k] = boxes.y1[i];
+        x2_[k] = boxes.x2[i];
+        y2_[k] = boxes.y2[i];
+        area_[k] = boxes.area[i];
+        score_[k] = boxes.score[i];
+        index_[k] = i;
+    }
+}
+
+void NonMaxSuppressor::computeIoU(size_t reference, size_t begin, size_t end, bool simd) {
+    const size_t r = reference;
+    size_t j = begin;
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    if (simd) {
+        j = iouAvx2(x1_[r], y1_[r], x2_[r], y2_[r], area_[r],
+                    x1_.data(), y1_.data(), x2_.data(), y2_.data(), area_.data(),
+                    iou_.data(), begin, end);
+    }
+#else
+    (void)simd;
+#endif
+    for (; j < end; ++j) {
+        iou_[j] = iouScalar(x1_[r], y1_[r], x2_[r], y2_[r], area_[r],
+                            x1_[j], y1_[j], x2_[j], y2_[j], area_[j]);
+    }
+}
+
+void NonMaxSuppressor::sweepHard(const NmsParams& params, std::vector<int>& keep) {
+    static const bool has_avx2 = detectAvx2();
+    const bool simd = params.allow_simd && has_avx2;
+    const size_t count = x1_.size();
+    removed_.assign(count, 0);
+
+    // Suppressed boxes are flagged rather than compacted away: in sparse
+    // scenes most boxes survive and the flag update stays branch-free
+    for (size_t i = 0; i < count; ++i) {
+        if (removed_[i]) {
+            continue;
+        }
+        keep.push_back(index_[i]);
+
+        computeIoU(i, i + 1, count, simd);
+        for (size_t j = i + 1; j < count; ++j) {
+            removed_[j] |= static_cast<uint8_t>(iou_[j] > params.iou_threshold);
+        }
+    }
+}
+
+void NonMaxSuppressor::sweepSoft(NmsBoxes& boxes, const NmsParams& params, std::vector<int>& keep) {
+    static const bool has_avx2 = detectAvx2();
+    const bool simd = params.allow_simd && has_avx2;
+    const bool gaussian = params.method == NmsMethod::SOFT_GAUSSIAN;
+    const float sigma = std::max(params.soft_sigma, 1e-6f);
+
+    auto swapBoxes = [this](size_t a, size_t b) {
+        std::swap(x1_[a], x1_[b]);
+        std::swap(y1_[a], y1_[b]);
+        std::swap(x2_[a], x2_[b]);
+        std::swap(y2_[a], y2_[b]);
+        std::swap(area_[a], area_[b]);
+        std::swap(score_[a], score_[b]);
+        std::swap(index_[a], index_[b]);
+    };
+
+    // Scores change as boxes are decayed, so each round selects the
+    // current best from the live range [i, active)
+    size_t active = x1_.size();
+    for (size_t i = 0; i < active; ++i) {
+        size_t best = i;
+        for (size_t k = i + 1; k < active; ++k) {
+            if (score_[k] > score_[best] ||
+                (score_[k] == score_[best] && index_[k] < index_[best])) {
+                best = k;
+            }
+        }
+        swapBoxes(i, best);
+
+        keep.push_back(index_[i]);
+        boxes.score[index_[i]] = score_[i];
+
+        computeIoU(i, i + 1, active, simd);
+        for (size_t j = i + 1; j < active;) {
+            float iou = iou_[j];
+            if (gaussian) {
+                score_[j] *= std::exp(-(iou * iou) / sigma);
+            } else if (iou > params.iou_threshold) {
+                score_[j] *= 1.0f - iou;
+            }
+
+            // Decayed out: move it past the live range
+            if (score_[j] <= params.score_threshold) {
+                active--;
+                swapBoxes(j, active);
+                std::swap(iou_[j], iou_[active]);
+            } else {
+                ++j;
+            }
+        }
+    }
+}
+
+} // namespace vision
+} // namespace glooms
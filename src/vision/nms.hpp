@@ -0,0 +1,65 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+enum class NmsMethod {
+    HARD,               // Drop boxes overlapping a better one
+    SOFT_LINEAR,        // Scale overlapping scores by (1 - IoU) above the threshold
+    SOFT_GAUSSIAN       // Scale every overlapping score by exp(-IoU^2 / sigma)
+};
+
+struct NmsParams {
+    float iou_threshold = 0.4f;
+    bool class_aware = true;            // Only boxes of the same class suppress each other
+    NmsMethod method = NmsMethod::HARD;
+    float soft_sigma = 0.5f;            // SOFT_GAUSSIAN spread
+    float score_threshold = 0.0f;       // Soft-NMS drops boxes decayed to or below this
+    bool allow_simd = true;
+};
+
+// Candidate boxes in structure-of-arrays layout, so IoU against one box
+// is computed for 8 candidates at a time. Coordinates are the integer
+// rect corners as floats, which keeps IoU identical to
+// Detector::calculateIoU.
+struct NmsBoxes {
+    std::vector<float> x1, y1, x2, y2, area;
+    std::vector<float> score;           // Soft-NMS writes decayed scores back here
+    std::vector<int> class_id;
+
+    void clear();
+    void reserve(size_t count);
+    void push(const cv::Rect& box, float confidence, int class_id);
+    size_t size() const { return score.size(); }
+};
+
+// Reusable sort-and-sweep NMS. Boxes are ordered by class and descending
+// score, each class is gathered into contiguous arrays and swept, and
+// the indices of surviving boxes come back ordered by descending score.
+// Nothing is copied but indices and coordinates; scratch buffers are kept
+// between calls. Not thread-safe.
+class NonMaxSuppressor {
+public:
+    void run(NmsBoxes& boxes, const NmsParams& params, std::vector<int>& keep);
+
+private:
+    void gather(const NmsBoxes& boxes, size_t begin, size_t end);
+    void sweepHard(const NmsParams& params, std::vector<int>& keep);
+    void sweepSoft(NmsBoxes& boxes, const NmsParams& params, std::vector<int>& keep);
+    void computeIoU(size_t reference, size_t begin, size_t end, bool simd);
+
+    // Current class, in sorted order
+    std::vector<int> order_;
+    std::vector<float> x1_, y1_, x2_, y2_, area_, score_;
+    std::vector<int> index_;
+    std::vector<float> iou_;
+    std::vector<uint8_t> removed_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,198 @@
+#include "vision/preprocess_kernels.hpp"
+#include "vision/simd.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+namespace {
+    // The 3x3 Gaussian for sigma 0 is [1 2 1] x [1 2 1] / 16. OpenCV's
+    // bit-exact fixed-point path reduces to (sum + 8) >> 4 for it, which
+    // is what both variants below compute.
+    //
+    // Each output row is built from one row of vertical sums kept in a
+    // small per-thread buffer: V[j] = top[j] + 2 * mid[j] + bottom[j],
+    // padded by one reflected pixel on each side. The horizontal pass then
+    // reads V at BGR index k = i + 2 - 2 * (i % 3) for RGB output index i,
+    // which performs the channel swap without a separate pass.
+    constexpr int kGuard = 16;          // Slack around the padded row
+    constexpr int kRowsPerStripe = 16;
+
+    inline int reflect101(int index, int length) {
+        if (index < 0) return -index;
+        if (index >= length) return 2 * length - index - 2;
+        return index;
+    }
+
+    inline uchar blurAt(const uint16_t* v) {
+        return static_cast<uchar>((v[0] + 2 * v[3] + v[6] + 8) >> 4);
+    }
+
+    void verticalSumScalar(const uchar* top, const uchar* mid, const uchar* bottom,
+                           uint16_t* sums, int begin, int length) {
+        for (int j = begin; j < length; ++j) {
+            sums[j] = static_cast<uint16_t>(top[j] + 2 * mid[j] + bottom[j]);
+        }
+    }
+
+    void horizontalSwapScalar(const uint16_t* padded, uchar* out, int begin, int length) {
+        for (int i = begin; i < length; ++i) {
+            out[i] = blurAt(padded + i + 2 - 2 * (i % 3));
+        }
+    }
+
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    // Lane l of a 16-lane block starting at index i takes the value two
+    // ahead when (i + l) % 3 == 0 and two behind when (i + l) % 3 == 2;
+    // blocks start at three possible phases
+    struct SwapMasks {
+        alignas(32) uint16_t ahead[3][16];
+        alignas(32) uint16_t behind[3][16];
+
+        SwapMasks() {
+            for (int phase = 0; phase < 3; ++phase) {
+                for (int lane = 0; lane < 16; ++lane) {
+                    int channel = (phase + lane) % 3;
+                    ahead[phase][lane] = channel == 0 ? 0xFFFF : 0;
+                    behind[phase][lane] = channel == 2 ? 0xFFFF : 0;
+                }
+            }
+        }
+    };
+
+    const SwapMasks kSwapMasks;
+
+    __attribute__((target("avx2")))
+    inline __m256i blurAtAvx2(const uint16_t* v) {
+        __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v));
+        __m256i center = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + 3));
+        __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + 6));
+        __m256i sum = _mm256_add_epi16(_mm256_add_epi16(left, right),
+                                       _mm256_slli_epi16(center, 1));
+        return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(8)), 4);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i swapBlockAvx2(const uint16_t* padded, int i) {
+        int phase = i % 3;
+        __m256i ahead = _mm256_load_si256(reinterpret_cast<const __m256i*>(kSwapMasks.ahead[phase]));
+        __m256i behind = _mm256_load_si256(reinterpret_cast<const __m256i*>(kSwapMasks.behind[phase]));
+
+        __m256i result = blurAtAvx2(padded + i);
+        result = _mm256_blendv_epi8(result, blurAtAvx2(padded + i + 2), ahead);
+        return _mm256_blendv_epi8(result, blurAtAvx2(padded + i - 2), behind);
+    }
+
+    __attribute__((target("avx2")))
+    int verticalSumAvx2(const uchar* top, const uchar* mid, const uchar* bottom,
+                        uint16_t* sums, int length) {
+        int j = 0;
+        for (; j + 32 <= length; j += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + j));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + j));
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + j));
+
+            __m256i low = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)),
+                                 _mm256_cvtepu8_epi16(_mm256_castsi256_si128(c))),
+                _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)), 1));
+            __m256i high = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)),
+                                 _mm256_cvtepu8_epi16(_mm256_extracti128_si256(c, 1))),
+                _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)), 1));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + j), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + j + 16), high);
+        }
+        return j;
+    }
+
+    __attribute__((target("avx2")))
+    int horizontalSwapAvx2(const uint16_t* padded, uchar* out, int length) {
+        int i = 0;
+        for (; i + 32 <= length; i += 32) {
+            __m256i low = swapBlockAvx2(padded, i);
+            __m256i high = swapBlockAvx2(padded, i + 16);
+            // packus interleaves 128-bit lanes; restore linear order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        return i;
+    }
+#endif
+
+    void processRows(const cv::Mat& input, cv::Mat& output, const cv::Range& range, bool simd) {
+        const int rows = input.rows;
+        const int length = input.cols * 3;
+
+        thread_local std::vector<uint16_t> buffer;
+        buffer.resize(static_cast<size_t>(length + 6 + 2 * kGuard));
+        uint16_t* padded = buffer.data() + kGuard;
+        uint16_t* sums = padded + 3;
+#ifndef GLOOMS_HAVE_AVX2_KERNELS
+        (void)simd;
+#endif
+
+        for (int y = range.start; y < range.end; ++y) {
+            const uchar* top = input.ptr<uchar>(reflect101(y - 1, rows));
+            const uchar* mid = input.ptr<uchar>(y);
+            const uchar* bottom = input.ptr<uchar>(reflect101(y + 1, rows));
+            uchar* out = output.ptr<uchar>(y);
+
+            int done = 0;
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+            if (simd) {
+                done = verticalSumAvx2(top, mid, bottom, sums, length);
+            }
+#endif
+            verticalSumScalar(top, mid, bottom, sums, done, length);
+
+            // Reflected border pixels: column -1 is column 1, column W is W - 2
+            for (int c = 0; c < 3; ++c) {
+                padded[c] = sums[3 + c];
+                padded[length + 3 + c] = sums[length - 6 + c];
+            }
+
+            done = 0;
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+            if (simd) {
+                done = horizontalSwapAvx2(padded, out, length);
+            }
+#endif
+            horizontalSwapScalar(padded, out, done, length);
+        }
+    }
+}
+
+bool hasSimdPreprocessing() {
+    static const bool available = detectAvx2();
+    return available;
+}
+
+void fusedBgrToRgbBlur3x3(const cv::Mat& input, cv::Mat& output, bool allow_simd) {
+    CV_Assert(input.type() == CV_8UC3);
+    CV_Assert(input.data != output.data);
+
+    // Reflection needs at least two pixels in each direction
+    if (input.rows < 2 || input.cols < 2) {
+        cv::Mat rgb;
+        cv::cvtColor(input, rgb, cv::COLOR_BGR2RGB);
+        cv::GaussianBlur(rgb, output, cv::Size(3, 3), 0);
+        return;
+    }
+
+    output.create(input.size(), CV_8UC3);
+    const bool simd = allow_simd && hasSimdPreprocessing();
+
+    cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& range) {
+        processRows(input, output, range, simd);
+    }, std::max(1, input.rows / kRowsPerStripe));
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace glooms {
+namespace vision {
+
+// BGR -> RGB swap fused with a 3x3 Gaussian blur (sigma 0, BORDER_REFLECT_101)
+// in a single row-parallel pass. Output is bit-exact with
+// cv::cvtColor(COLOR_BGR2RGB) followed by cv::GaussianBlur(Size(3, 3), 0).
+// Input must be CV_8UC3 and must not share memory with the output.
+void fusedBgrToRgbBlur3x3(const cv::Mat& input, cv::Mat& output, bool allow_simd = true);
+
+// True when the AVX2 variant of the fused kernels is used on this CPU
+bool hasSimdPreprocessing();
+
+} // namespace vision
+} // namespace glooms
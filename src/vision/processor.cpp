@@ -1,11 +1,15 @@
 #include "vision/processor.hpp"
+#include "vision/preprocess_kernels.hpp"
 #include "utils/logger.hpp"
+#include "utils/tracer.hpp"
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/dnn.hpp>
 #include <opencv2/cudaimgproc.hpp>
 
+#include <algorithm>
+
 namespace glooms {
 namespace vision {
 
@@ -23,11 +27,21 @@ VisionProcessor::~VisionProcessor() {
 
 bool VisionProcessor::initialize() {
     try {
-        // Initialize frame buffer
-        frame_buffer_ = cv::Mat(
-            config_.frame_height,
-            config_.frame_width,
-            CV_8UC3
+        // Initialize frame buffers: enough for every pipeline slot up front,
+        // growing on demand up to buffer_size
+        size_t pool_capacity = static_cast<size_t>(std::max(1, config_.buffer_size));
+        // Frames held by the history are pooled buffers too
+        size_t history_length = static_cast<size_t>(std::max(0, config_.history_length));
+        if (config_.enable_motion_detection) {
+            history_length = std::max<size_t>(history_length, 1);
+            pool_capacity += history_length;
+        }
+        frame_history_.reset(history_length, config_.history_downscale);
+        frame_pool_.setCapacity(pool_capacity);
+        frame_pool_.reserve(
+            cv::Size(config_.frame_width, config_.frame_height),
+            CV_8UC3,
+            std::min(pool_capacity, static_cast<size_t>(std::max(1, config_.pipeline_queue_depth)) + 2)
         );
 
         // Initialize GPU context if available
@@ -49,6 +63,33 @@ bool VisionProcessor::initialize() {
             }
         }
 
+        // Segmentation lookup table, so the first frame doesn't pay for it
+        if (config_.enable_color_segmentation &&
+            !color_lut_.matches(config_.color_lower_bound, config_.color_upper_bound)) {
+            color_lut_.build(config_.color_lower_bound, config_.color_upper_bound);
+        }
+
+        // Inference gating
+        last_detections_.clear();
+        motion_gate_.reset();
+        if (config_.enable_inference_gating) {
+            MotionGateConfig gate_config;
+            gate_config.downscale = config_.gating_downscale;
+            gate_config.block_size = config_.gating_block_size;
+            gate_config.threshold = config_.gating_threshold;
+            gate_config.min_changed_blocks = config_.gating_min_changed_blocks;
+            gate_config.max_skipped_frames = config_.gating_max_skipped_frames;
+            motion_gate_ = std::make_unique<MotionGate>(gate_config);
+        }
+
+        // Adaptive quality
+        quality_controller_.reset();
+        if (config_.processing_mode == ProcessingMode::REALTIME && config_.target_fps > 0) {
+            QualityControllerConfig quality_config;
+            quality_config.target_fps = config_.target_fps;
+            quality_controller_ = std::make_unique<QualityController>(quality_config);
+        }
+
         is_initialized_ = true;
         logger_.info("Vision processor initialized successfully");
         return true;
@@ -60,42 +101,81 @@ bool VisionProcessor::initialize() {
 }
 
 void VisionProcessor::cleanup() {
+    stopPipeline();
     if (gpu_enabled_) {
         gpu_stream_.waitForCompletion();
     }
-    frame_buffer_.release();
+    frame_history_.clear();
+    frame_pool_.clear();
     is_initialized_ = false;
     logger_.info("Vision processor cleanup completed");
 }
 
 ProcessingResult VisionProcessor::processFrame(const cv::Mat& frame) {
+    TRACE_SPAN_CAT("VisionProcessor::processFrame", "vision");
+
     if (!is_initialized_) {
         return ProcessingResult{false, "Processor not initialized"};
     }
 
     try {
-        cv::Mat processed;
         frame_count_++;
+        QualitySettings quality;
+        if (quality_controller_) {
+            if (!quality_controller_->shouldProcess()) {
+                ProcessingResult skipped{true, "Frame skipped", cv::Mat(), {}, frame_count_};
+                skipped.frame_skipped = true;
+                skipped.quality_level = quality_controller_->getLevel();
+                return skipped;
+            }
+            quality = quality_controller_->getSettings();
+        }
+
+        cv::Mat processed = frame_pool_.acquire(frame.size(), CV_8UC3);
+        auto frame_start = std::chrono::steady_clock::now();
 
         // Basic preprocessing
+        auto stage_start = frame_start;
         preprocessFrame(frame, processed);
+        preprocess_stats_.record(std::chrono::steady_clock::now() - stage_start);
+
+        // Gate on the preprocessed frame, before the pipeline rewrites it
+        std::vector<cv::Rect> motion_regions;
+        bool run_inference = shouldRunInference(processed, motion_regions);
 
         // Apply vision processing pipeline
-        applyVisionPipeline(processed);
+        stage_start = std::chrono::steady_clock::now();
+        applyVisionPipeline(processed, quality);
+        vision_stats_.record(std::chrono::steady_clock::now() - stage_start);
 
         // Run neural network inference if model is loaded
         std::vector<cv::Mat> detections;
-        if (!config_.model_path.empty()) {
-            runInference(processed, detections);
+        if (hasInference()) {
+            stage_start = std::chrono::steady_clock::now();
+            runGatedInference(processed, run_inference, detections, quality.input_scale);
+            inference_stats_.record(std::chrono::steady_clock::now() - stage_start);
+        }
+        auto frame_time = std::chrono::steady_clock::now() - frame_start;
+        end_to_end_stats_.record(frame_time);
+        FLIGHT_RECORD(glooms::utils::LogLevel::DEBUG, "Frame {} processed in {} us (quality {}, inference {})",
+                      frame_count_,
+                      std::chrono::duration_cast<std::chrono::microseconds>(frame_time).count(),
+                      quality.level, run_inference);
+        if (quality_controller_) {
+            quality_controller_->recordFrame(frame_time);
         }
 
-        return ProcessingResult{
+        ProcessingResult result{
             true,
             "Frame processed successfully",
             processed,
             detections,
             frame_count_
         };
+        result.quality_level = quality.level;
+        result.inference_skipped = !run_inference;
+        result.motion_regions = std::move(motion_regions);
+        return result;
 
     } catch (const std::exception& e) {
         logger_.error("Frame processing failed: " + std::string(e.what()));
@@ -103,7 +183,239 @@ ProcessingResult VisionProcessor::processFrame(const cv::Mat& frame) {
     }
 }
 
+bool VisionProcessor::submitFrame(const cv::Mat& frame) {
+    if (!is_initialized_ || frame.empty()) {
+        return false;
+    }
+
+    startPipeline();
+
+    PipelineFrame item;
+    item.frame_number = ++frame_count_;
+    item.submitted = std::chrono::steady_clock::now();
+
+    // Skipped frames still travel the queues so results stay in order
+    if (quality_controller_) {
+        item.skipped = !quality_controller_->shouldProcess();
+        item.quality = quality_controller_->getSettings();
+    }
+    if (!item.skipped) {
+        // Callers typically reuse their capture buffer
+        item.frame = frame_pool_.acquire(frame.size(), frame.type());
+        frame.copyTo(item.frame);
+    }
+
+    if (!config_.enable_threading) {
+        // Same API without threads: run the stages inline
+        if (output_queue_->size() >= output_queue_->capacity()) {
+            return false;
+        }
+        executeStage(item, preprocess_stats_, &VisionProcessor::preprocessStage);
+        executeStage(item, vision_stats_, &VisionProcessor::visionStage);
+        executeStage(item, inference_stats_, &VisionProcessor::inferenceStage);
+        frames_in_flight_++;
+        return output_queue_->tryPush(std::move(item));
+    }
+
+    if (!input_queue_->push(std::move(item), pipeline_running_)) {
+        return false;
+    }
+    frames_in_flight_++;
+    return true;
+}
+
+bool VisionProcessor::getResult(ProcessingResult& result, std::chrono::milliseconds timeout) {
+    if (!output_queue_) {
+        return false;
+    }
+
+    PipelineFrame item;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    if (!output_queue_->pop(item, pipeline_running_, deadline)) {
+        return false;
+    }
+    frames_in_flight_--;
+    end_to_end_stats_.record(std::chrono::steady_clock::now() - item.submitted);
+
+    if (item.skipped) {
+        result = ProcessingResult{true, "Frame skipped", cv::Mat(), {}, item.frame_number};
+        result.frame_skipped = true;
+        result.quality_level = item.quality.level;
+    } else if (item.success) {
+        // Stages overlap when threaded, so throughput is set by the slowest
+        if (quality_controller_) {
+            quality_controller_->recordFrame(
+                config_.enable_threading ? item.stage_max : item.stage_total);
+        }
+
+        result = ProcessingResult{
+            true,
+            "Frame processed successfully",
+            item.frame,
+            std::move(item.detections),
+            item.frame_number
+        };
+        result.quality_level = item.quality.level;
+        result.inference_skipped = !item.run_inference;
+        result.motion_regions = std::move(item.motion_regions);
+    } else {
+        result = ProcessingResult{false, item.message, cv::Mat(), {}, item.frame_number};
+    }
+    return true;
+}
+
+void VisionProcessor::startPipeline() {
+    if (pipeline_running_) {
+        return;
+    }
+
+    size_t depth = static_cast<size_t>(std::max(1, config_.pipeline_queue_depth));
+    input_queue_ = std::make_unique<PipelineQueue>(depth);
+    vision_queue_ = std::make_unique<PipelineQueue>(depth);
+    inference_queue_ = std::make_unique<PipelineQueue>(depth);
+    output_queue_ = std::make_unique<PipelineQueue>(depth);
+    pipeline_running_ = true;
+
+    if (!config_.enable_threading) {
+        return;
+    }
+
+    // Keep OpenCV's own parallel loops within the configured budget
+    if (config_.thread_count > 0) {
+        previous_threads_ = cv::getNumThreads();
+        cv::setNumThreads(config_.thread_count);
+    }
+
+    pipeline_threads_.emplace_back(&VisionProcessor::runPipelineStage, this,
+        "vision-preprocess", std::ref(*input_queue_), std::ref(*vision_queue_),
+        std::ref(preprocess_stats_), &VisionProcessor::preprocessStage);
+    pipeline_threads_.emplace_back(&VisionProcessor::runPipelineStage, this,
+        "vision-pipeline", std::ref(*vision_queue_), std::ref(*inference_queue_),
+        std::ref(vision_stats_), &VisionProcessor::visionStage);
+    pipeline_threads_.emplace_back(&VisionProcessor::runPipelineStage, this,
+        "vision-inference", std::ref(*inference_queue_), std::ref(*output_queue_),
+        std::ref(inference_stats_), &VisionProcessor::inferenceStage);
+
+    logger_.info("Vision pipeline started with queue depth " + std::to_string(depth));
+}
+
+void VisionProcessor::stopPipeline() {
+    if (!pipeline_running_) {
+        return;
+    }
+
+    pipeline_running_ = false;
+    for (auto& thread : pipeline_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    pipeline_threads_.clear();
+
+    // The thread count is process-wide; hand it back
+    if (previous_threads_ >= 0) {
+        cv::setNumThreads(previous_threads_);
+        previous_threads_ = -1;
+    }
+
+    // Frames still in flight are dropped
+    input_queue_.reset();
+    vision_queue_.reset();
+    inference_queue_.reset();
+    output_queue_.reset();
+    frames_in_flight_ = 0;
+}
+
+void VisionProcessor::runPipelineStage(
+    const char* name,
+    PipelineQueue& input,
+    PipelineQueue& output,
+    StageStats& stats,
+    StageFn stage
+) {
+    glooms::utils::Tracer::instance().setThreadName(name);
+
+    PipelineFrame item;
+    while (input.pop(item, pipeline_running_)) {
+        executeStage(item, stats, stage);
+        if (!output.push(std::move(item), pipeline_running_)) {
+            break;
+        }
+    }
+}
+
+void VisionProcessor::executeStage(PipelineFrame& item, StageStats& stats, StageFn stage) {
+    // Failed and skipped frames pass through so ordering and accounting
+    // stay intact
+    if (!item.success || item.skipped) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        (this->*stage)(item);
+    } catch (const std::exception& e) {
+        logger_.error("Frame processing failed: " + std::string(e.what()));
+        item.success = false;
+        item.message = "Processing error: " + std::string(e.what());
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.record(elapsed);
+    item.stage_total += elapsed;
+    item.stage_max = std::max(item.stage_max, elapsed);
+}
+
+void VisionProcessor::preprocessStage(PipelineFrame& item) {
+    cv::Mat processed = frame_pool_.acquire(item.frame.size(), CV_8UC3);
+    preprocessFrame(item.frame, processed);
+    item.frame = processed;
+    item.run_inference = shouldRunInference(item.frame, item.motion_regions);
+}
+
+void VisionProcessor::visionStage(PipelineFrame& item) {
+    applyVisionPipeline(item.frame, item.quality);
+}
+
+void VisionProcessor::inferenceStage(PipelineFrame& item) {
+    if (hasInference()) {
+        runGatedInference(item.frame, item.run_inference, item.detections,
+                          item.quality.input_scale);
+    }
+}
+
+bool VisionProcessor::shouldRunInference(const cv::Mat& frame, std::vector<cv::Rect>& motion_regions) {
+    if (!motion_gate_ || !hasInference()) {
+        return true;
+    }
+
+    bool run = motion_gate_->update(frame);
+    motion_regions = motion_gate_->getMotionRegions();
+    return run;
+}
+
+void VisionProcessor::runGatedInference(
+    const cv::Mat& frame,
+    bool run,
+    std::vector<cv::Mat>& detections,
+    float input_scale
+) {
+    // Raw network outputs can't be merged per region, so any motion
+    // re-runs the whole frame
+    if (!run && !last_detections_.empty()) {
+        detections = last_detections_;
+        return;
+    }
+
+    runInference(frame, detections, input_scale);
+    if (motion_gate_) {
+        last_detections_ = detections;
+    }
+}
+
 void VisionProcessor::preprocessFrame(const cv::Mat& input, cv::Mat& output) {
+    TRACE_SPAN_CAT("VisionProcessor::preprocessFrame", "vision");
+
     if (gpu_enabled_) {
         cv::cuda::GpuMat gpu_frame;
         gpu_frame.upload(input, gpu_stream_);
@@ -114,57 +426,93 @@ void VisionProcessor::preprocessFrame(const cv::Mat& input, cv::Mat& output) {
         
         gpu_frame.download(output, gpu_stream_);
         gpu_stream_.waitForCompletion();
+    } else if (input.type() == CV_8UC3 && input.data != output.data) {
+        // Single fused pass, bit-exact with the two-step path below
+        fusedBgrToRgbBlur3x3(input, output);
     } else {
-        cv::cvtColor(input, output, cv::COLOR_BGR2RGB);
-        cv::GaussianBlur(output, output, cv::Size(3, 3), 0);
+        cv::cvtColor(input, rgb_scratch_, cv::COLOR_BGR2RGB);
+        cv::GaussianBlur(rgb_scratch_, output, cv::Size(3, 3), 0);
     }
 }
 
-void VisionProcessor::applyVisionPipeline(cv::Mat& frame) {
+void VisionProcessor::applyVisionPipeline(cv::Mat& frame, const QualitySettings& quality) {
+    TRACE_SPAN_CAT("VisionProcessor::applyVisionPipeline", "vision");
+
     // Edge detection
     if (config_.enable_edge_detection) {
-        cv::Mat edges;
-        cv::Canny(frame, edges, 100, 200);
-        cv::bitwise_and(frame, frame, frame, edges);
+        cv::Canny(frame, edges_scratch_, 100, 200);
+        cv::bitwise_and(frame, frame, frame, edges_scratch_);
     }
 
     // Contour detection
-    if (config_.enable_contour_detection) {
+    if (config_.enable_contour_detection && quality.contours) {
         std::vector<std::vector<cv::Point>> contours;
         cv::findContours(frame, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
         cv::drawContours(frame, contours, -1, cv::Scalar(0, 255, 0), 2);
     }
 
     // Color segmentation
-    if (config_.enable_color_segmentation) {
-        cv::Mat hsv;
-        cv::cvtColor(frame, hsv, cv::COLOR_RGB2HSV);
-        cv::inRange(hsv, config_.color_lower_bound, config_.color_upper_bound, frame);
+    if (config_.enable_color_segmentation && quality.segmentation) {
+        cv::Mat mask = frame_pool_.acquire(frame.size(), CV_8UC1);
+        if (frame.type() == CV_8UC3) {
+            if (!color_lut_.matches(config_.color_lower_bound, config_.color_upper_bound)) {
+                color_lut_.build(config_.color_lower_bound, config_.color_upper_bound);
+            }
+            color_lut_.apply(frame, mask);
+        } else {
+            cv::cvtColor(frame, hsv_scratch_, cv::COLOR_RGB2HSV);
+            cv::inRange(hsv_scratch_, config_.color_lower_bound, config_.color_upper_bound, mask);
+        }
+        frame = mask;
     }
 
-    // Motion detection
-    if (config_.enable_motion_detection && !prev_frame_.empty()) {
-        cv::Mat diff;
-        cv::absdiff(prev_frame_, frame, diff);
-        cv::threshold(diff, diff, 25, 255, cv::THRESH_BINARY);
-        frame = diff;
+    // Motion detection against the previous input to this stage (not the
+    // previous diff). The current frame's buffer moves into the history
+    // and the caller gets the diff, so nothing is copied.
+    if (config_.enable_motion_detection) {
+        if (!frame_history_.empty() && frame_history_.newest().size() == frame.size() &&
+            frame_history_.newest().type() == frame.type()) {
+            cv::Mat diff = frame_pool_.acquire(frame.size(), frame.type());
+            cv::absdiff(frame_history_.newest(), frame, diff);
+            cv::threshold(diff, diff, 25, 255, cv::THRESH_BINARY);
+            frame_history_.push(frame);
+            frame = diff;
+        } else {
+            frame_history_.pushCopy(frame);
+        }
     }
-    frame.copyTo(prev_frame_);
 }
 
-void VisionProcessor::runInference(const cv::Mat& frame, std::vector<cv::Mat>& detections) {
-    // Prepare blob from image
-    cv::Mat blob = cv::dnn::blobFromImage(
+void VisionProcessor::runInference(const cv::Mat& frame, std::vector<cv::Mat>& detections, float input_scale) {
+    TRACE_SPAN_CAT("VisionProcessor::runInference", "vision");
+
+    // Blocks until the shared stage has run this frame's batch. The batch
+    // blob has one fixed size, so input_scale doesn't apply here.
+    if (batch_inference_) {
+        detections = batch_inference_->submit(frame).get();
+        return;
+    }
+
+    // Reduced input sizes stay multiples of 32 for strided detectors
+    cv::Size input_size(config_.model_input_width, config_.model_input_height);
+    if (input_scale < 1.0f) {
+        input_size.width = std::max(32, cvRound(input_size.width * input_scale / 32.0) * 32);
+        input_size.height = std::max(32, cvRound(input_size.height * input_scale / 32.0) * 32);
+    }
+
+    // Prepare blob from image, reusing last frame's buffer
+    cv::dnn::blobFromImage(
         frame,
+        input_blob_,
         1.0,
-        cv::Size(config_.model_input_width, config_.model_input_height),
+        input_size,
         cv::Scalar(127.5, 127.5, 127.5),
         true,
         false
     );
 
     // Run forward pass
-    net_.setInput(blob);
+    net_.setInput(input_blob_);
     detections = net_.forward();
 }
 
@@ -174,10 +522,45 @@ ProcessorMetrics VisionProcessor::getMetrics() const {
         gpu_enabled_,
         config_.frame_width,
         config_.frame_height,
-        static_cast<int>(config_.processing_mode)
+        static_cast<int>(config_.processing_mode),
+        preprocess_stats_.snapshot(),
+        vision_stats_.snapshot(),
+        inference_stats_.snapshot(),
+        end_to_end_stats_.snapshot(),
+        frame_pool_.getStats(),
+        motion_gate_ ? motion_gate_->getSkippedFrames() : 0,
+        quality_controller_ ? quality_controller_->getLevel() : 0,
+        quality_controller_ ? quality_controller_->getAverageCostMs() : 0.0,
+        quality_controller_ ? quality_controller_->getSkippedFrames() : 0
     };
 }
 
+void VisionProcessor::StageStats::record(std::chrono::steady_clock::duration elapsed) {
+    auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    frames.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t current = max_ns.load(std::memory_order_relaxed);
+    while (ns > current &&
+           !max_ns.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+}
+
+StageLatency VisionProcessor::StageStats::snapshot() const {
+    StageLatency latency;
+    latency.frames = frames.load(std::memory_order_relaxed);
+    if (latency.frames > 0) {
+        latency.average_us = total_ns.load(std::memory_order_relaxed) / 1000.0 / latency.frames;
+    }
+    latency.max_us = max_ns.load(std::memory_order_relaxed) / 1000.0;
+    return latency;
+}
+
+void VisionProcessor::setBatchInference(std::shared_ptr<BatchInference> batch_inference) {
+    stopPipeline();
+    batch_inference_ = std::move(batch_inference);
+}
+
 void VisionProcessor::setConfig(const ProcessorConfig& config) {
     config_ = config;
     if (is_initialized_) {
@@ -6,6 +6,17 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "utils/spsc_queue.hpp"
+#include "vision/batch_inference.hpp"
+#include "vision/color_range_lut.hpp"
+#include "vision/frame_history.hpp"
+#include "vision/frame_pool.hpp"
+#include "vision/motion_gate.hpp"
+#include "vision/quality_controller.hpp"
 
 namespace glooms {
 namespace vision {
@@ -29,6 +40,7 @@ struct ProcessorConfig {
 
     // Processing settings
     ProcessingMode processing_mode = ProcessingMode::REALTIME;
+    int target_fps = 30;                // REALTIME trades quality for this rate (0 disables)
     bool enable_edge_detection = false;
     bool enable_contour_detection = false;
     bool enable_color_segmentation = false;
@@ -40,14 +52,26 @@ struct ProcessorConfig {
     int model_input_height = 416;
     float confidence_threshold = 0.5f;
 
+    // Motion-gated inference: skip the network on static frames and reuse
+    // the previous detections
+    bool enable_inference_gating = false;
+    int gating_downscale = 8;
+    int gating_block_size = 8;
+    float gating_threshold = 12.0f;
+    int gating_min_changed_blocks = 1;
+    int gating_max_skipped_frames = 30;
+
     // Color segmentation bounds
     cv::Scalar color_lower_bound;
     cv::Scalar color_upper_bound;
 
     // Advanced settings
-    int buffer_size = 30;
-    bool enable_threading = true;
-    int thread_count = 4;
+    int buffer_size = 30;               // Pooled frame buffers
+    int history_length = 2;             // Recent frames kept for temporal stages
+    int history_downscale = 0;          // Also keep 1/N size copies (0 disables)
+    bool enable_threading = true;       // Run submitFrame() as a threaded pipeline
+    int thread_count = 4;               // OpenCV worker threads shared by the stages
+    int pipeline_queue_depth = 4;       // Frames buffered between pipeline stages
 };
 
 // Processing result struct
@@ -57,6 +81,17 @@ struct ProcessingResult {
     cv::Mat processed_frame;
     std::vector<cv::Mat> detections;
     uint64_t frame_number;
+    bool frame_skipped = false;              // Dropped by the quality controller
+    int quality_level = 0;                   // 0 is full quality
+    bool inference_skipped = false;          // Detections reused from an earlier frame
+    std::vector<cv::Rect> motion_regions;    // Set when inference gating is enabled
+};
+
+// Per-stage latency
+struct StageLatency {
+    uint64_t frames = 0;
+    double average_us = 0.0;
+    double max_us = 0.0;
 };
 
 // Metrics struct
@@ -66,6 +101,15 @@ struct ProcessorMetrics {
     int frame_width;
     int frame_height;
     int processing_mode;
+    StageLatency preprocess;
+    StageLatency vision_pipeline;
+    StageLatency inference;
+    StageLatency end_to_end;
+    FramePoolStats frame_pool;
+    uint64_t inference_skipped;
+    int quality_level;
+    double average_frame_ms;
+    uint64_t frames_skipped;
 };
 
 class VisionProcessor {
@@ -83,6 +127,20 @@ public:
     void cleanup();
     ProcessingResult processFrame(const cv::Mat& frame);
 
+    // Pipelined processing: preprocessing, the classical CV stages and
+    // inference each run on their own thread, connected by bounded SPSC
+    // queues. Results come back in submission order. submitFrame() and
+    // getResult() must each be called from a single thread, and must not
+    // be mixed with concurrent processFrame() calls.
+    bool submitFrame(const cv::Mat& frame);
+    bool getResult(ProcessingResult& result,
+                   std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+    size_t pendingFrames() const { return frames_in_flight_.load(); }
+
+    // Route inference through a batching stage shared with other
+    // processors (one per stream) instead of this processor's own network
+    void setBatchInference(std::shared_ptr<BatchInference> batch_inference);
+
     // Configuration methods
     void setConfig(const ProcessorConfig& config);
     const ProcessorConfig& getConfig() const { return config_; }
@@ -92,6 +150,10 @@ public:
     bool isInitialized() const { return is_initialized_; }
     bool isGPUEnabled() const { return gpu_enabled_; }
 
+    // Recent frames seen by the motion stage. Not synchronized with the
+    // pipeline threads; read it between processFrame() calls.
+    const FrameHistory& getFrameHistory() const { return frame_history_; }
+
     // Utility methods
     static bool isGPUAvailable() {
         return cv::cuda::getCudaEnabledDeviceCount() > 0;
@@ -100,36 +162,107 @@ public:
 protected:
     // Processing pipeline methods
     void preprocessFrame(const cv::Mat& input, cv::Mat& output);
-    void applyVisionPipeline(cv::Mat& frame);
-    void runInference(const cv::Mat& frame, std::vector<cv::Mat>& detections);
+    void applyVisionPipeline(cv::Mat& frame, const QualitySettings& quality = QualitySettings());
+    void runInference(const cv::Mat& frame, std::vector<cv::Mat>& detections, float input_scale = 1.0f);
 
     // Helper methods
     bool validateFrame(const cv::Mat& frame) const;
     void updateMetrics(const ProcessingResult& result);
 
 private:
+    // Work item travelling through the pipeline
+    struct PipelineFrame {
+        cv::Mat frame;
+        std::vector<cv::Mat> detections;
+        uint64_t frame_number = 0;
+        bool run_inference = true;
+        std::vector<cv::Rect> motion_regions;
+        bool skipped = false;
+        QualitySettings quality;
+        std::chrono::steady_clock::duration stage_total{};
+        std::chrono::steady_clock::duration stage_max{};
+        bool success = true;
+        std::string message;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    // Lock-free latency accumulator
+    struct StageStats {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+
+        void record(std::chrono::steady_clock::duration elapsed);
+        StageLatency snapshot() const;
+    };
+
+    using PipelineQueue = glooms::utils::SpscQueue<PipelineFrame>;
+
     // Configuration
     ProcessorConfig config_;
     bool is_initialized_;
     bool gpu_enabled_;
 
     // OpenCV objects
-    cv::Mat frame_buffer_;
-    cv::Mat prev_frame_;
+    FramePool frame_pool_;
+    cv::Mat rgb_scratch_;
+    cv::Mat edges_scratch_;
+    cv::Mat hsv_scratch_;
+    ColorRangeLut color_lut_;           // Segmentation bounds, rebuilt when they change
     cv::dnn::Net net_;
+    cv::Mat input_blob_;                // Refilled in place while the input size holds
     cv::cuda::Stream gpu_stream_;
 
     // Processing state
     uint64_t frame_count_;
-    std::vector<cv::Mat> frame_history_;
+    FrameHistory frame_history_;        // Input of the motion stage, newest first
+
+    // Shared batching stage, if any
+    std::shared_ptr<BatchInference> batch_inference_;
+
+    // Adaptive quality, REALTIME mode only
+    std::unique_ptr<QualityController> quality_controller_;
+
+    // Inference gating
+    std::unique_ptr<MotionGate> motion_gate_;
+    std::vector<cv::Mat> last_detections_;
+
+    // Pipeline state
+    std::atomic<bool> pipeline_running_{false};
+    std::atomic<size_t> frames_in_flight_{0};
+    std::unique_ptr<PipelineQueue> input_queue_;
+    std::unique_ptr<PipelineQueue> vision_queue_;
+    std::unique_ptr<PipelineQueue> inference_queue_;
+    std::unique_ptr<PipelineQueue> output_queue_;
+    std::vector<std::thread> pipeline_threads_;
+    int previous_threads_ = -1;         // OpenCV thread count to restore on stop
+
+    // Stage metrics
+    StageStats preprocess_stats_;
+    StageStats vision_stats_;
+    StageStats inference_stats_;
+    StageStats end_to_end_stats_;
 
     // Utilities
     Logger& logger_;
 
     // Internal helper methods
+    bool hasInference() const { return !config_.model_path.empty() || batch_inference_; }
     void initializeGPU();
     void initializeNetwork();
     void cleanupResources();
+    void startPipeline();
+    void stopPipeline();
+    using StageFn = void (VisionProcessor::*)(PipelineFrame&);
+    void runPipelineStage(const char* name, PipelineQueue& input, PipelineQueue& output,
+                          StageStats& stats, StageFn stage);
+    void executeStage(PipelineFrame& item, StageStats& stats, StageFn stage);
+    void preprocessStage(PipelineFrame& item);
+    void visionStage(PipelineFrame& item);
+    void inferenceStage(PipelineFrame& item);
+    bool shouldRunInference(const cv::Mat& frame, std::vector<cv::Rect>& motion_regions);
+    void runGatedInference(const cv::Mat& frame, bool run, std::vector<cv::Mat>& detections,
+                           float input_scale);
 };
 
 // Factory function
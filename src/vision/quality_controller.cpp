@@ -0,0 +1,124 @@
+#include "vision/quality_controller.hpp"
+
+#include <algorithm>
+
+namespace glooms {
+namespace vision {
+
+QualityController::QualityController(const QualityControllerConfig& config)
+    : config_(config)
+    , level_(0)
+    , average_ms_(0.0)
+    , has_average_(false)
+    , frames_since_change_(0)
+    , restore_hold_(0)
+    , last_change_was_restore_(false)
+    , skip_remaining_(0)
+    , skipped_frames_(0) {
+    config_.target_fps = std::max(1.0, config_.target_fps);
+    config_.min_input_scale = std::clamp(config_.min_input_scale, 0.1f, 1.0f);
+    config_.hold_frames = std::max(1, config_.hold_frames);
+    restore_hold_ = config_.hold_frames;
+
+    // Cheapest savings first: optional stages, then inference resolution
+    // in quarter steps, then dropping frames
+    QualitySettings settings;
+    levels_.push_back(settings);
+
+    settings.contours = false;
+    levels_.push_back(settings);
+
+    settings.segmentation = false;
+    levels_.push_back(settings);
+
+    for (float scale = 0.75f; scale > config_.min_input_scale + 1e-3f; scale -= 0.25f) {
+        settings.input_scale = scale;
+        levels_.push_back(settings);
+    }
+    if (config_.min_input_scale < 1.0f) {
+        settings.input_scale = config_.min_input_scale;
+        levels_.push_back(settings);
+    }
+
+    for (int skip = 1; skip <= config_.max_frame_skip; ++skip) {
+        settings.frame_skip = skip;
+        levels_.push_back(settings);
+    }
+
+    for (size_t i = 0; i < levels_.size(); ++i) {
+        levels_[i].level = static_cast<int>(i);
+    }
+}
+
+bool QualityController::shouldProcess() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (skip_remaining_ > 0) {
+        skip_remaining_--;
+        skipped_frames_++;
+        return false;
+    }
+    skip_remaining_ = levels_[level_].frame_skip;
+    return true;
+}
+
+void QualityController::recordFrame(std::chrono::steady_clock::duration cost) {
+    double cost_ms = std::chrono::duration<double, std::milli>(cost).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_average_) {
+        average_ms_ = cost_ms;
+        has_average_ = true;
+    } else {
+        average_ms_ = config_.smoothing * cost_ms + (1.0 - config_.smoothing) * average_ms_;
+    }
+
+    if (++frames_since_change_ < config_.hold_frames) {
+        return;
+    }
+
+    // Skipped frames are free, so the budget applies per input frame
+    double budget_ms = 1000.0 / config_.target_fps;
+    double per_input_ms = average_ms_ / (levels_[level_].frame_skip + 1);
+
+    if (per_input_ms > budget_ms * config_.degrade_ratio && level_ + 1 < levels_.size()) {
+        // A restore that immediately overshoots backs off further restores
+        if (last_change_was_restore_) {
+            restore_hold_ = std::min(restore_hold_ * 2, config_.hold_frames * 64);
+        }
+        level_++;
+        frames_since_change_ = 0;
+        last_change_was_restore_ = false;
+    } else if (per_input_ms < budget_ms * config_.restore_ratio && level_ > 0 &&
+               frames_since_change_ >= restore_hold_) {
+        level_--;
+        frames_since_change_ = 0;
+        last_change_was_restore_ = true;
+    } else if (last_change_was_restore_ && frames_since_change_ >= config_.hold_frames * 2) {
+        // The last restore held up
+        restore_hold_ = config_.hold_frames;
+        last_change_was_restore_ = false;
+    }
+}
+
+QualitySettings QualityController::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return levels_[level_];
+}
+
+int QualityController::getLevel() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(level_);
+}
+
+double QualityController::getAverageCostMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return average_ms_;
+}
+
+uint64_t QualityController::getSkippedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return skipped_frames_;
+}
+
+} // namespace vision
+} // namespace glooms
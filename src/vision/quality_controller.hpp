@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// What the processor should do for the current quality level
+struct QualitySettings {
+    int level = 0;                  // 0 is full quality
+    float input_scale = 1.0f;       // Multiplier on the model input size
+    int frame_skip = 0;             // Frames dropped after each processed one
+    bool contours = true;
+    bool segmentation = true;
+};
+
+struct QualityControllerConfig {
+    double target_fps = 30.0;
+    double smoothing = 0.2;         // EWMA weight of the newest frame
+    double degrade_ratio = 0.95;    // Degrade above this share of the frame budget
+    double restore_ratio = 0.6;     // Restore below this share of the frame budget
+    int hold_frames = 15;           // Frames to let the average settle after a change
+    float min_input_scale = 0.5f;
+    int max_frame_skip = 2;
+};
+
+// Feedback controller holding a target frame rate. Per-frame cost is
+// smoothed with an EWMA and compared with the frame budget; when over
+// budget it steps down a fixed ladder (contours off, segmentation off,
+// smaller inference input, then frame skipping), and steps back up once
+// there is clear headroom. Thread-safe.
+class QualityController {
+public:
+    explicit QualityController(const QualityControllerConfig& config = QualityControllerConfig());
+
+    // Delete copy constructor and assignment operator
+    QualityController(const QualityController&) = delete;
+    QualityController& operator=(const QualityController&) = delete;
+
+    // Core methods
+    bool shouldProcess();
+    void recordFrame(std::chrono::steady_clock::duration cost);
+    QualitySettings getSettings() const;
+
+    // Metrics
+    int getLevel() const;
+    int getLevelCount() const { return static_cast<int>(levels_.size()); }
+    double getAverageCostMs() const;
+    uint64_t getSkippedFrames() const;
+
+private:
+    QualityControllerConfig config_;
+    std::vector<QualitySettings> levels_;
+
+    mutable std::mutex mutex_;
+    size_t level_;
+    double average_ms_;
+    bool has_average_;
+    int frames_since_change_;
+    int restore_hold_;              // Grows while restores keep overshooting
+    bool last_change_was_restore_;
+    int skip_remaining_;
+    uint64_t skipped_frames_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,67 @@
+#include "vision/rle_mask.hpp"
+
+#include <cstring>
+#include <numeric>
+
+namespace glooms {
+namespace vision {
+
+RleMask RleMask::encode(const cv::Mat& mask) {
+    CV_Assert(mask.type() == CV_8UC1);
+
+    RleMask rle;
+    rle.size_ = mask.size();
+
+    bool set = false;
+    uint32_t run = 0;
+    for (int y = 0; y < mask.rows; ++y) {
+        const uchar* row = mask.ptr<uchar>(y);
+        for (int x = 0; x < mask.cols; ++x) {
+            if ((row[x] != 0) != set) {
+                rle.counts_.push_back(run);
+                set = !set;
+                run = 0;
+            }
+            run++;
+        }
+    }
+    rle.counts_.push_back(run);
+    return rle;
+}
+
+RleMask RleMask::fromCounts(cv::Size size, std::vector<uint32_t> counts) {
+    uint64_t total = std::accumulate(counts.begin(), counts.end(), uint64_t(0));
+    if (counts.empty() || total != static_cast<uint64_t>(size.area())) {
+        return RleMask();
+    }
+    RleMask rle;
+    rle.size_ = size;
+    rle.counts_ = std::move(counts);
+    return rle;
+}
+
+void RleMask::decode(cv::Mat& mask) const {
+    mask.create(size_, CV_8UC1);
+    if (!mask.isContinuous()) {
+        mask = cv::Mat(size_, CV_8UC1);
+    }
+
+    uchar* out = mask.ptr<uchar>();
+    bool set = false;
+    for (uint32_t run : counts_) {
+        std::memset(out, set ? 255 : 0, run);
+        out += run;
+        set = !set;
+    }
+}
+
+size_t RleMask::area() const {
+    size_t total = 0;
+    for (size_t i = 1; i < counts_.size(); i += 2) {
+        total += counts_[i];
+    }
+    return total;
+}
+
+} // namespace vision
+} // namespace glooms
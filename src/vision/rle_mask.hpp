@@ -0,0 +1,36 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace glooms {
+namespace vision {
+
+// Binary mask stored as run lengths in row-major order. Runs alternate
+// between unset and set pixels, starting with a (possibly empty) unset
+// run, so an empty mask of any size is a single count.
+class RleMask {
+public:
+    RleMask() = default;
+
+    // Any single-channel 8-bit mask; nonzero pixels are set
+    static RleMask encode(const cv::Mat& mask);
+    // Fails (returns an empty RleMask) unless the counts cover the size
+    static RleMask fromCounts(cv::Size size, std::vector<uint32_t> counts);
+
+    // CV_8UC1 with set pixels at 255
+    void decode(cv::Mat& mask) const;
+
+    cv::Size size() const { return size_; }
+    const std::vector<uint32_t>& counts() const { return counts_; }
+    size_t area() const;                // Set pixels
+    bool empty() const { return counts_.empty(); }
+
+private:
+    cv::Size size_;
+    std::vector<uint32_t> counts_;
+};
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+// AVX2 kernels are built with per-function target attributes on x86
+// GCC/Clang, so they compile without -mavx2 and are picked at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GLOOMS_HAVE_AVX2_KERNELS 1
+#endif
+
+namespace glooms {
+namespace vision {
+
+// True when the AVX2 kernels are compiled in and the CPU supports them.
+// Callers cache the result; the check isn't free.
+inline bool detectAvx2() {
+#ifdef GLOOMS_HAVE_AVX2_KERNELS
+    return cv::checkHardwareSupport(CV_CPU_AVX2);
+#else
+    return false;
+#endif
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,307 @@
+#include "vision/tracker.hpp"
+#include "utils/tracer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace glooms {
+namespace vision {
+
+void AxisFilter::init(float value, float position_std, float velocity_std) {
+    position = value;
+    velocity = 0.0f;
+    p00 = 4.0f * position_std * position_std;
+    p01 = 0.0f;
+    p11 = 100.0f * velocity_std * velocity_std;
+}
+
+void AxisFilter::predict(float position_std, float velocity_std) {
+    position += velocity;
+    // P = F P F^T + Q with F = [[1, 1], [0, 1]]
+    p00 += 2.0f * p01 + p11 + position_std * position_std;
+    p01 += p11;
+    p11 += velocity_std * velocity_std;
+}
+
+void AxisFilter::update(float value, float measurement_std) {
+    const float s = p00 + measurement_std * measurement_std;
+    const float k0 = p00 / s;
+    const float k1 = p01 / s;
+    const float residual = value - position;
+    position += k0 * residual;
+    velocity += k1 * residual;
+    // P = (I - K H) P
+    p11 -= k1 * p01;
+    p01 *= 1.0f - k0;
+    p00 *= 1.0f - k0;
+}
+
+cv::Rect Track::box() const {
+    float width = std::max(1.0f, w.position);
+    float height = std::max(1.0f, h.position);
+    return cv::Rect(static_cast<int>(std::lround(cx.position - width / 2)),
+                    static_cast<int>(std::lround(cy.position - height / 2)),
+                    static_cast<int>(std::lround(width)),
+                    static_cast<int>(std::lround(height)));
+}
+
+MultiObjectTracker::MultiObjectTracker(const TrackerConfig& config)
+    : config_(config)
+    , next_id_(1) {}
+
+void MultiObjectTracker::predict() {
+    for (auto& track : tracks_) {
+        float width = std::max(1.0f, track.w.position);
+        float height = std::max(1.0f, track.h.position);
+        track.cx.predict(config_.position_noise * width, config_.velocity_noise * width);
+        track.cy.predict(config_.position_noise * height, config_.velocity_noise * height);
+        track.w.predict(config_.position_noise * width, config_.velocity_noise * width);
+        track.h.predict(config_.position_noise * height, config_.velocity_noise * height);
+        track.frames_since_update++;
+    }
+}
+
+TrackerSummary MultiObjectTracker::update(const std::vector<Detection>& detections) {
+    TRACE_SPAN_CAT("MultiObjectTracker::update", "vision");
+    TrackerSummary summary;
+
+    high_.clear();
+    low_.clear();
+    for (size_t i = 0; i < detections.size(); ++i) {
+        float confidence = detections[i].confidence;
+        if (confidence >= config_.high_threshold) {
+            high_.push_back(static_cast<int>(i));
+        } else if (confidence >= config_.low_threshold) {
+            low_.push_back(static_cast<int>(i));
+        }
+    }
+
+    track_matched_.assign(tracks_.size(), 0);
+    detection_matched_.assign(detections.size(), 0);
+    match(detections, high_, config_.match_iou, false, summary);
+    // Low scores are often occluded or blurred objects: let them keep an
+    // established track alive, but never start or confirm a new one
+    match(detections, low_, config_.low_match_iou, true, summary);
+
+    // Unconfirmed tracks get no second chance
+    size_t kept = 0;
+    for (size_t t = 0; t < tracks_.size(); ++t) {
+        Track& track = tracks_[t];
+        if (!track_matched_[t]) {
+            track.missed_updates++;
+        }
+        bool drop = (!track_matched_[t] && !track.confirmed) ||
+                    track.missed_updates > config_.max_missed_updates ||
+                    track.frames_since_update > config_.max_age;
+        if (drop) {
+            summary.lost++;
+            continue;
+        }
+        if (kept != t) {
+            tracks_[kept] = std::move(track);
+        }
+        kept++;
+    }
+    tracks_.resize(kept);
+
+    for (int d : high_) {
+        if (!detection_matched_[d] && detections[d].confidence >= config_.new_track_threshold) {
+            startTrack(detections[d]);
+            summary.births++;
+        }
+    }
+
+    float confidence_sum = 0.0f;
+    for (const auto& track : tracks_) {
+        if (!track.confirmed) {
+            summary.tentative++;
+            continue;
+        }
+        summary.confirmed++;
+        confidence_sum += track.confidence;
+
+        float size = std::max({1.0f, track.w.position, track.h.position});
+        float motion = std::max(std::hypot(track.cx.velocity, track.cy.velocity),
+                                std::max(std::abs(track.w.velocity), std::abs(track.h.velocity))) / size;
+        summary.max_motion = std::max(summary.max_motion, motion);
+    }
+    if (summary.confirmed > 0) {
+        summary.mean_confidence = confidence_sum / summary.confirmed;
+    }
+    return summary;
+}
+
+void MultiObjectTracker::match(
+    const std::vector<Detection>& detections,
+    const std::vector<int>& pool,
+    float min_iou,
+    bool confirmed_only,
+    TrackerSummary& summary
+) {
+    candidates_.clear();
+    for (size_t t = 0; t < tracks_.size(); ++t) {
+        const Track& track = tracks_[t];
+        if (track_matched_[t] || (confirmed_only && !track.confirmed)) {
+            continue;
+        }
+        cv::Rect predicted = track.box();
+        for (int d : pool) {
+            if (detection_matched_[d] ||
+                (config_.class_aware && detections[d].class_id != track.class_id)) {
+                continue;
+            }
+            float iou = Detector::calculateIoU(predicted, detections[d].box);
+            if (iou >= min_iou) {
+                candidates_.push_back(Candidate{iou, static_cast<int>(t), d});
+            }
+        }
+    }
+
+    // Greedy assignment, best overlap first
+    std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.iou != b.iou) {
+            return a.iou > b.iou;
+        }
+        return a.track != b.track ? a.track < b.track : a.detection < b.detection;
+    });
+
+    for (const auto& candidate : candidates_) {
+        if (track_matched_[candidate.track] || detection_matched_[candidate.detection]) {
+            continue;
+        }
+        track_matched_[candidate.track] = 1;
+        detection_matched_[candidate.detection] = 1;
+        correct(tracks_[candidate.track], detections[candidate.detection]);
+        summary.matched++;
+        summary.min_match_iou = std::min(summary.min_match_iou, candidate.iou);
+    }
+}
+
+void MultiObjectTracker::startTrack(const Detection& detection) {
+    const cv::Rect& box = detection.box;
+    float width = std::max(1.0f, static_cast<float>(box.width));
+    float height = std::max(1.0f, static_cast<float>(box.height));
+
+    Track track;
+    track.id = next_id_++;
+    track.class_id = detection.class_id;
+    track.class_name = detection.class_name;
+    track.confidence = detection.confidence;
+    track.cx.init(box.x + width / 2, config_.position_noise * width, config_.velocity_noise * width);
+    track.cy.init(box.y + height / 2, config_.position_noise * height, config_.velocity_noise * height);
+    track.w.init(width, config_.position_noise * width, config_.velocity_noise * width);
+    track.h.init(height, config_.position_noise * height, config_.velocity_noise * height);
+    track.hits = 1;
+    track.missed_updates = 0;
+    track.frames_since_update = 0;
+    track.confirmed = config_.min_hits <= 1;
+    tracks_.push_back(std::move(track));
+}
+
+void MultiObjectTracker::correct(Track& track, const Detection& detection) {
+    const cv::Rect& box = detection.box;
+    float width = std::max(1.0f, static_cast<float>(box.width));
+    float height = std::max(1.0f, static_cast<float>(box.height));
+
+    track.cx.update(box.x + width / 2, config_.position_noise * width);
+    track.cy.update(box.y + height / 2, config_.position_noise * height);
+    track.w.update(width, config_.position_noise * width);
+    track.h.update(height, config_.position_noise * height);
+
+    track.confidence = detection.confidence;
+    track.class_name = detection.class_name;
+    track.hits++;
+    track.missed_updates = 0;
+    track.frames_since_update = 0;
+    if (track.hits >= config_.min_hits) {
+        track.confirmed = true;
+    }
+}
+
+void MultiObjectTracker::reset() {
+    tracks_.clear();
+    next_id_ = 1;
+}
+
+void MultiObjectTracker::getDetections(std::vector<Detection>& detections) const {
+    for (const auto& track : tracks_) {
+        if (!track.confirmed || track.missed_updates > 0) {
+            continue;
+        }
+        Detection det;
+        det.class_id = track.class_id;
+        det.class_name = track.class_name;
+        det.confidence = track.confidence;
+        det.box = track.box();
+        det.track_id = track.id;
+        detections.push_back(std::move(det));
+    }
+}
+
+DetectionCadence::DetectionCadence(const CadenceConfig& config)
+    : config_(config)
+    , interval_(std::max(1, config.min_interval))
+    , countdown_(0) {}
+
+bool DetectionCadence::tick() {
+    if (countdown_ > 0) {
+        countdown_--;
+        return false;
+    }
+    return true;
+}
+
+void DetectionCadence::adapt(const TrackerSummary& summary) {
+    const int min_interval = std::max(1, config_.min_interval);
+    const int max_interval = std::max(min_interval, config_.max_interval);
+
+    bool settled = summary.births == 0 &&
+                   summary.lost == 0 &&
+                   summary.tentative == 0 &&
+                   summary.mean_confidence >= config_.min_confidence &&
+                   summary.min_match_iou >= config_.min_prediction_iou &&
+                   summary.max_motion <= config_.max_motion;
+    interval_ = settled ? std::min(interval_ + 1, max_interval) : min_interval;
+    countdown_ = interval_ - 1;
+}
+
+void DetectionCadence::reset() {
+    interval_ = std::max(1, config_.min_interval);
+    countdown_ = 0;
+}
+
+TrackedDetector::TrackedDetector(Detector& detector, const TrackedDetectorConfig& config)
+    : detector_(detector)
+    , tracker_(config.tracker)
+    , cadence_(config.cadence)
+    , frame_count_(0)
+    , detector_runs_(0) {}
+
+DetectionResult TrackedDetector::process(const cv::Mat& frame) {
+    TRACE_SPAN_CAT("TrackedDetector::process", "vision");
+    frame_count_++;
+    tracker_.predict();
+
+    bool detected = cadence_.tick();
+    if (detected) {
+        DetectionResult result = detector_.detect(frame);
+        if (!result.success) {
+            // Try again on the next frame
+            return result;
+        }
+        detector_runs_++;
+        cadence_.adapt(tracker_.update(result.detections));
+    }
+
+    DetectionResult result{true, detected ? "Detection successful" : "Tracked", {}, frame_count_};
+    tracker_.getDetections(result.detections);
+    return result;
+}
+
+void TrackedDetector::reset() {
+    tracker_.reset();
+    cadence_.reset();
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vision/detector.hpp"
+
+namespace glooms {
+namespace vision {
+
+struct TrackerConfig {
+    // ByteTrack-style association: confident detections are matched
+    // first, then low-confidence ones may only extend confirmed tracks
+    float high_threshold = 0.5f;
+    float low_threshold = 0.1f;
+    float match_iou = 0.3f;             // First pass
+    float low_match_iou = 0.5f;         // Second pass, stricter
+    float new_track_threshold = 0.6f;   // Unmatched detections above this start tracks
+    bool class_aware = true;            // Only match detections of the track's class
+
+    int min_hits = 3;                   // Matches before a track is reported
+    int max_missed_updates = 3;         // Unmatched detector runs before a track is dropped
+    int max_age = 30;                   // Frames without a match before a track is dropped
+
+    // Kalman noise, relative to box size (ByteTrack defaults)
+    float position_noise = 1.0f / 20.0f;
+    float velocity_noise = 1.0f / 160.0f;
+};
+
+// Constant-velocity Kalman filter for one box coordinate. With diagonal
+// noise the 8-state box filter splits into four independent 2-state
+// filters, so this is exact for that model and needs no matrices.
+struct AxisFilter {
+    float position = 0.0f;
+    float velocity = 0.0f;
+    float p00 = 0.0f;                   // Covariance [[p00, p01], [p01, p11]]
+    float p01 = 0.0f;
+    float p11 = 0.0f;
+
+    void init(float value, float position_std, float velocity_std);
+    void predict(float position_std, float velocity_std);
+    void update(float value, float measurement_std);
+};
+
+struct Track {
+    int id;
+    int class_id;
+    std::string class_name;
+    float confidence;                   // Of the last matched detection
+    AxisFilter cx, cy, w, h;
+    int hits;
+    int missed_updates;                 // Consecutive detector runs without a match
+    int frames_since_update;
+    bool confirmed;
+
+    cv::Rect box() const;
+};
+
+// What the last update did, for deciding when to run the detector again
+struct TrackerSummary {
+    size_t matched = 0;
+    size_t births = 0;                  // New tentative tracks
+    size_t lost = 0;                    // Tracks dropped
+    size_t confirmed = 0;
+    size_t tentative = 0;
+    float mean_confidence = 1.0f;       // Over confirmed tracks; 1 when there are none
+    float max_motion = 0.0f;            // Fastest confirmed track, in box sizes per frame
+    float min_match_iou = 1.0f;         // Worst overlap of a prediction with its detection
+};
+
+// SORT/ByteTrack-style multi-object tracker. predict() advances every
+// track by one frame; update() associates a detector run with the
+// predicted boxes by greedy IoU matching. Between detector runs the
+// predicted boxes stand in for detections. Not thread-safe.
+class MultiObjectTracker {
+public:
+    explicit MultiObjectTracker(const TrackerConfig& config = TrackerConfig());
+
+    // Core methods
+    void predict();
+    TrackerSummary update(const std::vector<Detection>& detections);
+    void reset();
+
+    // Confirmed tracks matched by the last detector run, as detections
+    // carrying their track id and current box
+    void getDetections(std::vector<Detection>& detections) const;
+
+    // Configuration and status
+    void setConfig(const TrackerConfig& config) { config_ = config; }
+    const TrackerConfig& getConfig() const { return config_; }
+    const std::vector<Track>& getTracks() const { return tracks_; }
+
+private:
+    struct Candidate {
+        float iou;
+        int track;
+        int detection;
+    };
+
+    void match(const std::vector<Detection>& detections, const std::vector<int>& pool,
+               float min_iou, bool confirmed_only, TrackerSummary& summary);
+    void startTrack(const Detection& detection);
+    void correct(Track& track, const Detection& detection);
+
+    TrackerConfig config_;
+    std::vector<Track> tracks_;
+    int next_id_;
+
+    // Association scratch
+    std::vector<int> high_;
+    std::vector<int> low_;
+    std::vector<uint8_t> track_matched_;
+    std::vector<uint8_t> detection_matched_;
+    std::vector<Candidate> candidates_;
+};
+
+struct CadenceConfig {
+    int min_interval = 1;               // Frames between detector runs when unsettled
+    int max_interval = 5;
+    float min_confidence = 0.5f;        // Mean track confidence needed to back off
+    float min_prediction_iou = 0.7f;    // Predictions must have matched at least this well
+    float max_motion = 0.1f;            // Box sizes per frame above which to speed up
+};
+
+// Decides which frames run the detector. The interval grows by one frame
+// after every settled detector run (no births or losses, confident
+// tracks whose predicted boxes matched well, nothing too fast) and drops
+// straight back to the minimum otherwise.
+class DetectionCadence {
+public:
+    explicit DetectionCadence(const CadenceConfig& config = CadenceConfig());
+
+    // Call once per frame; true when this frame should run the detector
+    bool tick();
+    void adapt(const TrackerSummary& summary);
+    void reset();
+
+    int getInterval() const { return interval_; }
+
+private:
+    CadenceConfig config_;
+    int interval_;
+    int countdown_;
+};
+
+struct TrackedDetectorConfig {
+    TrackerConfig tracker;
+    CadenceConfig cadence;
+};
+
+// Runs a Detector at an adaptive cadence and tracks between runs. For the
+// low-confidence association pass the detector's confidence threshold
+// should be at or below tracker.low_threshold.
+class TrackedDetector {
+public:
+    explicit TrackedDetector(Detector& detector, const TrackedDetectorConfig& config = TrackedDetectorConfig());
+
+    DetectionResult process(const cv::Mat& frame);
+    void reset();
+
+    // Metrics
+    uint64_t getFrameCount() const { return frame_count_; }
+    uint64_t getDetectorRuns() const { return detector_runs_; }
+    const MultiObjectTracker& getTracker() const { return tracker_; }
+    const DetectionCadence& getCadence() const { return cadence_; }
+
+private:
+    Detector& detector_;
+    MultiObjectTracker tracker_;
+    DetectionCadence cadence_;
+    uint64_t frame_count_;
+    uint64_t detector_runs_;
+};
+
+} // namespace vision
+} // namespace glooms
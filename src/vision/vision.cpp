@@ -0,0 +1,113 @@
+#include "glooms/vision.hpp"
+#include "vision/frame_decoder.hpp"
+#include "utils/tracer.hpp"
+
+namespace glooms {
+namespace vision {
+
+VisionResult Vision::processVideo(const std::string& video_path) {
+    FrameDecoder decoder(makeDecoderConfig());
+    if (!decoder.open(video_path)) {
+        return VisionResult{false, "Failed to open video: " + video_path};
+    }
+    return processStream(decoder);
+}
+
+VisionResult Vision::processCamera(int camera_id) {
+    FrameDecoder decoder(makeDecoderConfig());
+    if (!decoder.open(camera_id)) {
+        return VisionResult{false, "Failed to open camera: " + std::to_string(camera_id)};
+    }
+    return processStream(decoder);
+}
+
+FrameDecoderConfig Vision::makeDecoderConfig() const {
+    FrameDecoderConfig decoder_config;
+    decoder_config.queue_depth = config_.decode_queue_depth;
+    decoder_config.drop_policy = config_.frame_drop_policy;
+    decoder_config.keep_every_nth = config_.keep_every_nth;
+
+    // Lossless replays run as fast as processing allows; otherwise files
+    // are released at target_fps so drops only happen when processing
+    // can't keep up
+    if (config_.frame_drop_policy != FrameDropPolicy::NONE) {
+        decoder_config.pace_fps = config_.target_fps;
+    }
+    return decoder_config;
+}
+
+VisionResult Vision::processStream(FrameDecoder& decoder) {
+    TRACE_SPAN_CAT("Vision::processStream", "vision");
+
+    if (!is_initialized_) {
+        return VisionResult{false, "Vision not initialized"};
+    }
+    if (!decoder.start()) {
+        return VisionResult{false, "Failed to start frame decoder"};
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        should_stop_ = false;
+    }
+    is_running_ = true;
+
+    // Decoding of the next frames overlaps with processing of this one
+    VisionResult last_result{true, ""};
+    DecodedFrame decoded;
+    uint64_t processed = 0;
+    uint64_t failed = 0;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (should_stop_) {
+                break;
+            }
+        }
+
+        if (!decoder.next(decoded)) {
+            if (decoder.isFinished()) {
+                break;
+            }
+            continue;  // Live source stalled
+        }
+
+        VisionResult result = processFrame(decoded.image);
+        if (!result.success) {
+            failed++;
+            if (error_callback_) {
+                error_callback_(result.message);
+            }
+            continue;
+        }
+
+        processed++;
+        if (frame_callback_) {
+            frame_callback_(result.frame);
+        }
+        last_result = std::move(result);
+    }
+
+    decoded.image.release();
+    decoder.stop();
+    is_running_ = false;
+
+    decoder_stats_ = std::make_unique<FrameDecoderStats>(decoder.getStats());
+    last_result.success = failed == 0 || processed > 0;
+    last_result.message = "Processed " + std::to_string(processed) + " frames (" +
+                          std::to_string(decoder_stats_->dropped) + " dropped, " +
+                          std::to_string(failed) + " failed), decoder CPU " +
+                          std::to_string(decoder_stats_->decode_cpu_ms) + " ms";
+    return last_result;
+}
+
+bool Vision::getDecoderStats(FrameDecoderStats& stats) const {
+    if (!decoder_stats_) {
+        return false;
+    }
+    stats = *decoder_stats_;
+    return true;
+}
+
+} // namespace vision
+} // namespace glooms
@@ -0,0 +1,218 @@
+#include "vision/detector.hpp"
+#include "vision/int8_quantization.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds the INT8 detector exactly as Detector would on a CUDA-less host,
+// then checks it against the FP32 model on a folder of sample frames:
+//   gloom_calibrate_int8 --model model.onnx --classes model.names --images frames/
+//       [--calibration-images calib/] [--calibration-frames 32] [--eval-frames 0]
+//       [--per-channel] [--iou 0.5] [--max-drift 0.02] [--output int8_report.yml]
+// A model.int8.onnx next to the model is evaluated when present; otherwise
+// the FP32 model is calibrated on the first --calibration-frames images of
+// --calibration-images, or of --images when no separate folder is given.
+// Calibration frames are never evaluated: with a shared folder they are
+// held out and the rest are evaluated. The FP32 detections serve as ground
+// truth for mAP, and the report records the split and the per-tensor
+// input/output scales with the drift and speedup. Exits 1 when the drift
+// exceeds --max-drift.
+
+using namespace glooms::vision;
+
+namespace {
+
+struct Options {
+    std::string model;
+    std::string classes;
+    std::string images;
+    std::string calibration_images;     // Defaults to the leading frames of images
+    std::string output = "int8_report.yml";
+    int calibration_frames = 32;
+    int eval_frames = 0;                // 0 for every frame left after calibration
+    bool per_channel = false;
+    float iou = 0.5f;
+    float max_drift = 0.02f;
+};
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--per-channel") {
+            options.per_channel = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        if (arg == "--model") {
+            options.model = argv[++i];
+        } else if (arg == "--classes") {
+            options.classes = argv[++i];
+        } else if (arg == "--images") {
+            options.images = argv[++i];
+        } else if (arg == "--calibration-images") {
+            options.calibration_images = argv[++i];
+        } else if (arg == "--output") {
+            options.output = argv[++i];
+        } else if (arg == "--calibration-frames") {
+            options.calibration_frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--eval-frames") {
+            options.eval_frames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--iou") {
+            options.iou = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--max-drift") {
+            options.max_drift = static_cast<float>(std::atof(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return !options.model.empty() && !options.classes.empty() && !options.images.empty();
+}
+
+// Runs the detector over every image, returning the mean time per frame
+double evaluate(Detector& detector, const std::vector<cv::Mat>& images,
+                std::vector<std::vector<Detection>>& detections) {
+    // Warm up so one-time layer setup isn't timed
+    detector.detect(images.front());
+
+    double total_ms = 0.0;
+    detections.clear();
+    for (const auto& image : images) {
+        auto start = std::chrono::steady_clock::now();
+        DetectionResult result = detector.detect(image);
+        auto end = std::chrono::steady_clock::now();
+        total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+        detections.push_back(std::move(result.detections));
+    }
+    return total_ms / images.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " --model model.onnx --classes model.names --images frames/"
+                  << " [--calibration-images calib/] [--calibration-frames N]"
+                  << " [--eval-frames N] [--per-channel]"
+                  << " [--iou 0.5] [--max-drift 0.02] [--output int8_report.yml]\n";
+        return 2;
+    }
+
+    // Detector calibrates on the first frames of its calibration folder in
+    // sorted order; when that is the evaluation folder, skip those frames
+    std::string quantized_model = int8ModelPath(options.model);
+    bool prequantized = std::ifstream(quantized_model).good();
+    const std::string calibration_dir =
+        options.calibration_images.empty() ? options.images : options.calibration_images;
+    size_t calibration_count = 0;
+    if (!prequantized) {
+        calibration_count = listImages(calibration_dir, static_cast<size_t>(options.calibration_frames)).size();
+    }
+    size_t eval_offset = options.calibration_images.empty() ? calibration_count : 0;
+
+    auto paths = listImages(options.images);
+    paths.erase(paths.begin(), paths.begin() + std::min(eval_offset, paths.size()));
+    if (options.eval_frames > 0 && paths.size() > static_cast<size_t>(options.eval_frames)) {
+        paths.resize(static_cast<size_t>(options.eval_frames));
+    }
+
+    std::vector<cv::Mat> images;
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+        if (!image.empty()) {
+            images.push_back(image);
+        }
+    }
+    if (images.empty()) {
+        std::cerr << "No readable images in " << options.images;
+        if (eval_offset > 0) {
+            std::cerr << " after the " << eval_offset << " calibration frames;"
+                      << " add frames or pass --calibration-images";
+        }
+        std::cerr << "\n";
+        return 1;
+    }
+
+    DetectorConfig config;
+    config.model_weights = options.model;
+    config.classes_file = options.classes;
+    config.use_gpu = false;
+
+    DetectorConfig fp32_config = config;
+    fp32_config.enable_int8 = false;
+
+    DetectorConfig int8_config = config;
+    int8_config.enable_int8 = true;
+    int8_config.int8_calibration_dir = calibration_dir;
+    int8_config.int8_calibration_frames = options.calibration_frames;
+    int8_config.int8_per_channel = options.per_channel;
+
+    Detector fp32(fp32_config);
+    Detector int8(int8_config);
+    if (!fp32.isInitialized() || !int8.isInitialized()) {
+        std::cerr << "Failed to load model: " << options.model << "\n";
+        return 1;
+    }
+    if (!int8.isInt8Enabled()) {
+        std::cerr << "No INT8 model available: no " << int8ModelPath(options.model)
+                  << (isQuantizationSupported() ? " and calibration failed\n"
+                                                : " and this OpenCV cannot quantize\n");
+        return 1;
+    }
+
+    std::vector<std::vector<Detection>> fp32_detections;
+    std::vector<std::vector<Detection>> int8_detections;
+    double fp32_ms = evaluate(fp32, images, fp32_detections);
+    double int8_ms = evaluate(int8, images, int8_detections);
+
+    float map = meanAveragePrecision(fp32_detections, int8_detections, options.iou);
+    float drift = 1.0f - map;
+    bool passed = drift <= options.max_drift;
+
+    QuantizationDetails details;
+    int8.getQuantizationDetails(details);
+
+    cv::FileStorage report(options.output, cv::FileStorage::WRITE);
+    if (!report.isOpened()) {
+        std::cerr << "Failed to open output file: " << options.output << "\n";
+        return 1;
+    }
+    report << "model" << options.model;
+    report << "int8_source" << (prequantized ? quantized_model : std::string("calibration"));
+    report << "calibration_images" << (prequantized ? std::string() : calibration_dir);
+    report << "calibration_frames" << static_cast<int>(calibration_count);
+    report << "per_channel" << options.per_channel;
+    report << "input_scales" << details.input_scales;
+    report << "input_zeropoints" << details.input_zeropoints;
+    report << "output_scales" << details.output_scales;
+    report << "output_zeropoints" << details.output_zeropoints;
+    report << "eval_images" << options.images;
+    report << "eval_offset" << static_cast<int>(eval_offset);    // Leading frames held out for calibration
+    report << "eval_frames" << static_cast<int>(images.size());
+    report << "fp32_ms" << fp32_ms;
+    report << "int8_ms" << int8_ms;
+    report << "speedup" << fp32_ms / int8_ms;
+    report << "iou_threshold" << options.iou;
+    report << "map" << map;
+    report << "drift" << drift;
+    report << "passed" << passed;
+    report.release();
+
+    std::cout << "FP32 " << fp32_ms << " ms, INT8 " << int8_ms << " ms ("
+              << fp32_ms / int8_ms << "x)\n"
+              << "mAP@" << options.iou << " vs FP32: " << map
+              << " (drift " << drift << ", limit " << options.max_drift << ")\n"
+              << "Wrote " << options.output << "\n";
+    return passed ? 0 : 1;
+}
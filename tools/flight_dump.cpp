@@ -0,0 +1,18 @@
+#include "utils/flight_recorder.hpp"
+
+#include <iostream>
+
+// Prints the contents of a flight recorder file, oldest record first:
+//   gloom_flight_dump /dev/shm/gloom-flight-<pid>
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <flight recorder file>\n";
+        return 2;
+    }
+
+    if (!glooms::utils::FlightRecorder::dump(argv[1], std::cout)) {
+        std::cerr << "Failed to read flight recorder file: " << argv[1] << "\n";
+        return 1;
+    }
+    return 0;
+}